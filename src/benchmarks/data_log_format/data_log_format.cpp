@@ -0,0 +1,111 @@
+/*
+ * Host benchmark: size of the JSON vs. the packed (base64) data log format and
+ * check that the packed records decode to exactly the values of the JSON records
+ * make host/benchmarks/data_log_format && _host/data_log_format
+ */
+#include "application.h"
+#include "LoggerController.h"
+#include "LoggerData.h"
+#include "LoggerEncoding.h"
+
+#define SAMPLES   10000
+#define DATA_LOG_OVERHEAD_JSON    70 // {"id":"name","dt":"2026-01-01 00:00:00 GMT","d":[...]}
+
+static uint32_t seed = 42;
+static double uniform() {
+  seed = seed * 1664525 + 1013904223;
+  return (seed >> 8) / (double) (1 << 24);
+}
+
+/*** benchmark ***/
+
+struct Channel {
+  const char* key;
+  const char* units;
+  int decimals;
+  double center;
+  double spread;
+};
+
+static void benchmark(const char* name, Channel* channels, int n_channels, bool summary = false) {
+  std::vector<LoggerData> data;
+  for (int i = 0; i < n_channels; i++) {
+    data.push_back(LoggerData(i + 1, channels[i].key, channels[i].units, channels[i].decimals));
+    if (summary) data.back().enableSummary(50, 10, 90);
+  }
+  size_t json_bytes = 0, packed_bytes = 0, records = 0, mismatches = 0;
+  uint8_t packed[DATA_PACKED_MAX_BYTES];
+  char encoded[DATA_PACKED_MAX_BYTES * 2];
+  uint8_t decoded[DATA_PACKED_MAX_BYTES];
+  char json[DATA_TEXT_MAX_CHAR];
+  char rendered[DATA_TEXT_MAX_CHAR];
+  for (int s = 0; s < SAMPLES; s++) {
+    host::advanceMillis(1000);
+    for (int i = 0; i < n_channels; i++) {
+      LoggerData& d = data[i];
+      d.clear();
+      int n = 1 + (s % 10);
+      for (int j = 0; j < n; j++) {
+        d.setNewestDataTime(millis() - (unsigned long) (uniform() * 5000));
+        d.setNewestValue(channels[i].center + channels[i].spread * (uniform() - 0.5));
+        d.saveNewestValue(true);
+      }
+      d.assembleLog(json, sizeof(json), true);
+      size_t size = d.assemblePackedLog(packed, sizeof(packed), true);
+      json_bytes += strlen(json) + 1; // + separator
+      packed_bytes += size;
+      records++;
+
+      // round trip through base64 (keys and units come from the data schema)
+      encodeBase64(encoded, sizeof(encoded), packed, size);
+      size_t decoded_size = decodeBase64(decoded, sizeof(decoded), encoded, strlen(encoded));
+      size_t pos = 0;
+      LoggerDataRecord record;
+      bool valid = record.parsePackedLog(decoded, decoded_size, pos);
+      strcpy(record.variable, d.getVariable());
+      strcpy(record.units, d.getUnits());
+      if (!valid || record.assembleLog(rendered, sizeof(rendered)) == 0 || strcmp(rendered, json) != 0 || pos != size) {
+        if (mismatches++ < 3) printf("  mismatch: %s vs %s\n", json, rendered);
+      }
+    }
+  }
+  double json_per = (double) json_bytes / records;
+  double packed_per = (double) getBase64Length(packed_bytes) / records;
+  int json_per_log = (DATA_LOG_MAX_CHAR - 1 - DATA_LOG_OVERHEAD_JSON) / json_per;
+  int packed_per_log = (DATA_LOG_PACKED_MAX_BYTES * records) / packed_bytes;
+  printf("%-28s %10.1f %10.1f %10.1f %10.1f %10d %10d %9.1fx %10lu\n", name,
+    json_per, (double) packed_bytes / records, packed_per, json_per / packed_per,
+    json_per_log, packed_per_log, (double) packed_per_log / json_per_log, (unsigned long) mismatches);
+}
+
+int main(int argc, char** argv) {
+  host::setQuiet(true);
+  host::advanceMillis(10000); // data times up to 5s in the past have to be valid
+  printf("data log format benchmark: %d logs per data set, data with 1-10 averaged values and time offsets\n\n", SAMPLES);
+  printf("%-28s %10s %10s %10s %10s %10s %10s %10s %10s\n", "data", "json [B]", "packed [B]", "base64 [B]",
+    "ratio", "json/log", "packed/log", "gain", "mismatch");
+
+  Channel mfc[] = {
+    {"P", "barA", 2, 1.013, 0.01},
+    {"T", "DegC", 2, 25.0, 0.2},
+    {"flow", "Sml/m", 3, 50.0, 1.0},
+    {"flow", "Sml/m", 3, 50.0, 1.0},
+    {"setpoint", "Sml/m", 3, 50.0, 0.0}
+  };
+  benchmark("alicat mfc (5 channels)", mfc, 5);
+
+  Channel temperature[] = { {"T", "DegC", 2, 21.5, 0.5} };
+  benchmark("temperature", temperature, 1);
+  benchmark("temperature + summary", temperature, 1, true);
+
+  Channel od[] = { {"beam", "", 0, 1800, 100}, {"ref", "", 0, 2000, 100}, {"OD", "", 4, 0.35, 0.2} };
+  benchmark("optical density", od, 3);
+
+  Channel scale[] = { {"weight", "g", 2, 1234.5, 800}, {"rate", "g/min", 3, -2.5, 5} };
+  benchmark("scale", scale, 2);
+
+  printf("\njson/base64 = bytes per data record in the log (and the RAM queue), ratio = json / base64,\n"
+    "json/log and packed/log = data records per 622 byte publish, gain = data records per publish packed vs. json,\n"
+    "mismatch = packed records that do not decode to the same values as the json record\n");
+  return 0;
+}
@@ -0,0 +1,404 @@
+/*
+ * Host benchmark: capacity, heap fragmentation and speed of the data log queue,
+ * preallocated LoggerLogQueue ring buffer vs. the previous std::vector<std::string>,
+ * plus a randomized check of the queue against a std::deque model and the accuracy of merged data logs
+ * make host/benchmarks/log_queue && _host/log_queue
+ * (with sanitizers: make host/benchmarks/log_queue HOST_CXXFLAGS="-std=gnu++14 -O1 -g -Wall \$(HOST_WARNINGS) -fsanitize=address,undefined"
+ * and ASAN_OPTIONS=detect_leaks=0 as the queue buffers are never freed, as on the device)
+ */
+#include "application.h"
+#include "LoggerController.h"
+#include "LoggerLogQueue.h"
+#include "LoggerData.h"
+#include <string>
+#include <vector>
+#include <deque>
+
+#define HEAP_SIZE       50000 // typical free memory on a Photon running a logger
+#define MEMORY_RESERVE  5000 // same as LoggerController::memory_reserve
+#define CYCLES          500 // flaky connection cycles (partial publish, then new logs)
+#define TIMING_OPS      200000
+#define MODEL_OPS       1000000
+#define MODEL_CAPACITY  4000 // small so the queue wraps around often
+#define MERGE_LOGS      1024 // data logs merged into one (binary counter as LoggerController::mergeQueuedDataLogs)
+#define MERGE_VALUES    30 // values per data log
+#define MERGE_RUNS      200
+
+static uint32_t seed = 42;
+static uint32_t random(uint32_t max) {
+  seed = seed * 1664525 + 1013904223;
+  return (seed >> 8) % max;
+}
+
+// data log of random length (typical logs are 150 - 620 characters)
+static void makeDataLog(char* target) {
+  int length = 150 + random(DATA_LOG_MAX_CHAR - 150);
+  int n = snprintf(target, DATA_LOG_MAX_CHAR, "{\"id\":\"bench\",\"dt\":\"2026-01-01 00:00:00 GMT\",\"d\":[");
+  while (n < length - 3) target[n++] = 'a' + random(26);
+  strcpy(target + n, "]}");
+}
+
+// other activity between logs: the transient Strings of a Time.format call
+static void otherActivity() {
+  String timestamp = Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z");
+}
+
+static uint64_t wallNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct Result {
+  size_t first_fill = 0; // logs queued during an outage starting from an empty heap
+  size_t min_fill = 0; // fewest logs that fit after the flaky connection cycles
+  size_t max_fill = 0;
+  uint32_t free_memory = 0; // after the cycles, queue full
+  uint32_t largest_free = 0;
+  uint32_t failures = 0; // allocations that would have failed on the device
+  double push_ns = 0;
+  double pop_ns = 0;
+};
+
+static void printResult(const char* name, Result& r) {
+  printf("%-28s %8u %8u %8u %10lu %10lu %8.1f%% %9lu %9.1f %9.1f\n", name,
+    (unsigned) r.first_fill, (unsigned) r.min_fill, (unsigned) r.max_fill,
+    (unsigned long) r.free_memory, (unsigned long) r.largest_free,
+    r.free_memory > 0 ? 100.0 * (1.0 - (double) r.largest_free / r.free_memory) : 0.0,
+    (unsigned long) r.failures, r.push_ns, r.pop_ns);
+}
+
+/*** std::vector<std::string> (previous implementation) ***/
+
+static Result benchVector() {
+  Result r;
+  char log[DATA_LOG_MAX_CHAR];
+  uint32_t failures = host::heapFailures();
+  std::vector<std::string>* stack = new std::vector<std::string>();
+
+  // fill like queueDataLog did: push while free memory is above the reserve
+  auto fill = [&]() {
+    size_t n = 0;
+    while (System.freeMemory() >= MEMORY_RESERVE) {
+      makeDataLog(log);
+      otherActivity();
+      stack->push_back(log);
+      n++;
+    }
+    return n;
+  };
+  r.first_fill = stack->size() + fill();
+  r.min_fill = r.first_fill;
+
+  // flaky connection: publish some of the latest logs, then queue until full again
+  for (int i = 0; i < CYCLES; i++) {
+    size_t publish = 1 + random(stack->size());
+    for (size_t j = 0; j < publish; j++) stack->pop_back();
+    fill();
+    if (stack->size() < r.min_fill) r.min_fill = stack->size();
+    if (stack->size() > r.max_fill) r.max_fill = stack->size();
+  }
+  r.free_memory = System.freeMemory();
+  r.largest_free = host::heapLargestFree();
+  r.failures = host::heapFailures() - failures;
+
+  // speed at half capacity
+  while (stack->size() > r.first_fill / 2) stack->pop_back();
+  makeDataLog(log);
+  uint64_t push = 0, pop = 0;
+  for (int i = 0; i < TIMING_OPS; i++) {
+    uint64_t start = wallNanos();
+    stack->push_back(log);
+    uint64_t middle = wallNanos();
+    stack->pop_back();
+    pop += wallNanos() - middle;
+    push += middle - start;
+  }
+  r.push_ns = (double) push / TIMING_OPS;
+  r.pop_ns = (double) pop / TIMING_OPS;
+  delete stack;
+  return r;
+}
+
+/*** LoggerLogQueue ***/
+
+static Result benchQueue() {
+  Result r;
+  char log[DATA_LOG_MAX_CHAR];
+  uint32_t failures = host::heapFailures();
+  LoggerLogQueue* queue = new LoggerLogQueue();
+  queue->init(System.freeMemory() - MEMORY_RESERVE);
+
+  // fill like queueDataLog does: push until the queue is full
+  auto fill = [&]() {
+    size_t n = 0;
+    while (true) {
+      makeDataLog(log);
+      otherActivity();
+      if (!queue->push(log)) break;
+      n++;
+    }
+    return n;
+  };
+  r.first_fill = fill();
+  r.min_fill = r.first_fill;
+
+  for (int i = 0; i < CYCLES; i++) {
+    size_t publish = 1 + random(queue->size());
+    for (size_t j = 0; j < publish; j++) queue->popBack();
+    fill();
+    if (queue->size() < r.min_fill) r.min_fill = queue->size();
+    if (queue->size() > r.max_fill) r.max_fill = queue->size();
+  }
+  r.free_memory = System.freeMemory();
+  r.largest_free = host::heapLargestFree();
+  r.failures = host::heapFailures() - failures;
+
+  while (queue->size() > r.first_fill / 2) queue->popBack();
+  makeDataLog(log);
+  uint64_t push = 0, pop = 0;
+  for (int i = 0; i < TIMING_OPS; i++) {
+    uint64_t start = wallNanos();
+    queue->push(log);
+    uint64_t middle = wallNanos();
+    queue->popBack();
+    pop += wallNanos() - middle;
+    push += middle - start;
+  }
+  r.push_ns = (double) push / TIMING_OPS;
+  r.pop_ns = (double) pop / TIMING_OPS;
+  delete queue;
+  return r;
+}
+
+/*** model check ***/
+
+// every operation on the queue is mirrored on a std::deque and the whole queue is compared after each operation
+struct ModelLog {
+  std::string log;
+  uint32_t ref;
+};
+
+static size_t model_mismatches = 0;
+
+static void modelMismatch(const char* what, size_t op) {
+  if (model_mismatches++ < 10) printf("  mismatch after operation %lu: %s\n", (unsigned long) op, what);
+}
+
+static void compareModel(LoggerLogQueue& queue, std::deque<ModelLog>& model, size_t op) {
+  if (queue.size() != model.size()) return(modelMismatch("size", op));
+  if (queue.empty() != model.empty()) return(modelMismatch("empty", op));
+  if (model.empty()) {
+    if (queue.front() != NULL || queue.back() != NULL) modelMismatch("front/back of empty queue", op);
+    return;
+  }
+  // oldest to newest
+  const char* log = queue.front();
+  for (size_t i = 0; i < model.size(); i++, log = queue.after(log)) {
+    if (log == NULL || model[i].log != log || queue.getRef(log) != model[i].ref) return(modelMismatch("forward traversal", op));
+  }
+  if (log != NULL) return(modelMismatch("forward traversal end", op));
+  // newest to oldest
+  log = queue.back();
+  for (size_t i = model.size(); i > 0; i--, log = queue.before(log)) {
+    if (log == NULL || model[i - 1].log != log) return(modelMismatch("backward traversal", op));
+  }
+  if (log != NULL) return(modelMismatch("backward traversal end", op));
+  if (queue.getFrontRef() != model.front().ref || queue.getBackRef() != model.back().ref) modelMismatch("front/back ref", op);
+}
+
+static void makeModelLog(char* target, size_t length, size_t id) {
+  int n = snprintf(target, length + 1, "%lu:", (unsigned long) id);
+  for (size_t i = n; i < length; i++) target[i] = 'a' + random(26);
+  target[length] = 0;
+}
+
+static void modelCheck() {
+  LoggerLogQueue queue;
+  queue.init(MODEL_CAPACITY);
+  std::deque<ModelLog> model;
+  char log[DATA_LOG_MAX_CHAR + 1];
+  size_t pushes = 0, full = 0, pops = 0, replaced = 0, refused = 0;
+
+  for (size_t op = 0; op < MODEL_OPS; op++) {
+    uint32_t action = random(100);
+    if (action < 45) {
+      // push a log of random length (queue might be full)
+      size_t length = 10 + random((random(4) == 0) ? DATA_LOG_MAX_CHAR - 10 : 200);
+      uint32_t ref = (random(2) == 0) ? LOG_QUEUE_NO_REF : random(100000);
+      makeModelLog(log, length, op);
+      bool fits = queue.fits(length);
+      bool pushed = queue.push(log, ref);
+      if (pushed != fits) modelMismatch("push vs. fits", op);
+      if (pushed) {
+        model.push_back({log, ref});
+        pushes++;
+      } else {
+        full++;
+      }
+    } else if (action < 60) {
+      if (!model.empty()) {
+        queue.popFront();
+        model.pop_front();
+        pops++;
+      }
+    } else if (action < 75) {
+      if (!model.empty()) {
+        queue.popBack();
+        model.pop_back();
+        pops++;
+      }
+    } else if (action < 99) {
+      // replace a random pair of neighbours with a log that is at most as long as the pair (as a merged data log)
+      if (model.size() < 2) continue;
+      size_t i = random(model.size() - 1);
+      const char* older = queue.front();
+      for (size_t j = 0; j < i; j++) older = queue.after(older);
+      size_t max = model[i].log.size() + model[i + 1].log.size() + LOG_QUEUE_RECORD_OVERHEAD;
+      size_t length = 1 + random(max < DATA_LOG_MAX_CHAR ? max : DATA_LOG_MAX_CHAR);
+      uint32_t ref = random(100000);
+      unsigned long time = random(1000000);
+      makeModelLog(log, length, op);
+      if (queue.replacePair(older, log, ref, time)) {
+        model.erase(model.begin() + i + 1);
+        model[i] = {log, ref};
+        const char* replacement = queue.front();
+        for (size_t j = 0; j < i; j++) replacement = queue.after(replacement);
+        if (queue.getTime(replacement) != time) modelMismatch("replacement time", op);
+        replaced++;
+      } else {
+        // only allowed if the replacement is longer than the older log and the pair wraps around the end of the buffer
+        if (length <= model[i].log.size()) modelMismatch("replacement refused", op);
+        refused++;
+      }
+    } else {
+      queue.clear();
+      model.clear();
+    }
+    compareModel(queue, model, op);
+  }
+
+  printf("\nmodel check: %d operations vs. std::deque (%lu pushes, %lu full, %lu pops, %lu pair replacements, %lu refused), %lu mismatches\n",
+    MODEL_OPS, (unsigned long) pushes, (unsigned long) full, (unsigned long) pops, (unsigned long) replaced, (unsigned long) refused,
+    (unsigned long) model_mismatches);
+}
+
+/*** merge accuracy ***/
+
+// data logs are merged from their logged text (rounded to the data's decimals), the error of the merged mean and
+// standard deviation vs. the exact statistics of all values grows by at most half a unit of the last decimal per merge
+// level, i.e. it is bounded by (log2(ml) + 1) / 2 units for a log that stands for ml original logs
+
+struct MergeLog {
+  char text[200];
+  int ml; // number of original logs
+  RunningStats exact; // all values of the original logs
+};
+
+static double merge_max_mean_units = 0, merge_max_sigma_units = 0;
+static size_t merge_out_of_bound = 0;
+
+static void parseMergeLog(MergeLog& log, LoggerDataRecord& record, bool packed) {
+  if (packed) {
+    size_t pos = 0;
+    record.parsePackedLog((const uint8_t*) log.text + 1, (uint8_t) log.text[0], pos);
+  } else {
+    record.parseLog(log.text, log.text + strlen(log.text));
+  }
+}
+
+static void assembleMergeLog(MergeLog& log, LoggerDataRecord& record, bool packed) {
+  if (packed) {
+    log.text[0] = (char) record.assemblePackedLog((uint8_t*) log.text + 1, sizeof(log.text) - 1);
+  } else {
+    record.assembleLog(log.text, sizeof(log.text));
+  }
+}
+
+static void mergeAccuracy(bool packed, int decimals, double center, double spread) {
+  double unit = pow(10.0, -decimals);
+  double max_mean_units = 0, max_sigma_units = 0;
+  for (int run = 0; run < MERGE_RUNS; run++) {
+    std::vector<MergeLog> logs;
+    for (int i = 0; i < MERGE_LOGS; i++) {
+      // new data log (slowly drifting values)
+      LoggerData data(1, "T", "C", decimals);
+      MergeLog log;
+      log.ml = 1;
+      double drift = center + spread * (random(1000) / 1000.0 - 0.5);
+      for (int j = 0; j < MERGE_VALUES; j++) {
+        double value = drift + spread * 0.01 * ((random(1000) / 1000.0) - 0.5);
+        data.setNewestValue(value);
+        data.setNewestDataTime(j * 1000);
+        data.saveNewestValue(true);
+        log.exact.add(value);
+      }
+      if (packed) {
+        log.text[0] = (char) data.assemblePackedLog((uint8_t*) log.text + 1, sizeof(log.text) - 1, false, MERGE_VALUES * 1000);
+      } else {
+        data.assembleLog(log.text, sizeof(log.text), false, MERGE_VALUES * 1000);
+      }
+      logs.push_back(log);
+
+      // merge neighbours that stand for the same number of logs (newest pair first, as the queue fills up)
+      while (logs.size() >= 2 && logs[logs.size() - 1].ml == logs[logs.size() - 2].ml) {
+        MergeLog& older = logs[logs.size() - 2];
+        MergeLog& newer = logs[logs.size() - 1];
+        LoggerDataRecord older_record, newer_record;
+        parseMergeLog(older, older_record, packed);
+        parseMergeLog(newer, newer_record, packed);
+        newer_record.merge(older_record, 0);
+        older.ml += newer.ml;
+        older.exact.merge(newer.exact);
+        assembleMergeLog(older, newer_record, packed);
+        logs.pop_back();
+      }
+    }
+
+    // all merged into one log
+    LoggerDataRecord record;
+    parseMergeLog(logs[0], record, packed);
+    double mean_units = fabs(record.value.getMean() - logs[0].exact.getMean()) / unit;
+    double sigma_units = fabs(record.value.getStdDev() - logs[0].exact.getStdDev()) / unit;
+    double bound = (log2(logs[0].ml) + 1) / 2;
+    if (record.value.getN() != logs[0].exact.getN() || mean_units > bound || sigma_units > bound) merge_out_of_bound++;
+    if (mean_units > max_mean_units) max_mean_units = mean_units;
+    if (sigma_units > max_sigma_units) max_sigma_units = sigma_units;
+  }
+  printf("%-8s %9d %12.2f %12.2f %12.2f\n", packed ? "packed" : "json", decimals, max_mean_units, max_sigma_units,
+    (log2(MERGE_LOGS) + 1) / 2);
+  if (max_mean_units > merge_max_mean_units) merge_max_mean_units = max_mean_units;
+  if (max_sigma_units > merge_max_sigma_units) merge_max_sigma_units = max_sigma_units;
+}
+
+/*** main ***/
+
+int main(int argc, char** argv) {
+  host::setQuiet(true);
+  host::setHeapSize(HEAP_SIZE + host::heapUsed());
+  printf("data log queue benchmark: %d bytes heap, %d bytes reserve, %d flaky connection cycles\n\n",
+    HEAP_SIZE, MEMORY_RESERVE, CYCLES);
+  printf("%-28s %8s %8s %8s %10s %10s %9s %9s %9s %9s\n", "implementation", "fill", "min", "max",
+    "free [B]", "block [B]", "frag", "failed", "push [ns]", "pop [ns]");
+  Result vector = benchVector();
+  printResult("std::vector<std::string>", vector);
+  Result queue = benchQueue();
+  printResult("LoggerLogQueue", queue);
+  printf("\nfill = logs queued during an outage from an empty queue, min/max = logs queued after each cycle,\n"
+    "free/block = free memory and largest free block with the queue full, frag = 1 - block/free,\n"
+    "failed = allocations that would fail on the device (out of memory crash)\n");
+
+  // the checks are not limited to the device heap
+  host::setHeapSize(10000000 + host::heapUsed());
+  modelCheck();
+
+  printf("\nmerge accuracy: %d data logs of %d values merged into one, %d runs each, max error in units of the last decimal\n",
+    MERGE_LOGS, MERGE_VALUES, MERGE_RUNS);
+  printf("%-8s %9s %12s %12s %12s\n", "format", "decimals", "mean", "sigma", "bound");
+  mergeAccuracy(false, 2, 25, 4);
+  mergeAccuracy(false, 0, 400, 100);
+  mergeAccuracy(true, 2, 25, 4);
+  mergeAccuracy(true, 4, 0.35, 0.2);
+  printf("%lu merged logs outside the bound\n", (unsigned long) merge_out_of_bound);
+  return(model_mismatches > 0 || merge_out_of_bound > 0);
+}
@@ -0,0 +1,96 @@
+/*
+ * Host check: time spent in LoggerLogSpool::append() and the drain (nextLog(), markNextLogPublished()) while bursts of logs
+ * fill up the spool, wrap around and drain (the next sector is erased ahead of time by update() in the pauses between logs
+ * and writes during the erase are deferred, previously every sector switch erased inline), and that all spooled logs are
+ * drained in order, also after recovering the spool with init()
+ * make host/benchmarks/log_spool && _host/log_spool
+ */
+#include "application.h"
+#include "LoggerLogSpool.h"
+
+#define SECTORS         8 // small so the spool wraps around often
+#define LOOPS           3000000 // 1 ms each
+#define BURST_GAP       2000 // max ms between bursts of logs
+#define BURST_LOGS      3 // max logs per burst (e.g. state and data logs in the same loop)
+#define DRAIN_SWITCH    300000 // ms offline, then ms online
+#define LOG_LENGTH      180
+#define SLOW_CALL       5000 // us, more than a page program, less than a sector erase
+
+static uint32_t seed = 42;
+static uint32_t random(uint32_t max) {
+  seed = seed * 1664525 + 1013904223;
+  return (seed >> 8) % max;
+}
+
+static void makeLog(char* log, uint32_t number) {
+  int n = snprintf(log, LOG_LENGTH + 1, "{\"n\":%lu,\"v\":\"", (unsigned long) number);
+  for (; n < LOG_LENGTH - 2; n++) log[n] = 'a' + (number + n) % 26;
+  snprintf(log + n, 3, "\"}");
+}
+
+static uint32_t logNumber(const char* log) {
+  return(strtoul(log + 5, NULL, 10));
+}
+
+int main(int argc, char** argv) {
+  host::setQuiet(true);
+  LoggerLogSpool spool(&SPI1, D5, 0, SECTORS);
+  if (!spool.init()) {
+    printf("no spool\n");
+    return(1);
+  }
+
+  char log[LOG_LENGTH + 1];
+  char drained[LOG_LENGTH + 1];
+  uint8_t type;
+  uint32_t appended = 0, spooled = 0, next_drained = 0, drained_n = 0, out_of_order = 0, slow = 0;
+  uint64_t max_append = 0, total_append = 0, max_drain = 0;
+  uint32_t next_burst = 0, sector_switches = 0;
+  bool draining = false;
+
+  for (uint32_t loop = 0; loop < LOOPS; loop++) {
+    host::advanceMillis(1);
+    spool.update();
+
+    for (int i = (loop == next_burst) ? 1 + random(BURST_LOGS) : 0; i > 0; i--) {
+      makeLog(log, appended++);
+      uint64_t start = host::virtualMicros();
+      uint32_t address = spool.append(LOG_SPOOL_DATA_LOG, log, false);
+      uint64_t time = host::virtualMicros() - start;
+      total_append += time;
+      if (time > max_append) max_append = time;
+      if (time > SLOW_CALL) slow++;
+      if (address != LOG_SPOOL_NO_RECORD) spooled++;
+      if (address % LOG_SPOOL_SECTOR_SIZE == sizeof(LoggerLogSpoolSector)) sector_switches++;
+    }
+    if (loop == next_burst) next_burst = loop + 1 + random(BURST_GAP);
+
+    // alternating offline (spool fills up and wraps around onto pending logs) and online stretches (drain)
+    if (loop % DRAIN_SWITCH == 0) draining = !draining;
+    if (draining && random(3) == 0) {
+      uint64_t start = host::virtualMicros();
+      if (spool.nextLog(drained, sizeof(drained), &type)) {
+        uint32_t number = logNumber(drained);
+        if (number < next_drained) out_of_order++;
+        next_drained = number + 1;
+        spool.markNextLogPublished();
+        drained_n++;
+      }
+      uint64_t time = host::virtualMicros() - start;
+      if (time > max_drain) max_drain = time;
+      if (time > SLOW_CALL) slow++;
+    }
+
+    // recover from the flash as after a restart
+    if (loop == LOOPS / 2) spool.init();
+  }
+
+  printf("log spool check: %lu sectors, %lu logs appended, %lu spooled, %lu dropped while full, %lu drained\n",
+    (unsigned long) SECTORS, (unsigned long) appended, (unsigned long) spooled, (unsigned long) spool.getDropped(), (unsigned long) drained_n);
+  printf("append: mean %.0f us, max %lu us, drain: max %lu us, %lu calls over %d us (a sector erase takes 45000 us), %lu sector switches\n",
+    (double) total_append / appended, (unsigned long) max_append, (unsigned long) max_drain, (unsigned long) slow, SLOW_CALL,
+    (unsigned long) sector_switches);
+  uint32_t lost = spooled - drained_n - spool.getPending();
+  printf("%lu logs drained out of order, %lu spooled logs lost\n", (unsigned long) out_of_order, (unsigned long) lost);
+  return(slow > 0 || out_of_order > 0 || lost > 0);
+}
@@ -0,0 +1,122 @@
+/*
+ * Host benchmark: speed of print_to_decimals (integer digits) vs. the previous pow() + snprintf("%.Nf")
+ * implementation and check that both produce exactly the same text
+ * make host/benchmarks/number_format && _host/number_format
+ * (the host has an FPU, on the Photon's Cortex-M3 the difference of the double formatting is much larger)
+ */
+#include "application.h"
+#include "LoggerMath.h"
+#include "LoggerUtils.h"
+
+#define TIMING_VALUES     200000
+#define MIN_DECIMALS      -4
+#define MAX_DECIMALS      10
+
+static uint64_t seed = 42;
+static uint64_t random64() {
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return seed;
+}
+
+static double uniform() {
+  return (random64() >> 11) / (double) (1ULL << 53);
+}
+
+static uint64_t wallNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*** previous implementation ***/
+
+static void print_to_decimals_snprintf (char* target, int size, double number, int decimals) {
+    double rounded_number = round_to_decimals(number, decimals);
+    if (decimals < 0) decimals = 0;
+    char number_pattern[6];
+    snprintf(number_pattern, sizeof(number_pattern), "%%.%df", decimals);
+    snprintf(target, size, number_pattern, rounded_number);
+}
+
+/*** equivalence ***/
+
+static size_t checks = 0, mismatches = 0;
+
+static void check(double number, int decimals, int size = 20) {
+  char expected[40], actual[40];
+  print_to_decimals_snprintf(expected, size, number, decimals);
+  print_to_decimals(actual, size, number, decimals);
+  checks++;
+  if (strcmp(expected, actual) != 0 && mismatches++ < 10) {
+    printf("  mismatch: %.17g to %d decimals (size %d): '%s' vs '%s'\n", number, decimals, size, expected, actual);
+  }
+}
+
+static void equivalence() {
+  // every value on the decimal grid (and halfway between) around 0 for each number of decimals
+  for (int decimals = MIN_DECIMALS; decimals <= MAX_DECIMALS; decimals++) {
+    double step = pow(10.0, -decimals - 1);
+    for (int64_t i = -200000; i <= 200000; i++) {
+      check(i * step, decimals);
+      check(i * step + step / 2, decimals);
+    }
+  }
+  // random values of all magnitudes (incl. the fallback range)
+  for (int i = 0; i < 2000000; i++) {
+    double number = (uniform() - 0.5) * pow(10.0, (int) (uniform() * 36) - 12);
+    check(number, MIN_DECIMALS + (int) (uniform() * (MAX_DECIMALS - MIN_DECIMALS + 1)));
+  }
+  // special values and truncation
+  double specials[] = {0.0, -0.0, NAN, -NAN, INFINITY, -INFINITY, 1e15, -1e15, 999999999999999.5, 1e300, -1e-300, 0.5, -0.5, 1.005, 2.675};
+  for (double number : specials) {
+    for (int decimals = -20; decimals <= 20; decimals++) check(number, decimals, 40);
+  }
+  for (int size = 1; size <= 12; size++) {
+    check(-1234.5678, 3, size);
+    check(1234.5678, -2, size);
+  }
+}
+
+/*** timing ***/
+
+static double timeFormat(void (*format)(char*, int, double, int), double* values, int* decimals) {
+  char text[20];
+  size_t sum = 0;
+  uint64_t start = wallNanos();
+  for (int i = 0; i < TIMING_VALUES; i++) {
+    format(text, sizeof(text), values[i], decimals[i]);
+    sum += text[0];
+  }
+  uint64_t ns = wallNanos() - start;
+  if (sum == 0) printf(" "); // keep the loop
+  return((double) ns / TIMING_VALUES);
+}
+
+static void timing(const char* name, double center, double spread, int min_decimals, int max_decimals) {
+  static double values[TIMING_VALUES];
+  static int decimals[TIMING_VALUES];
+  for (int i = 0; i < TIMING_VALUES; i++) {
+    values[i] = center + spread * (uniform() - 0.5);
+    decimals[i] = min_decimals + (int) (uniform() * (max_decimals - min_decimals + 1));
+  }
+  double before = timeFormat(print_to_decimals_snprintf, values, decimals);
+  double after = timeFormat(print_to_decimals, values, decimals);
+  printf("%-28s %14.1f %14.1f %9.1fx\n", name, before, after, before / after);
+}
+
+int main(int argc, char** argv) {
+  host::setQuiet(true);
+
+  printf("number format benchmark: print_to_decimals, %d values each\n\n", TIMING_VALUES);
+  printf("%-28s %14s %14s %10s\n", "values", "snprintf [ns]", "integer [ns]", "speedup");
+  timing("temperature (2 decimals)", 21.5, 5, 2, 2);
+  timing("flow (3 decimals)", 50, 100, 3, 3);
+  timing("signal (0 decimals)", 1800, 1000, 0, 0);
+  timing("OD (4 decimals)", 0.35, 0.5, 4, 4);
+  timing("mixed (-2 to 6 decimals)", 0, 1e5, -2, 6);
+
+  equivalence();
+  printf("\nequivalence: %lu values checked against the snprintf implementation, %lu mismatches\n",
+    (unsigned long) checks, (unsigned long) mismatches);
+  return(mismatches > 0);
+}
@@ -0,0 +1,169 @@
+/*
+ * Host benchmark: speed of the one pass DecimalParser vs. the previous strtod + strlen + strcspn parsing of serial
+ * values in LoggerData::setNewestValue and fuzz check that the parser gives exactly the value and end that strtod gives
+ * make host/benchmarks/number_parse && _host/number_parse
+ * (the host has an FPU and a fast strtod, on the Photon newlib's strtod is considerably slower)
+ */
+#include "application.h"
+#include "LoggerMath.h"
+
+#define TIMING_VALUES     200000
+#define FUZZ_TEXTS        2000000
+
+static uint64_t seed = 42;
+static uint64_t random64() {
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return seed;
+}
+
+static double uniform() {
+  return (random64() >> 11) / (double) (1ULL << 53);
+}
+
+static uint64_t wallNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*** previous implementation ***/
+
+// strict parsing with inferred decimals as LoggerData::setNewestValue did it
+static bool parse_strtod(char* val, double& value, int& decimals) {
+  char* double_end;
+  value = strtod (val, &double_end);
+  int converted = double_end - val;
+  int remaining = strlen(val) - converted;
+  if (converted == 0) return(false);
+  for (int i = 0; i < remaining; i++) {
+    if (!isspace(val[converted+i])) return(false);
+  }
+  decimals = strlen(val) - strcspn(val, ".") - 1 - remaining;
+  return(true);
+}
+
+static bool parse_decimal_parser(char* val, double& value, int& decimals) {
+  DecimalParser parser;
+  for (char* c = val; *c != 0; c++) parser.add(*c);
+  if (!parser.isValid(true)) return(false);
+  value = parser.getValue();
+  decimals = parser.getDecimals();
+  return(true);
+}
+
+/*** equivalence ***/
+
+static size_t checks = 0, numbers = 0, mismatches = 0;
+
+static void check(const char* text) {
+  char* end;
+  double expected = strtod(text, &end);
+  int expected_length = end - text;
+  DecimalParser parser;
+  for (const char* c = text; *c != 0; c++) parser.add(*c);
+  double actual = parser.getValue();
+  int actual_length = parser.getLength();
+  checks++;
+  if (expected_length > 0) numbers++;
+  bool same_value = expected_length == 0 || memcmp(&expected, &actual, sizeof(double)) == 0;
+  if ((expected_length != actual_length || !same_value) && mismatches++ < 10) {
+    printf("  mismatch: '%s': %.17g (%d chars) vs %.17g (%d chars)\n", text, expected, expected_length, actual, actual_length);
+  }
+}
+
+// random texts of number characters (no hex, inf or nan which are not numbers for the parser)
+static void fuzz() {
+  const char chars[] = "0123456789012345678901234567890123456789+-..eE  x";
+  char text[40];
+  for (int i = 0; i < FUZZ_TEXTS; i++) {
+    int length = 1 + (int) (uniform() * 30);
+    for (int j = 0; j < length; j++) text[j] = chars[(int) (uniform() * (sizeof(chars) - 1))];
+    text[length] = 0;
+    if (strstr(text, "0x") != NULL) continue; // hex (strtod) vs 0 (parser)
+    check(text);
+  }
+}
+
+// well formed numbers of all magnitudes and digit counts (incl. the strtod fallback and halfway cases)
+static void numbers_check() {
+  char text[60];
+  for (int i = 0; i < FUZZ_TEXTS; i++) {
+    int digits = 1 + (int) (uniform() * 20);
+    int point = (int) (uniform() * (digits + 1));
+    int pos = 0;
+    if (uniform() < 0.3) text[pos++] = ' ';
+    if (uniform() < 0.5) text[pos++] = (uniform() < 0.5) ? '-' : '+';
+    for (int j = 0; j < digits; j++) {
+      if (j == point) text[pos++] = '.';
+      text[pos++] = '0' + (int) (uniform() * 10);
+    }
+    if (uniform() < 0.2) pos += snprintf(text + pos, sizeof(text) - pos, "e%d", (int) (uniform() * 700) - 350);
+    text[pos] = 0;
+    check(text);
+  }
+  // printed doubles round trip
+  for (int i = 0; i < FUZZ_TEXTS; i++) {
+    double number = (uniform() - 0.5) * pow(10.0, (int) (uniform() * 40) - 20);
+    snprintf(text, sizeof(text), "%.*f", (int) (uniform() * 12), number);
+    check(text);
+    snprintf(text, sizeof(text), "%.17g", number);
+    check(text);
+  }
+  const char* specials[] = {"", " ", "+", "-", ".", "-.", "+.5", "5.", "-0", "-0.000", "1e", "1e+", "1e-5x", "1.e3", ".e3",
+    "00000000000000000000000000001", "9007199254740993", "1e22", "1e23", "4.9e-324", "2.2250738585072014e-308",
+    "1.7976931348623157e308", "1e309", "  +014.70", "+000.00 ", "1 2", "12\t", "\t\n 3.25"};
+  for (const char* special : specials) check(special);
+}
+
+/*** timing ***/
+
+static double timeParse(bool (*parse)(char*, double&, int&), char (*texts)[20]) {
+  double value, sum = 0;
+  int decimals;
+  uint64_t start = wallNanos();
+  for (int i = 0; i < TIMING_VALUES; i++) {
+    if (parse(texts[i], value, decimals)) sum += value + decimals;
+  }
+  uint64_t ns = wallNanos() - start;
+  if (sum == 0) printf(" "); // keep the loop
+  return((double) ns / TIMING_VALUES);
+}
+
+static void timing(const char* name, double center, double spread, int decimals, bool sign) {
+  static char texts[TIMING_VALUES][20];
+  for (int i = 0; i < TIMING_VALUES; i++) {
+    double number = center + spread * (uniform() - 0.5);
+    (sign) ?
+      snprintf(texts[i], sizeof(texts[i]), "%+0*.*f", 5 + decimals, decimals, number) : // e.g. +014.70
+      snprintf(texts[i], sizeof(texts[i]), "%.*f", decimals, number);
+  }
+  double before = timeParse(parse_strtod, texts);
+  double after = timeParse(parse_decimal_parser, texts);
+  // the parsers must agree on these (the previous decimals of integers were -1 instead of 0)
+  size_t differences = 0;
+  for (int i = 0; i < TIMING_VALUES; i++) {
+    double v1, v2;
+    int d1, d2;
+    bool ok1 = parse_strtod(texts[i], v1, d1), ok2 = parse_decimal_parser(texts[i], v2, d2);
+    if (ok1 != ok2 || v1 != v2 || (d1 != d2 && strchr(texts[i], '.') != NULL)) differences++;
+  }
+  printf("%-28s %14.1f %14.1f %9.1fx %12lu\n", name, before, after, before / after, (unsigned long) differences);
+  mismatches += differences;
+}
+
+int main(int argc, char** argv) {
+  host::setQuiet(true);
+
+  printf("number parse benchmark: strict parsing with decimals, %d values each\n\n", TIMING_VALUES);
+  printf("%-28s %14s %14s %10s %12s\n", "values", "strtod [ns]", "parser [ns]", "speedup", "differences");
+  timing("alicat (+014.70)", 15, 30, 2, true);
+  timing("scale (2 decimals)", 120, 200, 2, false);
+  timing("stirrer (0 decimals)", 400, 600, 0, false);
+  timing("OD (4 decimals)", 0.35, 0.5, 4, false);
+
+  fuzz();
+  numbers_check();
+  printf("\nequivalence: %lu texts (%lu numbers) checked against strtod, %lu mismatches\n",
+    (unsigned long) checks, (unsigned long) numbers, (unsigned long) mismatches);
+  return(mismatches > 0);
+}
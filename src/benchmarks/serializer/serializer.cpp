@@ -0,0 +1,204 @@
+/*
+ * Host benchmark: speed of the compile-time layout serializers behind the getInfo functions vs. snprintf
+ * with the same PATTERN_* formats and check that both produce exactly the same text
+ * make host/benchmarks/serializer && _host/serializer
+ */
+#include "application.h"
+#include "LoggerUtils.h"
+
+#define TIMING_CALLS      500000
+#define CHECK_CALLS       20000
+
+static uint64_t seed = 42;
+static uint64_t random64() {
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return seed;
+}
+
+static double uniform() {
+  return (random64() >> 11) / (double) (1ULL << 53);
+}
+
+static uint64_t wallNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*** patterns ***/
+
+struct Pattern {
+  const char* name;
+  const char* pattern;
+};
+
+#define BENCHMARK_PATTERN(name) {#name, PATTERN_##name}
+
+static Pattern patterns[] = {
+  BENCHMARK_PATTERN(IKVSUNT_JSON), BENCHMARK_PATTERN(IKVSUN_JSON), BENCHMARK_PATTERN(IKVSUN_SIMPLE),
+  BENCHMARK_PATTERN(KVSUNT_JSON), BENCHMARK_PATTERN(KVSUN_JSON), BENCHMARK_PATTERN(KVSUN_SIMPLE),
+  BENCHMARK_PATTERN(IKVUNT_JSON), BENCHMARK_PATTERN(IKVUN_JSON), BENCHMARK_PATTERN(IKVUN_SIMPLE),
+  BENCHMARK_PATTERN(KVUNT_JSON), BENCHMARK_PATTERN(KVUN_JSON), BENCHMARK_PATTERN(KVUN_JSON_QUOTED), BENCHMARK_PATTERN(KVUN_SIMPLE),
+  BENCHMARK_PATTERN(IKVU_JSON), BENCHMARK_PATTERN(IKVU_JSON_QUOTED), BENCHMARK_PATTERN(IKVU_SIMPLE),
+  BENCHMARK_PATTERN(KVU_JSON), BENCHMARK_PATTERN(KVU_JSON_QUOTED), BENCHMARK_PATTERN(KVU_SIMPLE),
+  BENCHMARK_PATTERN(IKV_JSON), BENCHMARK_PATTERN(IKV_JSON_QUOTED), BENCHMARK_PATTERN(IKV_SIMPLE),
+  BENCHMARK_PATTERN(IKU_JSON),
+  BENCHMARK_PATTERN(KV_JSON), BENCHMARK_PATTERN(KV_JSON_QUOTED), BENCHMARK_PATTERN(KV_SIMPLE),
+  BENCHMARK_PATTERN(VUN_SIMPLE), BENCHMARK_PATTERN(VU_SIMPLE), BENCHMARK_PATTERN(V_SIMPLE)
+};
+
+#define N_PATTERNS (sizeof(patterns) / sizeof(patterns[0]))
+
+/*** random fields ***/
+
+struct Fields {
+  int idx;
+  char key[20];
+  char value[25];
+  char sigma[25];
+  char units[10];
+  int n;
+  unsigned long time_offset;
+};
+
+static const char* keys[] = {"T", "flow", "setpoint", "OD", "weight", "", "a-very-long-key"};
+static const char* units[] = {"DegC", "Sml/m", "g", "", "barA"};
+
+static void randomFields(Fields& f) {
+  int ints[] = {0, 1, -1, 9, 10, 2147483647, -2147483647 - 1};
+  f.idx = uniform() < 0.2 ? ints[(int) (uniform() * 7)] : (int) (uniform() * 20) - 2;
+  f.n = uniform() < 0.2 ? ints[(int) (uniform() * 7)] : (int) (uniform() * 1000);
+  f.time_offset = uniform() < 0.1 ? 4294967295UL : (unsigned long) (uniform() * 1e6);
+  strcpy(f.key, keys[(int) (uniform() * 7)]);
+  strcpy(f.units, units[(int) (uniform() * 5)]);
+  print_to_decimals(f.value, sizeof(f.value), (uniform() - 0.5) * 1e4, (int) (uniform() * 6));
+  print_to_decimals(f.sigma, sizeof(f.sigma), uniform() * 10, (int) (uniform() * 6));
+}
+
+/*** equivalence ***/
+
+// each getInfo function with the patterns whose conversions its arguments fit (vs. snprintf with the same arguments)
+#define TYPES(...) __VA_ARGS__
+#define CHECK_INFO(function, types, ...) \
+  if (isPatternCompatible<TYPES types>(pattern)) { \
+    getInfo##function(actual, size, __VA_ARGS__, pattern); \
+    snprintf(expected, size, pattern, __VA_ARGS__); \
+    check(#function, name, size, expected, actual); \
+    checked = true; \
+  }
+
+static size_t checks = 0, mismatches = 0;
+
+static void check(const char* function, const char* name, int size, const char* expected, const char* actual) {
+  checks++;
+  if (strcmp(expected, actual) != 0 && mismatches++ < 10) {
+    printf("  mismatch: %s with %s (size %d): '%s' vs '%s'\n", function, name, size, expected, actual);
+  }
+}
+
+static void equivalence() {
+  char expected[200], actual[200];
+  for (int i = 0; i < CHECK_CALLS; i++) {
+    Fields f;
+    randomFields(f);
+    // mostly full size, sometimes truncated
+    int size = uniform() < 0.8 ? sizeof(actual) : 1 + (int) (uniform() * 60);
+    for (size_t p = 0; p < N_PATTERNS; p++) {
+      const char* name = patterns[p].name;
+      // every other round with a copy of the pattern (matched by text instead of by pointer)
+      char copy[100];
+      strcpy(copy, patterns[p].pattern);
+      const char* pattern = i % 2 == 0 ? patterns[p].pattern : copy;
+      bool checked = false;
+      CHECK_INFO(IdxKeyValueSigmaUnitsNumberTimeOffset, (int, char*, char*, char*, char*, int, unsigned long),
+        f.idx, f.key, f.value, f.sigma, f.units, f.n, f.time_offset)
+      CHECK_INFO(KeyValueSigmaUnitsNumberTimeOffset, (char*, char*, char*, char*, int, unsigned long),
+        f.key, f.value, f.sigma, f.units, f.n, f.time_offset)
+      CHECK_INFO(IdxKeyValueUnitsNumberTimeOffset, (int, char*, char*, char*, int, unsigned long),
+        f.idx, f.key, f.value, f.units, f.n, f.time_offset)
+      CHECK_INFO(KeyValueUnitsNumberTimeOffset, (char*, char*, char*, int, unsigned long), f.key, f.value, f.units, f.n, f.time_offset)
+      CHECK_INFO(KeyValueUnitsNumber, (char*, char*, char*, int), f.key, f.value, f.units, f.n)
+      CHECK_INFO(ValueUnitsNumber, (char*, char*, int), f.value, f.units, f.n)
+      CHECK_INFO(IdxKeyValueUnits, (int, char*, char*, char*), f.idx, f.key, f.value, f.units)
+      CHECK_INFO(KeyValueUnits, (char*, char*, char*), f.key, f.value, f.units)
+      CHECK_INFO(IdxKeyValue, (int, char*, char*), f.idx, f.key, f.value)
+      CHECK_INFO(KeyValue, (char*, char*), f.key, f.value)
+      CHECK_INFO(ValueUnits, (char*, char*), f.value, f.units)
+      CHECK_INFO(Value, (char*), f.value)
+      if (!checked && mismatches++ < 10) printf("  pattern %s is not used by any getInfo function\n", name);
+    }
+  }
+}
+
+/*** timing ***/
+
+static Fields timing_fields[1024];
+
+static double timeCalls(bool serializer, const char* pattern) {
+  char text[200];
+  size_t sum = 0;
+  uint64_t start = wallNanos();
+  for (int i = 0; i < TIMING_CALLS; i++) {
+    Fields& f = timing_fields[i % 1024];
+    if (serializer)
+      getInfoIdxKeyValueSigmaUnitsNumberTimeOffset(text, sizeof(text), f.idx, f.key, f.value, f.sigma, f.units, f.n, f.time_offset, pattern);
+    else
+      snprintf(text, sizeof(text), pattern, f.idx, f.key, f.value, f.sigma, f.units, f.n, f.time_offset);
+    sum += text[0];
+  }
+  uint64_t ns = wallNanos() - start;
+  if (sum == 0) printf(" "); // keep the loop
+  return((double) ns / TIMING_CALLS);
+}
+
+static void timing(const char* name, const char* pattern) {
+  double before = timeCalls(false, pattern);
+  double after = timeCalls(true, pattern);
+  printf("%-28s %14.1f %14.1f %9.1fx\n", name, before, after, before / after);
+}
+
+// full data entry (number formatting + serialization) as the data logs assemble them
+static double timeDataEntry(bool serializer) {
+  char text[200];
+  size_t sum = 0;
+  uint64_t start = wallNanos();
+  for (int i = 0; i < TIMING_CALLS; i++) {
+    Fields& f = timing_fields[i % 1024];
+    double value = 21.5 + (i % 100) * 0.013, sigma = 0.01 * (i % 7);
+    if (serializer) {
+      getDataDoubleWithSigmaText(f.idx, f.key, value, sigma, f.units, f.n, f.time_offset, text, sizeof(text), PATTERN_IKVSUNT_JSON, 2);
+    } else {
+      char value_text[20], sigma_text[20];
+      print_to_decimals(value_text, sizeof(value_text), value, 2);
+      print_to_decimals(sigma_text, sizeof(sigma_text), sigma, 2);
+      snprintf(text, sizeof(text), PATTERN_IKVSUNT_JSON, f.idx, f.key, value_text, sigma_text, f.units, f.n, f.time_offset);
+    }
+    sum += text[0];
+  }
+  uint64_t ns = wallNanos() - start;
+  if (sum == 0) printf(" "); // keep the loop
+  return((double) ns / TIMING_CALLS);
+}
+
+int main(int argc, char** argv) {
+  host::setQuiet(true);
+  for (int i = 0; i < 1024; i++) {
+    randomFields(timing_fields[i]);
+    timing_fields[i].idx = i % 10;
+    timing_fields[i].n = i % 50;
+  }
+
+  printf("serializer benchmark: getInfo functions vs. snprintf, %d calls each\n\n", TIMING_CALLS);
+  printf("%-28s %14s %14s %10s\n", "pattern", "snprintf [ns]", "layout [ns]", "speedup");
+  timing("IKVSUNT_JSON (data log)", PATTERN_IKVSUNT_JSON);
+  timing("IKVSUN_JSON", PATTERN_IKVSUN_JSON);
+  timing("IKVSUN_SIMPLE (display)", PATTERN_IKVSUN_SIMPLE);
+  timing("IKV_JSON", PATTERN_IKV_JSON);
+  double before = timeDataEntry(false), after = timeDataEntry(true);
+  printf("%-28s %14.1f %14.1f %9.1fx\n", "data entry (incl. numbers)", before, after, before / after);
+
+  equivalence();
+  printf("\nequivalence: %lu calls checked against snprintf (all patterns, pointer and text matched, truncated targets), %lu mismatches\n",
+    (unsigned long) checks, (unsigned long) mismatches);
+  return(mismatches > 0);
+}
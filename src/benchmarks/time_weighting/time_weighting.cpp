@@ -0,0 +1,154 @@
+/*
+ * Host check: time weighted averages of step-changing data (LoggerData::enableTimeWeighting) against the exact time
+ * weighted mean of known step profiles, and the error of the previous whole second counting (which credited the
+ * partial second of a level to the next level)
+ * make host/benchmarks/time_weighting && _host/time_weighting
+ */
+#include "application.h"
+#include "LoggerData.h"
+
+#define RANDOM_PROFILES   10000
+#define MAX_STEPS         50
+#define TOLERANCE         1e-9 // relative to the level range
+
+static uint64_t seed = 42;
+static uint64_t random64() {
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return seed;
+}
+
+static double uniform() {
+  return (random64() >> 11) / (double) (1ULL << 53);
+}
+
+// levels[i] from times[i] on (ms), counted up to the end
+struct StepProfile {
+  int n;
+  uint64_t times[MAX_STEPS];
+  double levels[MAX_STEPS];
+  uint64_t end;
+};
+
+/*** expected ***/
+
+// exact time weighted mean over the whole seconds from the first step (the rest of a second is counted with the next log)
+static double exactMean(StepProfile& p, int& seconds) {
+  seconds = (p.end - p.times[0]) / 1000;
+  uint64_t until = p.times[0] + (uint64_t) seconds * 1000;
+  double sum = 0;
+  for (int i = 0; i < p.n; i++) {
+    uint64_t from = p.times[i];
+    uint64_t to = (i + 1 < p.n) ? p.times[i + 1] : until;
+    if (to > until) to = until;
+    if (to > from) sum += p.levels[i] * (to - from);
+  }
+  return(sum / (until - p.times[0]));
+}
+
+/*** previous implementation ***/
+
+// whole seconds of each level, the partial second carried over to the next level
+static double previousMean(StepProfile& p) {
+  uint64_t level_time = p.times[0];
+  double sum = 0;
+  int n = 0;
+  for (int i = 0; i < p.n; i++) {
+    uint64_t to = (i + 1 < p.n) ? p.times[i + 1] : p.end;
+    if (to < level_time + 1000) continue;
+    int seconds = (to - level_time) / 1000;
+    sum += p.levels[i] * seconds;
+    n += seconds;
+    level_time += (uint64_t) seconds * 1000;
+  }
+  return(sum / n);
+}
+
+/*** logger data ***/
+
+static double loggerMean(StepProfile& p, int& n) {
+  LoggerData data(1, "speed", "rpm");
+  data.enableTimeWeighting();
+  for (int i = 0; i < p.n; i++) {
+    data.setNewestValue(p.levels[i]);
+    data.setNewestDataTime(p.times[i]);
+    data.saveNewestValue(true);
+  }
+  data.updateTimeWeighting(p.end);
+  n = data.getN();
+  return(data.getValue());
+}
+
+/*** checks ***/
+
+static size_t checks = 0, failures = 0;
+static double max_error = 0, max_previous_error = 0;
+
+static void check(const char* name, StepProfile& p, double range, bool print) {
+  int seconds, n;
+  double exact = exactMean(p, seconds);
+  double previous = previousMean(p);
+  double actual = loggerMean(p, n);
+  double error = fabs(actual - exact) / range;
+  double previous_error = fabs(previous - exact) / range;
+  checks++;
+  if (error > max_error) max_error = error;
+  if (previous_error > max_previous_error) max_previous_error = previous_error;
+  bool failed = n != seconds || error > TOLERANCE;
+  if (failed) failures++;
+  if (print || (failed && failures <= 10)) {
+    printf("%-36s %6d %6d %12.6f %12.6f %12.6f %s\n", name, seconds, n, exact, previous, actual, failed ? "FAILED" : "ok");
+  }
+}
+
+// level changes at ms times that are not on the counting grid
+static void knownProfiles() {
+  StepProfile p;
+
+  // 0 for 1.5 s, 100 for 1.5 s: 50 (previous: 0 for 1 s, 100 for 2 s)
+  p = {2, {1000, 2500}, {0, 100}, 4000};
+  check("half second steps", p, 100, true);
+
+  // short 1000 rpm burst of 300 ms within 10 s at 200 rpm: 224
+  p = {3, {0, 4200, 4500}, {200, 1000, 200}, 10000};
+  check("300 ms burst", p, 800, true);
+
+  // several changes within one second: (10*100 + 20*250 + 30*650) / 1000 = 25.5 for the first second, then 30
+  p = {3, {0, 100, 350}, {10, 20, 30}, 2000};
+  check("changes within a second", p, 20, true);
+
+  // ramp in 250 ms steps over 5 s (the partial second at the end is not counted yet)
+  p.n = 20;
+  for (int i = 0; i < p.n; i++) {
+    p.times[i] = 123 + i * 250;
+    p.levels[i] = i * 10;
+  }
+  p.end = 123 + 5600;
+  check("ramp (250 ms steps)", p, 190, true);
+}
+
+static void randomProfiles() {
+  StepProfile p;
+  for (int j = 0; j < RANDOM_PROFILES; j++) {
+    p.n = 1 + (int) (uniform() * MAX_STEPS);
+    uint64_t time = (uint64_t) (uniform() * 1e6);
+    for (int i = 0; i < p.n; i++) {
+      p.times[i] = time;
+      p.levels[i] = (int) (uniform() * 1000);
+      time += 1 + (uint64_t) (uniform() * ((uniform() < 0.5) ? 800 : 20000)); // sub second and longer levels
+    }
+    p.end = p.times[p.n - 1] + 1000 + (uint64_t) (uniform() * 5000);
+    check("random", p, 1000, false);
+  }
+}
+
+int main(int argc, char** argv) {
+  host::setQuiet(true);
+
+  printf("time weighting check: means of step profiles vs. the exact time weighted mean\n\n");
+  printf("%-36s %6s %6s %12s %12s %12s\n", "profile", "s", "n", "exact", "previous", "logger");
+  knownProfiles();
+  randomProfiles();
+  printf("\n%lu profiles checked, %lu failures, max error %.2g (previous whole second counting: %.2g) of the level range\n",
+    (unsigned long) checks, (unsigned long) failures, max_error, max_previous_error);
+  return(failures > 0);
+}
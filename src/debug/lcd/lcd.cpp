@@ -28,13 +28,13 @@ void info_handler(const char *topic, const char *data)
 	if (strcmp(topic, "spark/device/name") == 0)
 	{
 		Serial.println("Device name: " + String(data));
-		strncpy(device_name, data, sizeof(device_name));
+		strncpy(device_name, data, sizeof(device_name) - 1);
 		lcd->printLine(1, "Name: " + String(device_name));
 	}
 	else if (strcmp(topic, "spark/device/ip") == 0)
 	{
 		Serial.println("Device public IP: " + String(data));
-		strncpy(device_public_ip, data, sizeof(device_public_ip));
+		strncpy(device_public_ip, data, sizeof(device_public_ip) - 1);
 		lcd->printLine(3, "IP address: ");
 		lcd->printLine(4, device_public_ip);
 	}
@@ -33,6 +33,9 @@ LoggerController* controller = new LoggerController(
   /* pointer to state */  state
 );
 
+// log spool (SPI flash on SPI1 with chip select on D5, disabled automatically if there is no flash)
+LoggerLogSpool* spool = new LoggerLogSpool(&SPI1, D5);
+
 // components
 LoggerComponent* cp1 = new LoggerComponent(
   "cp1 test", controller, false, false
@@ -68,6 +71,11 @@ void setup() {
   // lcd temporary messages
   lcd->setTempTextShowTime(3); // how many seconds temp time
 
+  // log spool and batched data log publishing
+  controller->setLogSpool(spool);
+  controller->batchDataLogs();
+  controller->mergeDataLogs();
+
   // add components
   controller->addComponent(cp1);
   controller->addComponent(cp2);
@@ -48,6 +48,9 @@ uint8_t AlicatMFCLoggerComponent::setupDataVector(uint8_t start_idx) {
     data[3] = LoggerData(3, "flow"); // mass flow
     data[4] = LoggerData(4, "setpoint"); // what the mass flow is supposed to be
 
+    // units are logged with the gas (rendered when logged so the gas can change without growing the string pool)
+    for (int i=0; i<data.size(); i++) data[i].units_suffix = gas;
+
     return(start_idx + data.size()); 
 }
 
@@ -154,6 +157,8 @@ void AlicatMFCLoggerComponent::finishData() {
         // get gas from gas list data
         snprintf (gas, sizeof(gas), "%s", value_buffer);
         Serial.printlnf("INFO: identified gas: '%s'", gas);
+        // the data variable shows the units with the gas
+        for (int i=0; i<data.size(); i++) data[i].info_outdated = true;
         // jump striaght to units request
         data_read_start = 0;
         serial_mode = MFC_SERIAL_MODE_UNITS_START;
@@ -183,9 +188,9 @@ void AlicatMFCLoggerComponent::finishData() {
                 saveState();
                 ctrl->updateStateVariable();
             }
-            if (strcmp(data[4].units, state->units) != 0) {
-                Serial.printlnf("INFO: MFC %s setpoint units changed from %s to %s, saving new setpoint units.", state->mfc_id, state->units, data[4].units);
-                snprintf (state->units, sizeof(state->units), "%s", data[4].units);
+            if (strcmp(data[4].getUnits(), state->units) != 0) {
+                Serial.printlnf("INFO: MFC %s setpoint units changed from %s to %s, saving new setpoint units.", state->mfc_id, state->units, data[4].getUnits());
+                snprintf (state->units, sizeof(state->units), "%s", data[4].getUnits());
                 saveState();
                 ctrl->updateStateVariable();
             }
@@ -240,7 +245,7 @@ void AlicatMFCLoggerComponent::processNewByte() {
 void AlicatMFCLoggerComponent::checkUnitID(char c) {
     // should be the unit
     if ( c != state->mfc_id[0]) {
-        Serial.printf("WARNING: not the correct unit, expected '%s', found '%s'\n", state->mfc_id, c);
+        Serial.printf("WARNING: not the correct unit, expected '%s', found '%c'\n", state->mfc_id, c);
         registerDataReadError();
         ctrl->lcd->printLineTemp(1, "MFC: wrong ID");
         returnToIdle();
@@ -258,6 +263,7 @@ void AlicatMFCLoggerComponent::resetGas() {
     gas_id = -1;
     gas[0] = '?';
     gas[1] = 0;
+    for (int i=0; i<data.size(); i++) data[i].info_outdated = true;
     // also reset read mode to not get stuck
     serial_mode = MFC_SERIAL_MODE_IDLE;
 }
@@ -436,11 +442,11 @@ void AlicatMFCLoggerComponent::checkUnit(unsigned int data_idx) {
     units_buffer[end] = 0;
 
     // check if we have a new unit
-    if (strcmp(data[data_idx].units, units_buffer) != 0) {
+    if (strcmp(data[data_idx].getUnits(), units_buffer) != 0) {
         switch_request = true;
         if (units_switch_counter == MFC_SWITCH_CHECK_TIMES - 1) {
             // units switch request often enough to switch
-            Serial.printlnf("INFO: switching %s units from '%s' to '%s'", data[data_idx].variable, data[data_idx].units, units_buffer);
+            Serial.printlnf("INFO: switching %s units from '%s' to '%s'", data[data_idx].getVariable(), data[data_idx].getUnits(), units_buffer);
             data[data_idx].setUnits(units_buffer);
         }
     }
@@ -465,9 +471,9 @@ void AlicatMFCLoggerComponent::processData() {
         if (new_byte == ' ') {
             // value delimiter reached --> process
             if (data_counter < data.size()) {
-                bool valid_value = data[data_counter].setNewestValue(value_buffer, true, true, 1L);
+                bool valid_value = data[data_counter].setNewestValue(value_parser, true, true, 1L);
                 if (!valid_value) {
-                    Serial.printf("WARNING: problem %d with serial data for %s value: %s\n", error_counter, data[data_counter].variable, value_buffer);
+                    Serial.printf("WARNING: problem %d with serial data for %s value: %s\n", error_counter, data[data_counter].getVariable(), value_buffer);
                     snprintf(ctrl->lcd->buffer, sizeof(ctrl->lcd->buffer), "MFC: %d value error", error_counter);
                     ctrl->lcd->printLineTempFromBuffer(1);
                     error_counter++;
@@ -486,30 +492,3 @@ void AlicatMFCLoggerComponent::processData() {
     }
 
 }
-
-/*** logger data variable & particle webhook data log ***/
-
-void AlicatMFCLoggerComponent::addGasToUnits() {
-    for (int i=0; i<data.size(); i++) { 
-        strcpy(data[i].aux, data[i].units);        
-        snprintf(data[i].units, sizeof(data[i].units), "%s %s", data[i].aux, gas);
-    }
-}
-
-void AlicatMFCLoggerComponent::removeGasFromUnits() {
-    for (int i=0; i<data.size(); i++) {
-        strcpy(data[i].units, data[i].aux);
-    }
-}
-
-void AlicatMFCLoggerComponent::assembleDataVariable() {
-    addGasToUnits();
-    MFCLoggerComponent::assembleDataVariable();
-    removeGasFromUnits();
-}
-
-void AlicatMFCLoggerComponent::logData() {
-    addGasToUnits();
-    MFCLoggerComponent::logData();
-    removeGasFromUnits();
-}
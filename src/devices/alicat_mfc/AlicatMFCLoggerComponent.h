@@ -72,11 +72,5 @@ class AlicatMFCLoggerComponent : public MFCLoggerComponent
     /*** actual data **/
     virtual void processData();
 
-    /*** logger data variable & particle webhook data log ***/
-    virtual void addGasToUnits();
-    virtual void removeGasFromUnits();
-    virtual void assembleDataVariable();
-    virtual void logData();
-
 };
 
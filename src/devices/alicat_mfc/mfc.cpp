@@ -57,7 +57,7 @@ void lcd_update_callback() {
       lcd->printLine(3, "F: off");
     } else if (mfc_state->status == MFC_STATUS_ON) {
       if (mfc->data[i].getN() > 0)
-        getDataDoubleText("F", mfc->data[i].getValue(), mfc->data[i].units, mfc->data[i].getN(), lcd->buffer, sizeof(lcd->buffer), PATTERN_KVUN_SIMPLE, mfc->data[i].getDecimals());
+        getDataDoubleText("F", mfc->data[i].getValue(), mfc->data[i].getUnits(), mfc->data[i].getN(), lcd->buffer, sizeof(lcd->buffer), PATTERN_KVUN_SIMPLE, mfc->data[i].getDecimals());
       else
         getInfoKeyValue(lcd->buffer, sizeof(lcd->buffer), "F", "no data yet", PATTERN_KV_SIMPLE);
       lcd->printLineFromBuffer(3);
@@ -66,9 +66,9 @@ void lcd_update_callback() {
     // pressure
     i = 0;
     if (mfc->data[i].getN() > 0)
-      getDataDoubleText(mfc->data[i].variable, mfc->data[i].getValue(), mfc->data[i].units, mfc->data[i].getN(), lcd->buffer, sizeof(lcd->buffer), PATTERN_KVUN_SIMPLE, mfc->data[i].getDecimals());
+      getDataDoubleText(mfc->data[i].getVariable(), mfc->data[i].getValue(), mfc->data[i].getUnits(), mfc->data[i].getN(), lcd->buffer, sizeof(lcd->buffer), PATTERN_KVUN_SIMPLE, mfc->data[i].getDecimals());
     else
-      getInfoKeyValue(lcd->buffer, sizeof(lcd->buffer), mfc->data[i].variable, "no data yet", PATTERN_KV_SIMPLE);
+      getInfoKeyValue(lcd->buffer, sizeof(lcd->buffer), mfc->data[i].getVariable(), "no data yet", PATTERN_KV_SIMPLE);
     lcd->printLineFromBuffer(4);
     
 
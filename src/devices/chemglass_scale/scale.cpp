@@ -47,7 +47,7 @@ void data_update_callback() {
   // latest data
   lcd->resetBuffer();
   if (scale->data[0].newest_value_valid)
-    getDataDoubleText("Last", scale->data[0].newest_value, scale->data[0].units, 
+    getDataDoubleText("Last", scale->data[0].newest_value, scale->data[0].getUnits(), 
       lcd->buffer, sizeof(lcd->buffer), PATTERN_KVU_SIMPLE, scale->data[0].decimals - 1);
   else
     strcpy(lcd->buffer, "Last: no data yet");
@@ -56,7 +56,7 @@ void data_update_callback() {
   // running data
   lcd->resetBuffer();
   if (scale->data[0].getN() > 0)
-    getDataDoubleText("Avg", scale->data[0].getValue(), scale->data[0].units, scale->data[0].getN(), 
+    getDataDoubleText("Avg", scale->data[0].getValue(), scale->data[0].getUnits(), scale->data[0].getN(), 
       lcd->buffer, sizeof(lcd->buffer), PATTERN_KVUN_SIMPLE, scale->data[0].getDecimals());
   else
     strcpy(lcd->buffer, "Avg: no data yet");
@@ -66,14 +66,14 @@ void data_update_callback() {
   lcd->resetBuffer();
   if (scale->state->calc_rate == CALC_RATE_OFF) {
     if (scale->data[0].getN() > 1)
-      getDataDoubleText("SD", scale->data[0].getStdDev(), scale->data[0].units, scale->data[0].getN(),
+      getDataDoubleText("SD", scale->data[0].getStdDev(), scale->data[0].getUnits(), scale->data[0].getN(),
         lcd->buffer, sizeof(lcd->buffer), PATTERN_KVUN_SIMPLE, scale->data[0].getDecimals());
     else
       strcpy(lcd->buffer, "SD: not enough data");
     lcd->printLineFromBuffer(4);
   } else {
     if (scale->data[1].newest_value_valid)
-      getDataDoubleText("Rate", scale->data[1].newest_value, scale->data[1].units, 
+      getDataDoubleText("Rate", scale->data[1].newest_value, scale->data[1].getUnits(), 
         lcd->buffer, sizeof(lcd->buffer), PATTERN_KVU_SIMPLE, scale->data[1].decimals);
     else
       strcpy(lcd->buffer, "Rate: not enough data");
@@ -27,6 +27,7 @@ class DS18B20TemperatureLoggerComponent : public DataReaderLoggerComponent
 
     /** loop **/
     virtual void update();
+    virtual uint64_t getNextUpdate();
 
     /*** read data ***/
     virtual void readData();
@@ -98,6 +99,11 @@ void DS18B20TemperatureLoggerComponent::update() {
     DataReaderLoggerComponent::update();
 }
 
+uint64_t DS18B20TemperatureLoggerComponent::getNextUpdate() {
+    // keep searching for the sensor every loop until it is found
+    return(sensor_found ? DataReaderLoggerComponent::getNextUpdate() : 0);
+}
+
 /*** read data ***/
 
 void DS18B20TemperatureLoggerComponent::readData() {
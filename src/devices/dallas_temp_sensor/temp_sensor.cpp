@@ -45,7 +45,7 @@ void lcd_update_callback() {
   if (temperature->foundSensor()) {
     // got a sensor -> show data if there is any yet
     if (temperature->data[0].newest_value_valid)
-      getDataDoubleText("T", temperature->data[0].newest_value, temperature->data[0].units, 
+      getDataDoubleText("T", temperature->data[0].newest_value, temperature->data[0].getUnits(), 
         lcd->buffer, sizeof(lcd->buffer), PATTERN_KVU_SIMPLE, temperature->data[0].decimals);
     else
       strcpy(lcd->buffer, "T: no data yet");
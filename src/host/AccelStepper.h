@@ -0,0 +1,78 @@
+/*
+ * Host stand-in for the AccelStepper library (constant speed subset).
+ * Steps are timed against the virtual micros() clock; the largest gap
+ * between consecutive steps is recorded so loop stalls show up as
+ * late (i.e. missed) steps in host simulations.
+ */
+#pragma once
+#include "application.h"
+
+class AccelStepper {
+
+  private:
+
+    long position = 0;
+    long target = 0;
+    float speed = 0; // steps / s
+    float max_speed = 1;
+    unsigned long step_interval = 0; // us
+    unsigned long last_step_time = 0; // us
+    bool outputs_enabled = true;
+
+    // step if the next step is due, returns whether a step was taken
+    bool step() {
+      if (step_interval == 0) return false;
+      unsigned long now = micros();
+      if (now - last_step_time < step_interval) return false;
+      if (steps > 0 && now - last_step_time > max_step_gap) max_step_gap = now - last_step_time;
+      if (steps > 0) host::recordStep(now - last_step_time);
+      position += (speed > 0) ? 1 : -1;
+      last_step_time = now;
+      steps++;
+      return true;
+    }
+
+  public:
+
+    enum MotorInterfaceType { FUNCTION = 0, DRIVER = 1, FULL2WIRE = 2, FULL3WIRE = 3, FULL4WIRE = 4, HALF3WIRE = 6, HALF4WIRE = 8 };
+
+    // host statistics
+    unsigned long steps = 0;
+    unsigned long max_step_gap = 0; // us
+
+    AccelStepper(uint8_t interface = FULL4WIRE, uint8_t pin1 = 2, uint8_t pin2 = 3, uint8_t pin3 = 4, uint8_t pin4 = 5, bool enable = true) {}
+
+    void setEnablePin(uint8_t pin) {}
+    void setPinsInverted(bool direction, bool step, bool enable) {}
+    void disableOutputs() { outputs_enabled = false; }
+    void enableOutputs() { outputs_enabled = true; }
+    void setMaxSpeed(float value) { max_speed = value; }
+    float maxSpeed() { return max_speed; }
+
+    void setSpeed(float value) {
+      if (value > max_speed) value = max_speed;
+      if (value < -max_speed) value = -max_speed;
+      if (value == 0.0) step_interval = 0;
+      else {
+        step_interval = fabs(1000000.0 / value);
+        if (speed == 0.0) last_step_time = micros();
+      }
+      speed = value;
+    }
+    float getSpeed() { return speed; }
+
+    bool runSpeed() { return step(); }
+
+    bool runSpeedToPosition() {
+      if (target == position) return false;
+      if ((target > position) != (speed > 0)) return false;
+      return step();
+    }
+
+    long distanceToGo() { return target - position; }
+    long currentPosition() { return position; }
+    long targetPosition() { return target; }
+    void setCurrentPosition(long value) { position = target = value; }
+    void moveTo(long absolute) { target = absolute; }
+    void move(long relative) { moveTo(position + relative); }
+};
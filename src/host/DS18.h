@@ -0,0 +1,25 @@
+/*
+ * Host stand-in for the DS18 temperature sensor library: readings drift
+ * slowly around room temperature on the virtual clock.
+ */
+#pragma once
+#include "application.h"
+
+class DS18 {
+
+  private:
+
+    float temperature = 0;
+
+  public:
+
+    DS18(uint16_t pin) {}
+
+    bool read(uint8_t* addr) {
+      temperature = 21.5 + 0.5 * sin(millis() / 600000.0) + 0.0625 * (analogRead(A0) % 3 - 1);
+      return true;
+    }
+
+    float celsius() { return temperature; }
+    float fahrenheit() { return temperature * 1.8 + 32; }
+};
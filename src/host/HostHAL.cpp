@@ -0,0 +1,1041 @@
+/*
+ * Host implementation of the simulated Particle HAL declared in application.h
+ */
+#include "application.h"
+#include <new>
+#include <map>
+#include <deque>
+
+/*** global peripherals ***/
+
+USBSerial Serial;
+USARTSerial Serial1;
+EEPROMClass EEPROM;
+CloudClass Particle;
+TimeClass Time;
+SystemClass System;
+WiFiClass WiFi;
+TwoWire Wire;
+SPIClass SPI(A2);
+SPIClass SPI1(D5);
+
+/*** heap accounting ***/
+
+// the device heap is modelled as a first-fit allocator over a virtual address range so that
+// free memory and fragmentation (largest free block) behave like newlib malloc on the Photon;
+// the memory itself still comes from the host malloc
+// all fields are zero-initialized before any static constructor runs
+#define HEAP_ALIGN        8 // newlib chunk alignment
+#define HEAP_OVERHEAD     8 // newlib chunk header
+#define HEAP_MIN_CHUNK    16
+#define HEAP_MAX_BLOCKS   4096 // maximum number of free blocks tracked
+#define HEAP_NO_OFFSET    UINT32_MAX
+
+static uint32_t heap_size = 60000; // simulated heap available to the application
+static uint32_t heap_used = 0;
+static uint32_t heap_peak = 0;
+static uint32_t heap_allocations = 0;
+static uint32_t heap_failures = 0;
+static int untracked_depth = 0;
+
+struct HeapBlock {
+  uint32_t start;
+  uint32_t size;
+};
+
+static HeapBlock heap_free[HEAP_MAX_BLOCKS]; // free blocks sorted by start
+static int heap_free_n = 0;
+static bool heap_initialized = false;
+
+static void heapInit() {
+  heap_free[0] = HeapBlock{0, heap_size};
+  heap_free_n = 1;
+  heap_initialized = true;
+}
+
+// first fit, returns HEAP_NO_OFFSET if no free block is large enough
+// chunk is enlarged if the remainder of the block would be too small to be useful
+static uint32_t heapModelAllocate(uint32_t& chunk) {
+  if (!heap_initialized) heapInit();
+  for (int i = 0; i < heap_free_n; i++) {
+    if (heap_free[i].size >= chunk) {
+      uint32_t start = heap_free[i].start;
+      if (heap_free[i].size - chunk < HEAP_MIN_CHUNK) {
+        // use the whole block
+        chunk = heap_free[i].size;
+        memmove(heap_free + i, heap_free + i + 1, (heap_free_n - i - 1) * sizeof(HeapBlock));
+        heap_free_n--;
+      } else {
+        heap_free[i].start += chunk;
+        heap_free[i].size -= chunk;
+      }
+      return start;
+    }
+  }
+  return HEAP_NO_OFFSET;
+}
+
+// return a block to the free list, merging with its neighbours
+static void heapModelFree(uint32_t start, uint32_t size) {
+  int i = 0;
+  while (i < heap_free_n && heap_free[i].start < start) i++;
+  bool merge_prev = (i > 0 && heap_free[i - 1].start + heap_free[i - 1].size == start);
+  bool merge_next = (i < heap_free_n && start + size == heap_free[i].start);
+  if (merge_prev && merge_next) {
+    heap_free[i - 1].size += size + heap_free[i].size;
+    memmove(heap_free + i, heap_free + i + 1, (heap_free_n - i - 1) * sizeof(HeapBlock));
+    heap_free_n--;
+  } else if (merge_prev) {
+    heap_free[i - 1].size += size;
+  } else if (merge_next) {
+    heap_free[i].start = start;
+    heap_free[i].size += size;
+  } else if (heap_free_n < HEAP_MAX_BLOCKS) {
+    memmove(heap_free + i + 1, heap_free + i, (heap_free_n - i) * sizeof(HeapBlock));
+    heap_free[i] = HeapBlock{start, size};
+    heap_free_n++;
+  }
+}
+
+// header in front of every allocation, 16 bytes to preserve alignment
+struct HeapHeader {
+  uint32_t size; // chunk size in the heap model
+  uint32_t offset; // position in the heap model
+  uint32_t tracked;
+  uint32_t padding;
+};
+
+static void* heapAllocate(size_t size, bool nothrow) {
+  uint32_t chunk = (size + HEAP_OVERHEAD + HEAP_ALIGN - 1) / HEAP_ALIGN * HEAP_ALIGN;
+  if (chunk < HEAP_MIN_CHUNK) chunk = HEAP_MIN_CHUNK;
+  uint32_t offset = HEAP_NO_OFFSET;
+  bool tracked = (untracked_depth == 0);
+  if (tracked) {
+    offset = heapModelAllocate(chunk);
+    if (offset == HEAP_NO_OFFSET) {
+      // the device would be out of memory
+      heap_failures++;
+      if (nothrow) return nullptr;
+      if (heap_failures == 1) fprintf(stdout, "HOST: out of memory allocating %lu bytes\n", (unsigned long) size);
+      tracked = false;
+    }
+  }
+  HeapHeader* header = (HeapHeader*) malloc(sizeof(HeapHeader) + size);
+  if (header == nullptr) {
+    if (nothrow) return nullptr;
+    throw std::bad_alloc();
+  }
+  header->offset = offset;
+  header->tracked = tracked;
+  if (tracked) {
+    header->size = chunk;
+    heap_used += chunk;
+    heap_allocations++;
+    if (heap_used > heap_peak) heap_peak = heap_used;
+  }
+  return header + 1;
+}
+
+static void heapFree(void* ptr) {
+  if (ptr == nullptr) return;
+  HeapHeader* header = ((HeapHeader*) ptr) - 1;
+  if (header->tracked) {
+    heap_used -= header->size;
+    heapModelFree(header->offset, header->size);
+  }
+  free(header);
+}
+
+void* operator new(size_t size) { return heapAllocate(size, false); }
+void* operator new[](size_t size) { return heapAllocate(size, false); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return heapAllocate(size, true); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return heapAllocate(size, true); }
+void operator delete(void* ptr) noexcept { heapFree(ptr); }
+void operator delete[](void* ptr) noexcept { heapFree(ptr); }
+void operator delete(void* ptr, size_t size) noexcept { heapFree(ptr); }
+void operator delete[](void* ptr, size_t size) noexcept { heapFree(ptr); }
+
+host::Untracked::Untracked() { untracked_depth++; }
+host::Untracked::~Untracked() { untracked_depth--; }
+
+/*** simulation state ***/
+
+static uint64_t virtual_us = 0;
+static uint32_t random_state = 2463534242;
+
+// pseudo random numbers (xorshift32) so simulations are reproducible
+static uint32_t hostRandom() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+struct SerialResponder {
+  std::string request;
+  std::vector<std::string> responses;
+  size_t next = 0;
+};
+
+struct CloudVariable {
+  char type; // 's' string, 'i' int, 'd' double, 'f' calculated
+  const void* ptr;
+  std::function<String()> fn;
+};
+
+struct CloudSubscription {
+  std::string prefix;
+  std::function<void(const char*, const char*)> handler;
+};
+
+struct CloudEvent {
+  system_tick_t time;
+  std::string name;
+  std::string data;
+};
+
+struct HostState {
+  // serial
+  bool quiet = false;
+  unsigned long serial1_baud = 9600;
+  uint32_t serial1_response_delay = 5; // ms
+  std::vector<SerialResponder> responders;
+  std::string serial1_tx;
+  std::deque<std::pair<uint64_t, uint8_t>> serial1_incoming; // arrival time [us], byte
+  uint8_t serial1_rx[64]; // Photon UART receive buffer size
+  size_t serial1_rx_start = 0;
+  size_t serial1_rx_n = 0;
+  uint32_t serial1_sent = 0;
+  uint32_t serial1_received = 0;
+  uint32_t serial1_overruns = 0;
+
+  // eeprom
+  uint8_t eeprom[HOST_EEPROM_LENGTH];
+
+  // spi flash
+  int spi_ss = -1; // chip select pin of the flash
+  bool spi_selected = false;
+  std::vector<uint8_t> spi_transaction; // bytes received since chip select
+  std::vector<uint8_t> flash; // allocated on first use
+  bool flash_write_enabled = false;
+  uint64_t flash_busy_until = 0; // [us]
+
+  // cloud
+  std::string device_name = "host";
+  bool connect_requested = false;
+  system_tick_t connect_at = 0;
+  uint32_t connect_delay = 2000;
+  bool time_synced = false;
+  std::vector<std::pair<uint32_t, uint32_t>> offline;
+  uint32_t publish_latency = 250;
+  double publish_failure_rate = 0.0;
+  bool publish_echo = false;
+  double rate_tokens = 4; // Device OS allows bursts of 4 events, 1 per second on average
+  system_tick_t rate_last = 0;
+  std::vector<host::Publish> publishes;
+  std::map<std::string, CloudVariable> variables;
+  std::map<std::string, std::function<int(String)>> functions;
+  std::vector<CloudSubscription> subscriptions;
+  std::deque<CloudEvent> events;
+  std::string variable_value;
+
+  // system
+  int reset_reason = RESET_REASON_POWER_DOWN;
+  uint32_t reset_reason_data = 0;
+  bool reset_requested = false;
+  uint32_t reset_data = 0;
+  unsigned watchdog_timeout = 0;
+  void (*watchdog_handler)() = nullptr;
+  bool lcd_connected = true;
+
+  // pins
+  uint8_t pin_values[HOST_N_PINS] = {};
+
+  HostState() { memset(eeprom, 0xFF, sizeof(eeprom)); }
+};
+
+static HostState& state() {
+  static HostState* s = nullptr;
+  if (s == nullptr) {
+    host::Untracked untracked;
+    s = new HostState();
+  }
+  return *s;
+}
+
+/*** timing ***/
+
+system_tick_t millis() { return (system_tick_t) (virtual_us / 1000); }
+unsigned long micros() { return (unsigned long) (uint32_t) virtual_us; }
+void delay(unsigned long ms) { virtual_us += (uint64_t) ms * 1000; }
+void delayMicroseconds(unsigned int us) { virtual_us += us; }
+
+uint64_t host::virtualMicros() { return virtual_us; }
+void host::advanceMicros(uint64_t us) { virtual_us += us; }
+void host::advanceMillis(uint32_t ms) { virtual_us += (uint64_t) ms * 1000; }
+void host::setSeed(uint32_t seed) { random_state = seed ? seed : 1; }
+
+/*** pins ***/
+
+void pinMode(uint16_t pin, PinMode mode) {}
+
+static void spiSelect(bool selected);
+
+void digitalWrite(uint16_t pin, uint8_t value) {
+  if (pin < HOST_N_PINS) state().pin_values[pin] = value;
+  if (pin == state().spi_ss) spiSelect(value == LOW);
+}
+
+int32_t digitalRead(uint16_t pin) {
+  return pin < HOST_N_PINS ? state().pin_values[pin] : LOW;
+}
+
+// 12 bit ADC reading with a little noise around mid-scale
+int32_t analogRead(uint16_t pin) {
+  return 2000 + (int32_t) (hostRandom() % 101) - 50;
+}
+
+/*** String ***/
+
+static std::string numberToString(unsigned long value, unsigned char base, bool negative) {
+  char buf[8 * sizeof(long) + 2];
+  char* p = buf + sizeof(buf) - 1;
+  *p = 0;
+  if (base < 2) base = 10;
+  do {
+    unsigned digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value > 0);
+  if (negative) *--p = '-';
+  return std::string(p);
+}
+
+String::String(int value, unsigned char base) : String((long) value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long) value, base) {}
+String::String(long value, unsigned char base) :
+  s(numberToString(value < 0 && base == 10 ? -(unsigned long) value : (unsigned long) value, base, value < 0 && base == 10)) {}
+String::String(unsigned long value, unsigned char base) : s(numberToString(value, base, false)) {}
+String::String(float value, int decimals) : String((double) value, decimals) {}
+String::String(double value, int decimals) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+  s = buf;
+}
+
+void String::toCharArray(char* buf, unsigned int bufsize, unsigned int index) const {
+  if (bufsize == 0 || buf == nullptr) return;
+  if (index >= s.length()) {
+    buf[0] = 0;
+    return;
+  }
+  unsigned int n = s.length() - index;
+  if (n > bufsize - 1) n = bufsize - 1;
+  memcpy(buf, s.c_str() + index, n);
+  buf[n] = 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+  size_t pos = s.find(c, from);
+  return pos == std::string::npos ? -1 : (int) pos;
+}
+
+int String::indexOf(const String& str, unsigned int from) const {
+  size_t pos = s.find(str.s, from);
+  return pos == std::string::npos ? -1 : (int) pos;
+}
+
+String String::substring(unsigned int left) const {
+  return left < s.length() ? String(s.substr(left)) : String();
+}
+
+String String::substring(unsigned int left, unsigned int right) const {
+  if (left > right) std::swap(left, right);
+  if (left >= s.length()) return String();
+  return String(s.substr(left, right - left));
+}
+
+bool String::endsWith(const String& suffix) const {
+  return s.length() >= suffix.s.length() && s.compare(s.length() - suffix.s.length(), suffix.s.length(), suffix.s) == 0;
+}
+
+void String::trim() {
+  size_t start = s.find_first_not_of(" \t\r\n");
+  size_t end = s.find_last_not_of(" \t\r\n");
+  s = (start == std::string::npos) ? std::string() : s.substr(start, end - start + 1);
+}
+
+void String::toLowerCase() { for (auto& c : s) c = tolower(c); }
+void String::toUpperCase() { for (auto& c : s) c = toupper(c); }
+
+/*** Print ***/
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+  return write(numberToString(n, base, false).c_str());
+}
+
+size_t Print::print(long n, int base) {
+  if (base == 10 && n < 0) return write('-') + printNumber(-(unsigned long) n, 10);
+  return printNumber((unsigned long) n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+size_t Print::vprintf(bool newline, const char* format, va_list args) {
+  char buf[512];
+  va_list args2;
+  va_copy(args2, args);
+  int n = vsnprintf(buf, sizeof(buf), format, args);
+  size_t written;
+  if (n < (int) sizeof(buf)) {
+    written = write(buf);
+  } else {
+    char* big = (char*) malloc(n + 1);
+    vsnprintf(big, n + 1, format, args2);
+    written = write(big);
+    free(big);
+  }
+  va_end(args2);
+  if (newline) written += println();
+  return written;
+}
+
+size_t Print::printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t n = vprintf(false, format, args);
+  va_end(args);
+  return n;
+}
+
+size_t Print::printlnf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t n = vprintf(true, format, args);
+  va_end(args);
+  return n;
+}
+
+/*** Serial ***/
+
+void host::setQuiet(bool quiet) { state().quiet = quiet; }
+
+bool USBSerial::isConnected() { return !state().quiet; }
+
+size_t USBSerial::write(uint8_t c) {
+  if (!state().quiet && c != '\r') fputc(c, stdout);
+  return 1;
+}
+
+size_t USBSerial::write(const uint8_t* buffer, size_t size) {
+  if (!state().quiet) {
+    for (size_t i = 0; i < size; i++) if (buffer[i] != '\r') fputc(buffer[i], stdout);
+  }
+  return size;
+}
+
+/*** Serial1 ***/
+
+// move bytes that have arrived on the virtual clock into the 64 byte receive buffer
+static void serial1Receive() {
+  HostState& s = state();
+  host::Untracked untracked;
+  while (!s.serial1_incoming.empty() && s.serial1_incoming.front().first <= virtual_us) {
+    if (s.serial1_rx_n < sizeof(s.serial1_rx)) {
+      s.serial1_rx[(s.serial1_rx_start + s.serial1_rx_n) % sizeof(s.serial1_rx)] = s.serial1_incoming.front().second;
+      s.serial1_rx_n++;
+      s.serial1_received++;
+    } else {
+      s.serial1_overruns++;
+    }
+    s.serial1_incoming.pop_front();
+  }
+}
+
+// queue a response, bytes arrive one by one at the configured baud rate
+static void serial1Respond(const std::string& response) {
+  HostState& s = state();
+  host::Untracked untracked;
+  uint64_t byte_us = 10 * 1000000ULL / (s.serial1_baud ? s.serial1_baud : 9600); // 8N1 = 10 bits per byte
+  uint64_t t = virtual_us + (uint64_t) s.serial1_response_delay * 1000;
+  if (!s.serial1_incoming.empty() && s.serial1_incoming.back().first > t) t = s.serial1_incoming.back().first;
+  for (char c : response) {
+    t += byte_us;
+    s.serial1_incoming.push_back(std::make_pair(t, (uint8_t) c));
+  }
+}
+
+void USARTSerial::begin(unsigned long baud, uint32_t config) {
+  state().serial1_baud = baud;
+}
+
+size_t USARTSerial::write(uint8_t c) {
+  HostState& s = state();
+  host::Untracked untracked;
+  s.serial1_sent++;
+  s.serial1_tx += (char) c;
+  for (auto& responder : s.responders) {
+    const std::string& req = responder.request;
+    if (s.serial1_tx.length() >= req.length() &&
+        s.serial1_tx.compare(s.serial1_tx.length() - req.length(), req.length(), req) == 0) {
+      serial1Respond(responder.responses[responder.next]);
+      responder.next = (responder.next + 1) % responder.responses.size();
+      s.serial1_tx.clear();
+      break;
+    }
+  }
+  if (s.serial1_tx.length() > 256) s.serial1_tx.erase(0, 128);
+  return 1;
+}
+
+int USARTSerial::available() {
+  serial1Receive();
+  return state().serial1_rx_n;
+}
+
+int USARTSerial::peek() {
+  serial1Receive();
+  HostState& s = state();
+  return s.serial1_rx_n > 0 ? s.serial1_rx[s.serial1_rx_start] : -1;
+}
+
+int USARTSerial::read() {
+  serial1Receive();
+  HostState& s = state();
+  if (s.serial1_rx_n == 0) return -1;
+  int c = s.serial1_rx[s.serial1_rx_start];
+  s.serial1_rx_start = (s.serial1_rx_start + 1) % sizeof(s.serial1_rx);
+  s.serial1_rx_n--;
+  return c;
+}
+
+// decode C escapes (\r \n \t \\ \xHH) in script lines
+static std::string unescape(const std::string& text) {
+  std::string out;
+  for (size_t i = 0; i < text.length(); i++) {
+    if (text[i] != '\\' || i + 1 == text.length()) {
+      out += text[i];
+      continue;
+    }
+    char c = text[++i];
+    if (c == 'r') out += '\r';
+    else if (c == 'n') out += '\n';
+    else if (c == 't') out += '\t';
+    else if (c == 's') out += ' ';
+    else if (c == 'x' && i + 2 < text.length()) {
+      out += (char) strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else out += c;
+  }
+  return out;
+}
+
+bool host::loadSerialScript(const char* path) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) return false;
+  HostState& s = state();
+  host::Untracked untracked;
+  char line[1024];
+  while (fgets(line, sizeof(line), file)) {
+    std::string text(line);
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+    if (text.empty() || text[0] == '#') continue;
+    if (text.compare(0, 7, "@delay ") == 0) {
+      s.serial1_response_delay = atoi(text.c_str() + 7);
+      continue;
+    }
+    size_t arrow = text.find(" => ");
+    if (arrow == std::string::npos) continue;
+    std::string request = unescape(text.substr(0, arrow));
+    std::string response = unescape(text.substr(arrow + 4));
+    bool found = false;
+    for (auto& responder : s.responders) {
+      if (responder.request == request) {
+        responder.responses.push_back(response);
+        found = true;
+      }
+    }
+    if (!found) {
+      SerialResponder responder;
+      responder.request = request;
+      responder.responses.push_back(response);
+      s.responders.push_back(responder);
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+void host::setSerialResponseDelay(uint32_t ms) { state().serial1_response_delay = ms; }
+uint32_t host::serialBytesSent() { return state().serial1_sent; }
+uint32_t host::serialBytesReceived() { return state().serial1_received; }
+uint32_t host::serialOverruns() { return state().serial1_overruns; }
+
+/*** stepper motors ***/
+
+static uint32_t stepper_steps = 0;
+static uint32_t stepper_max_step_gap = 0;
+
+void host::recordStep(uint32_t gap_us) {
+  stepper_steps++;
+  if (gap_us > stepper_max_step_gap) stepper_max_step_gap = gap_us;
+}
+
+uint32_t host::stepperSteps() { return stepper_steps; }
+uint32_t host::stepperMaxStepGap() { return stepper_max_step_gap; }
+
+/*** EEPROM ***/
+
+uint8_t EEPROMClass::read(int index) {
+  return (index >= 0 && index < HOST_EEPROM_LENGTH) ? state().eeprom[index] : 0xFF;
+}
+
+void EEPROMClass::write(int index, uint8_t value) {
+  if (index >= 0 && index < HOST_EEPROM_LENGTH) state().eeprom[index] = value;
+}
+
+void EEPROMClass::clear() {
+  memset(state().eeprom, 0xFF, sizeof(state().eeprom));
+}
+
+bool host::loadEEPROM(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) return false;
+  size_t n = fread(state().eeprom, 1, HOST_EEPROM_LENGTH, file);
+  fclose(file);
+  return n == HOST_EEPROM_LENGTH;
+}
+
+bool host::saveEEPROM(const char* path) {
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) return false;
+  size_t n = fwrite(state().eeprom, 1, HOST_EEPROM_LENGTH, file);
+  fclose(file);
+  return n == HOST_EEPROM_LENGTH;
+}
+
+/*** SPI flash ***/
+
+// behaves like a 1MB Winbond W25Q80: JEDEC id, read status, write enable/disable, read,
+// page program (bits can only be cleared, addresses wrap within the 256 byte page) and 4kB sector erase
+#define FLASH_SIZE            (1024 * 1024)
+#define FLASH_PAGE_SIZE       256
+#define FLASH_SECTOR_SIZE     4096
+#define FLASH_PROGRAM_TIME    700 // typical page program time [us]
+#define FLASH_ERASE_TIME      45000 // typical sector erase time [us]
+
+static std::vector<uint8_t>& flash() {
+  HostState& s = state();
+  if (s.flash.empty()) {
+    host::Untracked untracked;
+    s.flash.assign(FLASH_SIZE, 0xFF);
+  }
+  return s.flash;
+}
+
+static uint32_t flashAddress(const std::vector<uint8_t>& transaction) {
+  return ((transaction[1] << 16) | (transaction[2] << 8) | transaction[3]) % FLASH_SIZE;
+}
+
+// commands that modify the flash take effect when chip select goes high
+static void spiSelect(bool selected) {
+  HostState& s = state();
+  if (selected == s.spi_selected) return;
+  s.spi_selected = selected;
+  if (selected) {
+    host::Untracked untracked;
+    s.spi_transaction.clear();
+    return;
+  }
+  std::vector<uint8_t>& t = s.spi_transaction;
+  if (t.empty() || virtual_us < s.flash_busy_until) return;
+  if (t[0] == 0x06) s.flash_write_enabled = true;
+  else if (t[0] == 0x04) s.flash_write_enabled = false;
+  else if (t[0] == 0x02 && t.size() > 4 && s.flash_write_enabled) {
+    uint32_t address = flashAddress(t);
+    uint32_t page = address - address % FLASH_PAGE_SIZE;
+    for (size_t i = 4; i < t.size(); i++) {
+      flash()[page + (address - page + i - 4) % FLASH_PAGE_SIZE] &= t[i];
+    }
+    s.flash_write_enabled = false;
+    s.flash_busy_until = virtual_us + FLASH_PROGRAM_TIME;
+  } else if (t[0] == 0x20 && t.size() >= 4 && s.flash_write_enabled) {
+    uint32_t address = flashAddress(t);
+    memset(flash().data() + address - address % FLASH_SECTOR_SIZE, 0xFF, FLASH_SECTOR_SIZE);
+    s.flash_write_enabled = false;
+    s.flash_busy_until = virtual_us + FLASH_ERASE_TIME;
+  }
+}
+
+void SPIClass::begin(uint16_t ss_pin) {
+  state().spi_ss = ss_pin;
+  state().spi_selected = false;
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  HostState& s = state();
+  if (!s.spi_selected) return 0xFF;
+  std::vector<uint8_t>& t = s.spi_transaction;
+  {
+    host::Untracked untracked;
+    t.push_back(data);
+  }
+  size_t pos = t.size() - 1;
+  if (pos == 0) return 0xFF;
+  bool busy = virtual_us < s.flash_busy_until;
+  if (t[0] == 0x05) return (busy ? 0x01 : 0x00) | (s.flash_write_enabled ? 0x02 : 0x00);
+  if (busy) return 0xFF;
+  if (t[0] == 0x9F && pos <= 3) {
+    const uint8_t id[3] = {0xEF, 0x40, 0x14}; // Winbond, W25Q series, 2^20 bytes
+    return id[pos - 1];
+  }
+  if (t[0] == 0x03 && pos >= 4) return flash()[(flashAddress(t) + pos - 4) % FLASH_SIZE];
+  return 0xFF;
+}
+
+bool host::loadFlash(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) return false;
+  size_t n = fread(flash().data(), 1, FLASH_SIZE, file);
+  fclose(file);
+  return n == FLASH_SIZE;
+}
+
+bool host::saveFlash(const char* path) {
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) return false;
+  size_t n = fwrite(flash().data(), 1, FLASH_SIZE, file);
+  fclose(file);
+  return n == FLASH_SIZE;
+}
+
+/*** Particle cloud ***/
+
+static bool isOffline(system_tick_t t) {
+  for (auto& window : state().offline) {
+    if ((int32_t) (t - window.first) >= 0 && (int32_t) (t - window.second) < 0) return true;
+  }
+  return false;
+}
+
+void CloudClass::connect() {
+  HostState& s = state();
+  if (!s.connect_requested) {
+    s.connect_requested = true;
+    s.connect_at = millis() + s.connect_delay;
+  }
+}
+
+void CloudClass::disconnect() {
+  state().connect_requested = false;
+}
+
+bool CloudClass::connected() {
+  HostState& s = state();
+  bool connected = s.connect_requested && (int32_t) (millis() - s.connect_at) >= 0 && !isOffline(millis());
+  if (connected) s.time_synced = true;
+  return connected;
+}
+
+bool CloudClass::connecting() {
+  return state().connect_requested && !connected();
+}
+
+// deliver subscribed events that are due
+bool CloudClass::process() {
+  HostState& s = state();
+  while (!s.events.empty() && (int32_t) (millis() - s.events.front().time) >= 0) {
+    CloudEvent event;
+    {
+      host::Untracked untracked;
+      event = s.events.front();
+      s.events.pop_front();
+    }
+    for (auto& subscription : s.subscriptions) {
+      if (event.name.compare(0, subscription.prefix.length(), subscription.prefix) == 0)
+        subscription.handler(event.name.c_str(), event.data.c_str());
+    }
+  }
+  return true;
+}
+
+Future<bool> CloudClass::publish(const char* name, PublishFlag flag1, PublishFlag flag2) {
+  return publish(name, "", flag1, flag2);
+}
+
+Future<bool> CloudClass::publish(const char* name, const char* data, PublishFlag flag1, PublishFlag flag2) {
+  HostState& s = state();
+  host::Untracked untracked;
+  std::shared_ptr<particle::FutureState> future = std::make_shared<particle::FutureState>();
+  bool with_ack = (flag1 == WITH_ACK || flag2 == WITH_ACK);
+  bool system_event = (strncmp(name, "spark/", 6) == 0);
+  system_tick_t now = millis();
+
+  // Device OS rate limit: burst of 4, refilled at 1 event per second
+  s.rate_tokens += (now - s.rate_last) / 1000.0;
+  if (s.rate_tokens > 4) s.rate_tokens = 4;
+  s.rate_last = now;
+
+  host::Publish record;
+  record.name = name;
+  record.data = data ? data : "";
+  record.time = now;
+  record.latency = with_ack ? s.publish_latency : 0;
+  record.rate_limited = false;
+  if (!connected()) {
+    record.succeeded = false;
+    record.latency = 0;
+  } else if (!system_event && s.rate_tokens < 1) {
+    record.succeeded = false;
+    record.rate_limited = true;
+    record.latency = 0;
+  } else {
+    if (!system_event) s.rate_tokens -= 1;
+    record.succeeded =
+      (s.publish_failure_rate <= 0 || (hostRandom() % 1000000) >= s.publish_failure_rate * 1000000) &&
+      !isOffline(now + record.latency);
+  }
+  future->done_at = now + record.latency;
+  future->succeeded = record.succeeded;
+  s.publishes.push_back(record);
+
+  if (s.publish_echo) {
+    fprintf(stdout, "HOST: %lu ms publish %s %s (%s)\n", (unsigned long) now, name, record.data.c_str(),
+      record.succeeded ? "ok" : (record.rate_limited ? "rate limited" : "failed"));
+  }
+
+  // the cloud answers the device name request with a spark/device/name event
+  if (record.succeeded && strcmp(name, "spark/device/name") == 0) {
+    CloudEvent event;
+    event.time = future->done_at;
+    event.name = name;
+    event.data = s.device_name;
+    s.events.push_back(event);
+  }
+
+  return Future<bool>(future);
+}
+
+bool CloudClass::variable(const char* name, const char* var) {
+  host::Untracked untracked;
+  state().variables[name] = CloudVariable{'s', var};
+  return true;
+}
+
+bool CloudClass::variable(const char* name, const int& var) {
+  host::Untracked untracked;
+  state().variables[name] = CloudVariable{'i', &var};
+  return true;
+}
+
+bool CloudClass::variable(const char* name, const double& var) {
+  host::Untracked untracked;
+  state().variables[name] = CloudVariable{'d', &var};
+  return true;
+}
+
+bool CloudClass::registerVariable(const char* name, std::function<String()> fn) {
+  host::Untracked untracked;
+  state().variables[name] = CloudVariable{'f', nullptr, fn};
+  return true;
+}
+
+bool CloudClass::function(const char* name, int (*fn)(String)) {
+  return registerFunction(name, fn);
+}
+
+bool CloudClass::registerFunction(const char* name, std::function<int(String)> fn) {
+  host::Untracked untracked;
+  state().functions[name] = fn;
+  return true;
+}
+
+bool CloudClass::subscribe(const char* prefix, void (*fn)(const char*, const char*), Spark_Subscription_Scope_TypeDef scope) {
+  return registerSubscription(prefix, fn);
+}
+
+bool CloudClass::registerSubscription(const char* prefix, std::function<void(const char*, const char*)> fn) {
+  host::Untracked untracked;
+  state().subscriptions.push_back(CloudSubscription{prefix, fn});
+  return true;
+}
+
+void CloudClass::unsubscribe() {
+  host::Untracked untracked;
+  state().subscriptions.clear();
+}
+
+void host::setDeviceName(const char* name) { host::Untracked untracked; state().device_name = name; }
+void host::setConnectDelay(uint32_t ms) { state().connect_delay = ms; }
+void host::addOfflineWindow(uint32_t start_ms, uint32_t end_ms) {
+  host::Untracked untracked;
+  state().offline.push_back(std::make_pair(start_ms, end_ms));
+}
+void host::setPublishLatency(uint32_t ms) { state().publish_latency = ms; }
+void host::setPublishFailureRate(double rate) { state().publish_failure_rate = rate; }
+void host::setPublishEcho(bool echo) { state().publish_echo = echo; }
+const std::vector<host::Publish>& host::publishes() { return state().publishes; }
+
+int host::callFunction(const char* name, const char* arg) {
+  HostState& s = state();
+  if (s.functions.empty()) return -1;
+  auto fn = (name == nullptr) ? s.functions.begin() : s.functions.find(name);
+  if (fn == s.functions.end()) return -1;
+  return fn->second(String(arg));
+}
+
+const char* host::getVariable(const char* name) {
+  HostState& s = state();
+  auto var = s.variables.find(name);
+  if (var == s.variables.end()) return nullptr;
+  if (var->second.type == 'f') {
+    // calculated on the device (heap use of the callback is the device's)
+    String value = var->second.fn();
+    host::Untracked untracked;
+    s.variable_value = value.c_str();
+    return s.variable_value.c_str();
+  }
+  host::Untracked untracked;
+  char buf[64];
+  switch (var->second.type) {
+    case 's': s.variable_value = (const char*) var->second.ptr; break;
+    case 'i': snprintf(buf, sizeof(buf), "%d", *(const int*) var->second.ptr); s.variable_value = buf; break;
+    case 'd': snprintf(buf, sizeof(buf), "%g", *(const double*) var->second.ptr); s.variable_value = buf; break;
+  }
+  return s.variable_value.c_str();
+}
+
+std::vector<std::string> host::variableNames() {
+  std::vector<std::string> names;
+  for (auto& var : state().variables) names.push_back(var.first);
+  return names;
+}
+
+/*** Time ***/
+
+#define HOST_EPOCH_START 1767225600 // 2026-01-01 00:00:00 UTC
+
+// before the first cloud connection the RTC has not been synchronized
+time_t TimeClass::now() {
+  time_t uptime = (time_t) (virtual_us / 1000000);
+  return state().time_synced ? HOST_EPOCH_START + uptime : uptime;
+}
+
+bool TimeClass::isValid() {
+  return state().time_synced;
+}
+
+String TimeClass::format(time_t t, const char* format) {
+  struct tm calendar;
+  gmtime_r(&t, &calendar);
+  char buf[128];
+  strftime(buf, sizeof(buf), format, &calendar);
+  return String(buf);
+}
+
+/*** System ***/
+
+uint32_t SystemClass::freeMemory() {
+  return heap_used < heap_size ? heap_size - heap_used : 0;
+}
+
+uint64_t SystemClass::millis() { return virtual_us / 1000; }
+
+int SystemClass::resetReason() { return state().reset_reason; }
+uint32_t SystemClass::resetReasonData() { return state().reset_reason_data; }
+
+void SystemClass::reset() { reset(0); }
+
+void SystemClass::reset(uint32_t data, int flags) {
+  HostState& s = state();
+  if (!s.reset_requested) {
+    fprintf(stdout, "HOST: %lu ms system reset requested (data %lu)\n", (unsigned long) millis(), (unsigned long) data);
+  }
+  s.reset_requested = true;
+  s.reset_data = data;
+}
+
+void host::setResetReason(int reason, uint32_t data) {
+  state().reset_reason = reason;
+  state().reset_reason_data = data;
+}
+
+bool host::resetRequested() { return state().reset_requested; }
+uint32_t host::requestedResetData() { return state().reset_data; }
+
+ApplicationWatchdog::ApplicationWatchdog(unsigned timeout_ms, void (*handler)(), size_t stack_size) {
+  state().watchdog_timeout = timeout_ms;
+  state().watchdog_handler = handler;
+}
+
+void ApplicationWatchdog::checkin() {}
+
+// the watchdog fires when a single pass through loop() blocks longer than its timeout
+bool host::checkWatchdog(system_tick_t loop_start) {
+  HostState& s = state();
+  if (s.watchdog_handler == nullptr || millis() - loop_start < s.watchdog_timeout) return false;
+  fprintf(stdout, "HOST: %lu ms application watchdog fired\n", (unsigned long) millis());
+  s.watchdog_handler();
+  return true;
+}
+
+/*** WiFi ***/
+
+byte* WiFiClass::macAddress(byte* mac) {
+  const byte host_mac[6] = {0xE0, 0x4F, 0x43, 0x00, 0x00, 0x01};
+  memcpy(mac, host_mac, sizeof(host_mac));
+  return mac;
+}
+
+/*** Wire ***/
+
+// no acknowledgement (2) unless an LCD is simulated on the bus
+uint8_t TwoWire::endTransmission(uint8_t stop) {
+  return state().lcd_connected ? 0 : 2;
+}
+
+void host::setLCDConnected(bool connected) { state().lcd_connected = connected; }
+
+/*** heap ***/
+
+// resizes the free space at the top of the heap (allocations may already exist from static initialization)
+void host::setHeapSize(uint32_t bytes) {
+  if (!heap_initialized) heapInit();
+  if (heap_free_n > 0 && heap_free[heap_free_n - 1].start + heap_free[heap_free_n - 1].size == heap_size) {
+    HeapBlock& top = heap_free[heap_free_n - 1];
+    if (bytes > top.start) top.size = bytes - top.start;
+    else heap_free_n--;
+  } else if (bytes > heap_size) {
+    heap_free[heap_free_n++] = HeapBlock{heap_size, bytes - heap_size};
+  }
+  heap_size = bytes;
+}
+
+uint32_t host::heapLargestFree() {
+  if (!heap_initialized) heapInit();
+  uint32_t largest = 0;
+  for (int i = 0; i < heap_free_n; i++) {
+    if (heap_free[i].size > largest) largest = heap_free[i].size;
+  }
+  return largest;
+}
+
+uint32_t host::heapFailures() { return heap_failures; }
+uint32_t host::heapSize() { return heap_size; }
+uint32_t host::heapUsed() { return heap_used; }
+uint32_t host::heapPeak() { return heap_peak; }
+uint32_t host::heapAllocations() { return heap_allocations; }
@@ -0,0 +1,572 @@
+/*
+ * Host stand-in for the Particle Device OS application header.
+ * Provides just enough of the Photon HAL (Serial, Serial1, EEPROM, Particle,
+ * Time, System, WiFi, Wire, pins and timing) to compile and run the logger
+ * modules and device programs on a Linux host against a virtual clock.
+ * Behaviour of the simulated peripherals is controlled via the host:: API
+ * at the bottom of this file (see host_main.cpp for the command line).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+
+using namespace std::chrono_literals;
+
+/*** types ***/
+
+typedef uint8_t byte;
+typedef unsigned int uint;
+typedef uint32_t system_tick_t;
+
+/*** device program macros ***/
+
+#define SYSTEM_THREAD(state)
+#define SYSTEM_MODE(mode)
+#define PRODUCT_ID(id)
+#define PRODUCT_VERSION(version)
+#define SINGLE_THREADED_BLOCK() // the host runs the system and application code in one thread
+#define ATOMIC_BLOCK()
+
+/*** pins ***/
+
+#define D0 0
+#define D1 1
+#define D2 2
+#define D3 3
+#define D4 4
+#define D5 5
+#define D6 6
+#define D7 7
+#define A0 10
+#define A1 11
+#define A2 12
+#define A3 13
+#define A4 14
+#define A5 15
+#define A6 16
+#define A7 17
+#define DAC A6
+#define WKP A7
+#define RX 18
+#define TX 19
+#define HOST_N_PINS 20
+
+#define LOW 0
+#define HIGH 1
+
+enum PinMode { INPUT, OUTPUT, INPUT_PULLUP, INPUT_PULLDOWN };
+
+void pinMode(uint16_t pin, PinMode mode);
+void digitalWrite(uint16_t pin, uint8_t value);
+int32_t digitalRead(uint16_t pin);
+int32_t analogRead(uint16_t pin);
+
+/*** timing (virtual clock) ***/
+
+system_tick_t millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/*** String ***/
+
+class String {
+
+  private:
+
+    std::string s;
+
+  public:
+
+    String() {}
+    String(const char* cstr) : s(cstr ? cstr : "") {}
+    String(const std::string& str) : s(str) {}
+    String(char c) : s(1, c) {}
+    String(int value, unsigned char base = 10);
+    String(unsigned int value, unsigned char base = 10);
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+    String(float value, int decimals = 6);
+    String(double value, int decimals = 6);
+
+    unsigned int length() const { return s.length(); }
+    const char* c_str() const { return s.c_str(); }
+    operator const char*() const { return s.c_str(); }
+    char charAt(unsigned int index) const { return index < s.length() ? s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    void toCharArray(char* buf, unsigned int bufsize, unsigned int index = 0) const;
+    void getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index = 0) const { toCharArray((char*) buf, bufsize, index); }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& str, unsigned int from = 0) const;
+    String substring(unsigned int left) const;
+    String substring(unsigned int left, unsigned int right) const;
+    bool equals(const String& str) const { return s == str.s; }
+    bool equals(const char* cstr) const { return s == (cstr ? cstr : ""); }
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.length(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const;
+    void trim();
+    void toLowerCase();
+    void toUpperCase();
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+
+    String& concat(const String& str) { s += str.s; return *this; }
+    String& operator+=(const String& str) { s += str.s; return *this; }
+    String& operator+=(const char* cstr) { if (cstr) s += cstr; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    friend String operator+(const String& lhs, const String& rhs) { return String(lhs.s + rhs.s); }
+    bool operator==(const String& rhs) const { return s == rhs.s; }
+    bool operator==(const char* rhs) const { return equals(rhs); }
+    bool operator!=(const String& rhs) const { return s != rhs.s; }
+    bool operator!=(const char* rhs) const { return !equals(rhs); }
+};
+
+/*** Print ***/
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print {
+
+  private:
+
+    size_t printNumber(unsigned long n, uint8_t base);
+
+  public:
+
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return str ? write((const uint8_t*) str, strlen(str)) : 0; }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str) { return write(str.c_str()); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long) n, base); }
+    size_t print(int n, int base = DEC) { return print((long) n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long) n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t printlnf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t vprintf(bool newline, const char* format, va_list args);
+};
+
+class Stream : public Print {
+
+  public:
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+};
+
+/*** Serial (USB -> stdout) ***/
+
+class USBSerial : public Stream {
+
+  public:
+
+    void begin(long baud = 9600) {}
+    void end() {}
+    bool isConnected();
+    operator bool() { return true; }
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+};
+
+extern USBSerial Serial;
+
+/*** Serial1 (scripted UART) ***/
+
+#define SERIAL_8N1 0x00
+#define SERIAL_8N2 0x01
+#define SERIAL_8E1 0x02
+#define SERIAL_8O1 0x03
+
+class USARTSerial : public Stream {
+
+  public:
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1);
+    void end() {}
+    virtual size_t write(uint8_t c);
+    using Print::write;
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    virtual void flush() {}
+};
+
+extern USARTSerial Serial1;
+
+/*** EEPROM (in memory) ***/
+
+#define HOST_EEPROM_LENGTH 2047
+
+class EEPROMClass {
+
+  public:
+
+    uint8_t read(int index);
+    void write(int index, uint8_t value);
+    void update(int index, uint8_t value) { write(index, value); }
+    void clear();
+    uint16_t length() { return HOST_EEPROM_LENGTH; }
+
+    template <typename T> T& get(int index, T& t) {
+      uint8_t* p = (uint8_t*) &t;
+      for (size_t i = 0; i < sizeof(T); i++) p[i] = read(index + i);
+      return t;
+    }
+
+    template <typename T> const T& put(int index, const T& t) {
+      const uint8_t* p = (const uint8_t*) &t;
+      for (size_t i = 0; i < sizeof(T); i++) write(index + i, p[i]);
+      return t;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+/*** Particle cloud ***/
+
+enum PublishFlag { PUBLIC = 0, PRIVATE = 1, NO_ACK = 2, WITH_ACK = 8 };
+enum Spark_Subscription_Scope_TypeDef { MY_DEVICES, ALL_DEVICES };
+
+namespace particle {
+
+  // completion state of an asynchronous cloud operation on the virtual clock
+  struct FutureState {
+    system_tick_t done_at = 0;
+    bool succeeded = false;
+  };
+
+  template <typename T> class Future {
+
+    private:
+
+      std::shared_ptr<FutureState> state;
+
+    public:
+
+      Future() {}
+      explicit Future(std::shared_ptr<FutureState> state) : state(state) {}
+      bool isDone() const { return !state || (int32_t) (millis() - state->done_at) >= 0; }
+      bool isSucceeded() const { return isDone() && state && state->succeeded; }
+      bool isFailed() const { return isDone() && (!state || !state->succeeded); }
+      Future<T>& wait() {
+        if (!isDone()) delay(state->done_at - millis());
+        return *this;
+      }
+      T result() { wait(); return isSucceeded(); }
+      operator T() { return result(); }
+  };
+
+} // namespace particle
+
+using particle::Future;
+
+class CloudClass {
+
+  public:
+
+    void connect();
+    void disconnect();
+    bool connected();
+    bool connecting();
+    bool process();
+    void syncTime() {}
+    bool syncTimePending() { return false; }
+
+    Future<bool> publish(const char* name, PublishFlag flag1 = PRIVATE, PublishFlag flag2 = PRIVATE);
+    Future<bool> publish(const char* name, const char* data, PublishFlag flag1 = PRIVATE, PublishFlag flag2 = PRIVATE);
+
+    bool variable(const char* name, const char* var);
+    bool variable(const char* name, const int& var);
+    bool variable(const char* name, const double& var);
+    // calculated variable (the function is called whenever the cloud requests the variable)
+    template <typename T> bool variable(const char* name, String (T::*fn)(), T* instance) {
+      return registerVariable(name, std::bind(fn, instance));
+    }
+
+    bool function(const char* name, int (*fn)(String));
+    template <typename T> bool function(const char* name, int (T::*fn)(String), T* instance) {
+      return registerFunction(name, std::bind(fn, instance, std::placeholders::_1));
+    }
+
+    template <typename T> bool subscribe(const char* prefix, void (T::*fn)(const char*, const char*), T* instance,
+        Spark_Subscription_Scope_TypeDef scope = ALL_DEVICES) {
+      return registerSubscription(prefix, std::bind(fn, instance, std::placeholders::_1, std::placeholders::_2));
+    }
+    bool subscribe(const char* prefix, void (*fn)(const char*, const char*), Spark_Subscription_Scope_TypeDef scope = ALL_DEVICES);
+    void unsubscribe();
+
+  private:
+
+    bool registerVariable(const char* name, std::function<String()> fn);
+    bool registerFunction(const char* name, std::function<int(String)> fn);
+    bool registerSubscription(const char* prefix, std::function<void(const char*, const char*)> fn);
+};
+
+extern CloudClass Particle;
+
+/*** Time (virtual wall clock) ***/
+
+class TimeClass {
+
+  public:
+
+    time_t now();
+    time_t local() { return now(); } // no time zone
+    bool isValid();
+    void zone(float offset) {}
+    int second() { return second(now()); }
+    int second(time_t t) { return (int) (t % 60); }
+    int minute() { return minute(now()); }
+    int minute(time_t t) { return (int) ((t / 60) % 60); }
+    int hour() { return hour(now()); }
+    int hour(time_t t) { return (int) ((t / 3600) % 24); }
+    String format(time_t t, const char* format);
+    String format(const char* format) { return this->format(now(), format); }
+    String timeStr() { return format(now(), "%a %b %e %H:%M:%S %Y"); }
+};
+
+extern TimeClass Time;
+
+/*** System ***/
+
+#define RESET_REASON_NONE 0
+#define RESET_REASON_UNKNOWN 10
+#define RESET_REASON_PIN_RESET 20
+#define RESET_REASON_POWER_DOWN 30
+#define RESET_REASON_WATCHDOG 40
+#define RESET_REASON_USER 140
+#define FEATURE_RESET_INFO 1
+#define RESET_NO_WAIT 1
+
+class SystemClass {
+
+  public:
+
+    uint32_t freeMemory();
+    uint64_t millis(); // 64-bit millis() that does not wrap around
+    int resetReason();
+    uint32_t resetReasonData();
+    void enableFeature(int feature) {}
+    void reset();
+    void reset(uint32_t data, int flags = 0);
+
+    template <typename Condition> bool waitCondition(Condition condition, system_tick_t timeout = 0) {
+      system_tick_t start = millis();
+      while (!condition()) {
+        if (timeout > 0 && millis() - start >= timeout) return false;
+        delay(1);
+      }
+      return true;
+    }
+};
+
+#define waitFor(condition, timeout) System.waitCondition([]{ return (condition)(); }, (timeout))
+#define waitUntil(condition) System.waitCondition([]{ return (condition)(); })
+
+extern SystemClass System;
+
+/*** application watchdog (checked by the host loop against the virtual clock) ***/
+
+class ApplicationWatchdog {
+
+  public:
+
+    ApplicationWatchdog(std::chrono::milliseconds timeout, void (*handler)(), size_t stack_size = 512) :
+      ApplicationWatchdog((unsigned) timeout.count(), handler, stack_size) {}
+    ApplicationWatchdog(unsigned timeout_ms, void (*handler)(), size_t stack_size = 512);
+    static void checkin();
+};
+
+/*** WiFi ***/
+
+class WiFiClass {
+
+  public:
+
+    void on() {}
+    void off() {}
+    void connect() {}
+    bool ready() { return true; }
+    byte* macAddress(byte* mac);
+    int RSSI() { return -50; }
+};
+
+extern WiFiClass WiFi;
+
+/*** Wire (I2C) ***/
+
+#define CLOCK_SPEED_100KHZ 100000
+#define CLOCK_SPEED_400KHZ 400000
+
+class TwoWire : public Stream {
+
+  public:
+
+    void begin() {}
+    void end() {}
+    void setSpeed(uint32_t speed) {}
+    void stretchClock(bool stretch) {}
+    void beginTransmission(uint8_t address) {}
+    void beginTransmission(int address) {}
+    uint8_t endTransmission(uint8_t stop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity) { return 0; }
+    virtual size_t write(uint8_t c) { return 1; }
+    using Print::write;
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+};
+
+extern TwoWire Wire;
+
+/*** SPI ***/
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x02
+#define SPI_MODE3 0x03
+#define HZ 1
+#define MHZ 1000000
+#define KHZ 1000
+
+// both buses share one simulated JEDEC SPI NOR flash (1MB, 4kB sectors) on the chip select pin passed to begin()
+class SPIClass {
+
+  private:
+
+    uint16_t default_ss;
+
+  public:
+
+    SPIClass(uint16_t default_ss) : default_ss(default_ss) {}
+    void begin() { begin(default_ss); }
+    void begin(uint16_t ss_pin);
+    void end() {}
+    void setBitOrder(uint8_t order) {}
+    void setDataMode(uint8_t mode) {}
+    void setClockSpeed(unsigned value, unsigned scale = HZ) {}
+    void setClockDivider(uint8_t divider) {}
+    uint8_t transfer(uint8_t data);
+};
+
+extern SPIClass SPI; // A2 (SS), A3 (SCK), A4 (MISO), A5 (MOSI)
+extern SPIClass SPI1; // D5 (SS), D4 (SCK), D3 (MISO), D2 (MOSI)
+
+/*** application entry points (defined by the device program) ***/
+
+void setup();
+void loop();
+
+/*** host simulation controls ***/
+
+namespace host {
+
+  // virtual clock
+  uint64_t virtualMicros();
+  void advanceMicros(uint64_t us);
+  void advanceMillis(uint32_t ms);
+
+  // serial output
+  void setQuiet(bool quiet);
+
+  // Serial1 responder script, lines of 'request => response' (C escapes), '@delay <ms>'
+  bool loadSerialScript(const char* path);
+  void setSerialResponseDelay(uint32_t ms);
+  uint32_t serialBytesSent();
+  uint32_t serialBytesReceived();
+  uint32_t serialOverruns();
+
+  // stepper motors (AccelStepper stand-in)
+  void recordStep(uint32_t gap_us); // time since the previous step
+  uint32_t stepperSteps();
+  uint32_t stepperMaxStepGap(); // us
+
+  // EEPROM persistence
+  bool loadEEPROM(const char* path);
+  bool saveEEPROM(const char* path);
+
+  // external SPI flash persistence
+  bool loadFlash(const char* path);
+  bool saveFlash(const char* path);
+
+  // cloud
+  struct Publish {
+    std::string name;
+    std::string data;
+    system_tick_t time;
+    system_tick_t latency;
+    bool succeeded;
+    bool rate_limited;
+  };
+  void setDeviceName(const char* name);
+  void setConnectDelay(uint32_t ms);
+  void addOfflineWindow(uint32_t start_ms, uint32_t end_ms);
+  void setPublishLatency(uint32_t ms);
+  void setPublishFailureRate(double rate);
+  void setPublishEcho(bool echo);
+  const std::vector<Publish>& publishes();
+  int callFunction(const char* name, const char* arg);
+  const char* getVariable(const char* name);
+  std::vector<std::string> variableNames();
+
+  // system
+  void setResetReason(int reason, uint32_t data);
+  bool resetRequested();
+  uint32_t requestedResetData();
+  bool checkWatchdog(system_tick_t loop_start);
+  void setLCDConnected(bool connected);
+  void setSeed(uint32_t seed);
+
+  // heap accounting (global operator new/delete are tracked in a first-fit model of the device heap)
+  void setHeapSize(uint32_t bytes);
+  uint32_t heapSize();
+  uint32_t heapUsed();
+  uint32_t heapPeak();
+  uint32_t heapAllocations();
+  uint32_t heapLargestFree(); // largest allocation possible right now (fragmentation)
+  uint32_t heapFailures(); // allocations that would have failed on the device
+
+  // host-side allocations (recorded publishes etc.) that should not count against the device heap
+  class Untracked {
+    public:
+      Untracked();
+      ~Untracked();
+  };
+
+} // namespace host
@@ -0,0 +1,240 @@
+/*
+ * Host entry point: runs a device program's setup() and loop() against the
+ * simulated HAL on a virtual clock and reports loop timing, heap use and
+ * cloud traffic at the end of the run.
+ *
+ * usage: <program> [options]
+ *   --duration T        simulated run time (default 60s), T accepts ms/s/m/h/d suffixes
+ *   --tick T            virtual time that passes between loop() calls (default 1ms)
+ *   --uptime T          virtual clock at the start of the run (e.g. 49.7d to run across the 32-bit millis() wraparound),
+ *                       all other times are relative to the start
+ *   --quiet             suppress the device's Serial output
+ *   --publishes         echo every Particle.publish
+ *   --serial1 FILE      Serial1 responder script ('request => response' lines)
+ *   --eeprom FILE       load EEPROM from FILE (if it exists) and save it at the end
+ *   --flash FILE        same for the external SPI flash (log spool)
+ *   --reset-data N      start as if after a user reset with System.resetReasonData() == N
+ *   --command T:CMD     call the device's cloud function with CMD at time T (repeatable)
+ *   --name NAME         device name returned by the cloud (default host)
+ *   --connect-delay T   time from Particle.connect() to connection (default 2s)
+ *   --offline T1-T2     cloud outage window (repeatable)
+ *   --publish-latency T round trip time of WITH_ACK publishes (default 250ms)
+ *   --publish-fail P    probability that a publish fails (default 0)
+ *   --variable-reads T  request all cloud variables every T (as a dashboard polling the device would)
+ *   --heap BYTES        heap available to the application (default 60000)
+ *   --no-lcd            simulate a device without LCD on the I2C bus
+ *   --seed N            seed for the simulated noise sources
+ */
+#include "application.h"
+#include <map>
+#include <algorithm>
+
+/*** option parsing ***/
+
+// parse a duration with optional unit suffix into ms
+static uint32_t parseDuration(const char* text) {
+  char* end;
+  double value = strtod(text, &end);
+  if (strcmp(end, "us") == 0) value /= 1000.;
+  else if (strcmp(end, "s") == 0) value *= 1000.;
+  else if (strcmp(end, "m") == 0) value *= 60000.;
+  else if (strcmp(end, "h") == 0) value *= 3600000.;
+  else if (strcmp(end, "d") == 0) value *= 86400000.;
+  return (uint32_t) value;
+}
+
+struct HostCommand {
+  uint32_t time;
+  std::string command;
+};
+
+/*** loop timing statistics ***/
+
+// log2 histogram of loop() wall times in ns
+struct LoopTimes {
+  uint64_t buckets[64] = {};
+  uint64_t n = 0;
+  uint64_t total = 0;
+  uint64_t max = 0;
+
+  void add(uint64_t ns) {
+    int bucket = 0;
+    while (bucket < 63 && (1ULL << (bucket + 1)) <= ns) bucket++;
+    buckets[bucket]++;
+    n++;
+    total += ns;
+    if (ns > max) max = ns;
+  }
+
+  // upper bound of the bucket containing the given quantile
+  uint64_t quantile(double q) {
+    uint64_t target = (uint64_t) ceil(q * n);
+    uint64_t cumulative = 0;
+    for (int i = 0; i < 64; i++) {
+      cumulative += buckets[i];
+      if (cumulative >= target) return std::min(1ULL << (i + 1), (unsigned long long) max);
+    }
+    return max;
+  }
+};
+
+static uint64_t wallNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*** main ***/
+
+int main(int argc, char** argv) {
+
+  uint32_t duration = 60000;
+  uint32_t tick = 1;
+  uint32_t uptime = 0;
+  uint32_t variable_reads = 0;
+  const char* eeprom_file = nullptr;
+  const char* flash_file = nullptr;
+  std::vector<HostCommand> commands;
+  std::vector<std::pair<uint32_t, uint32_t>> offline;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--quiet") == 0) host::setQuiet(true);
+    else if (strcmp(arg, "--publishes") == 0) host::setPublishEcho(true);
+    else if (strcmp(arg, "--no-lcd") == 0) host::setLCDConnected(false);
+    else if (value == nullptr) {
+      fprintf(stderr, "ERROR: unknown option or missing value for '%s'\n", arg);
+      return 1;
+    } else {
+      i++;
+      if (strcmp(arg, "--duration") == 0) duration = parseDuration(value);
+      else if (strcmp(arg, "--tick") == 0) tick = parseDuration(value);
+      else if (strcmp(arg, "--uptime") == 0) uptime = parseDuration(value);
+      else if (strcmp(arg, "--name") == 0) host::setDeviceName(value);
+      else if (strcmp(arg, "--connect-delay") == 0) host::setConnectDelay(parseDuration(value));
+      else if (strcmp(arg, "--publish-latency") == 0) host::setPublishLatency(parseDuration(value));
+      else if (strcmp(arg, "--publish-fail") == 0) host::setPublishFailureRate(atof(value));
+      else if (strcmp(arg, "--variable-reads") == 0) variable_reads = parseDuration(value);
+      else if (strcmp(arg, "--heap") == 0) host::setHeapSize(atol(value));
+      else if (strcmp(arg, "--seed") == 0) host::setSeed(atol(value));
+      else if (strcmp(arg, "--reset-data") == 0) host::setResetReason(RESET_REASON_USER, atol(value));
+      else if (strcmp(arg, "--eeprom") == 0) {
+        eeprom_file = value;
+        host::loadEEPROM(eeprom_file);
+      } else if (strcmp(arg, "--flash") == 0) {
+        flash_file = value;
+        host::loadFlash(flash_file);
+      } else if (strcmp(arg, "--serial1") == 0) {
+        if (!host::loadSerialScript(value)) {
+          fprintf(stderr, "ERROR: could not read Serial1 script '%s'\n", value);
+          return 1;
+        }
+      } else if (strcmp(arg, "--offline") == 0) {
+        const char* dash = strchr(value, '-');
+        if (dash == nullptr) {
+          fprintf(stderr, "ERROR: offline window '%s' is not of the form START-END\n", value);
+          return 1;
+        }
+        host::Untracked untracked;
+        offline.push_back(std::make_pair(parseDuration(std::string(value, dash - value).c_str()), parseDuration(dash + 1)));
+      } else if (strcmp(arg, "--command") == 0) {
+        const char* colon = strchr(value, ':');
+        if (colon == nullptr) {
+          fprintf(stderr, "ERROR: command '%s' is not of the form TIME:COMMAND\n", value);
+          return 1;
+        }
+        host::Untracked untracked;
+        commands.push_back(HostCommand{parseDuration(std::string(value, colon - value).c_str()), colon + 1});
+      } else {
+        fprintf(stderr, "ERROR: unknown option '%s'\n", arg);
+        return 1;
+      }
+    }
+  }
+  std::stable_sort(commands.begin(), commands.end(),
+    [](const HostCommand& a, const HostCommand& b) { return a.time < b.time; });
+  host::advanceMillis(uptime);
+  for (auto& window : offline) host::addOfflineWindow(uptime + window.first, uptime + window.second);
+
+  // run
+  setup();
+  LoopTimes loop_times;
+  uint32_t max_stall = 0;
+  uint64_t loops = 0;
+  size_t next_command = 0;
+  LoopTimes variable_read_times;
+  uint64_t next_variable_read = 0;
+  uint64_t wall_start = wallNanos();
+  while (System.millis() - uptime < duration && !host::resetRequested()) {
+    while (next_command < commands.size() && System.millis() - uptime >= commands[next_command].time) {
+      int result = host::callFunction(nullptr, commands[next_command].command.c_str());
+      fprintf(stdout, "HOST: %lu ms command '%s' returned %d\n", (unsigned long) millis(),
+        commands[next_command].command.c_str(), result);
+      next_command++;
+    }
+    system_tick_t loop_start = millis();
+    uint64_t start = wallNanos();
+    loop();
+    loop_times.add(wallNanos() - start);
+    loops++;
+    if (millis() - loop_start > max_stall) max_stall = millis() - loop_start;
+    host::checkWatchdog(loop_start);
+    if (variable_reads > 0 && System.millis() >= next_variable_read) {
+      // calculated variables run on the application thread like loop()
+      uint64_t read_start = wallNanos();
+      for (auto& name : host::variableNames()) host::getVariable(name.c_str());
+      variable_read_times.add(wallNanos() - read_start);
+      next_variable_read = System.millis() + variable_reads;
+    }
+    Particle.process();
+    host::advanceMillis(tick);
+  }
+  uint64_t wall_total = wallNanos() - wall_start;
+  if (eeprom_file) host::saveEEPROM(eeprom_file);
+  if (flash_file) host::saveFlash(flash_file);
+
+  // report
+  printf("\nHOST: ---- simulation report ----\n");
+  printf("HOST: simulated %lu ms in %llu loops (%.2f s wall time)\n",
+    (unsigned long) (System.millis() - uptime), (unsigned long long) loops, wall_total / 1e9);
+  if (loops > 0) {
+    printf("HOST: loop() wall time: mean %.2f us, p50 < %.2f us, p99 < %.2f us, max %.2f us\n",
+      loop_times.total / 1e3 / loops, loop_times.quantile(0.5) / 1e3, loop_times.quantile(0.99) / 1e3, loop_times.max / 1e3);
+  }
+  printf("HOST: loop() max virtual stall: %lu ms\n", (unsigned long) max_stall);
+  if (variable_read_times.n > 0) {
+    printf("HOST: variable reads: %llu, wall time: mean %.2f us, max %.2f us\n", (unsigned long long) variable_read_times.n,
+      variable_read_times.total / 1e3 / variable_read_times.n, variable_read_times.max / 1e3);
+  }
+  printf("HOST: heap: size %lu, in use %lu, peak %lu (min free %lu), largest free block %lu, %lu allocations (%lu failed)\n",
+    (unsigned long) host::heapSize(), (unsigned long) host::heapUsed(), (unsigned long) host::heapPeak(),
+    (unsigned long) (host::heapPeak() < host::heapSize() ? host::heapSize() - host::heapPeak() : 0),
+    (unsigned long) host::heapLargestFree(), (unsigned long) host::heapAllocations(), (unsigned long) host::heapFailures());
+  printf("HOST: Serial1: %lu bytes sent, %lu bytes received, %lu bytes lost to receive buffer overruns\n",
+    (unsigned long) host::serialBytesSent(), (unsigned long) host::serialBytesReceived(), (unsigned long) host::serialOverruns());
+  if (host::stepperSteps() > 0) {
+    printf("HOST: stepper: %lu steps, longest gap between steps %.1f ms\n",
+      (unsigned long) host::stepperSteps(), host::stepperMaxStepGap() / 1e3);
+  }
+
+  // publishes by event name
+  host::Untracked untracked;
+  std::map<std::string, std::vector<unsigned long>> counts; // total, failed, rate limited, bytes
+  for (auto& publish : host::publishes()) {
+    auto& count = counts[publish.name];
+    if (count.empty()) count.resize(4, 0);
+    count[0]++;
+    if (!publish.succeeded) count[1]++;
+    if (publish.rate_limited) count[2]++;
+    count[3] += publish.data.length();
+  }
+  for (auto& count : counts) {
+    printf("HOST: publish %s: %lu events (%lu failed, %lu rate limited), %lu bytes\n",
+      count.first.c_str(), count.second[0], count.second[1], count.second[2], count.second[3]);
+  }
+  for (auto& name : host::variableNames()) {
+    printf("HOST: variable %s = %s\n", name.c_str(), host::getVariable(name.c_str()));
+  }
+  return 0;
+}
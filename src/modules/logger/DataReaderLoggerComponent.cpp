@@ -26,7 +26,7 @@ void DataReaderLoggerComponent::update() {
                 // idle data read but not yet time for a new request
                 idleDataRead();
                 // keep track of idle time for sequential readers
-                if (sequential && ctrl->sequential_data_idle_start == 0) ctrl->sequential_data_idle_start = millis(); 
+                if (sequential && ctrl->sequential_data_idle_start == 0) ctrl->sequential_data_idle_start = System.millis(); 
             } 
         } else if (data_read_status == DATA_READ_REQUEST && (!sequential || !ctrl->sequential_data_read_in_progress)) {
             // new data read request
@@ -36,6 +36,14 @@ void DataReaderLoggerComponent::update() {
     }
 }
 
+uint64_t DataReaderLoggerComponent::getNextUpdate() {
+    // idle readers have nothing to do until the next request (manual readers and sequential readers are polled while they
+    // wait for another sequential reader to finish)
+    if (!ctrl->state->data_reader || data_read_status != DATA_READ_IDLE || isManualDataReader()) return(0);
+    if (sequential && (ctrl->sequential_data_read_in_progress || ctrl->sequential_data_idle_start == 0)) return(0);
+    return(data_read_start + ctrl->state->data_reading_period + 1);
+}
+
 /*** read data ***/
 
 bool DataReaderLoggerComponent::isManualDataReader() {
@@ -45,12 +53,12 @@ bool DataReaderLoggerComponent::isManualDataReader() {
 
 bool DataReaderLoggerComponent::isTimeForRequest() {
     // reader is not sequential or controller is idle overall and this data reader is either manual or it has been enough time since the data read period
-    return((!sequential || ctrl->sequential_data_idle_start > 0) && (isManualDataReader() || (millis() - data_read_start) > ctrl->state->data_reading_period));
+    return((!sequential || ctrl->sequential_data_idle_start > 0) && (isManualDataReader() || (System.millis() - data_read_start) > ctrl->state->data_reading_period));
 }
 
 bool DataReaderLoggerComponent::isTimedOut() {
     // whether the reader is timed out - by default if it's been longer than data_reading_period
-    return((millis() - data_read_start) > ctrl->state->data_reading_period);
+    return((System.millis() - data_read_start) > ctrl->state->data_reading_period);
 }
 
 void DataReaderLoggerComponent::returnToIdle() {
@@ -74,30 +82,30 @@ void DataReaderLoggerComponent::initiateDataRead() {
                 Serial.printf("DEBUG: starting data read for parallel component '%s' (manual mode) ", id) :
                 Serial.printf("DEBUG: starting data read for parallel component '%s' ", id);
         }
-        Serial.printf("at %ld / ", millis());
-        Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+        Serial.printf("at %lu / ", (unsigned long) millis());
+        Serial.println(ctrl->getDateTime());
     }
     // keep track of sequential readers' activity
     if (sequential) {
         ctrl->sequential_data_read_in_progress = true;
         ctrl->sequential_data_idle_start = 0;
     }
-    data_read_start = millis();
-    data_received_last = millis();
+    data_read_start = System.millis();
+    data_received_last = System.millis();
     data_read_status = DATA_READ_WAITING;
     error_counter = 0;
 }
 
 void DataReaderLoggerComponent::readData() {
     startData();
-    data_received_last = millis();
+    data_received_last = System.millis();
     data_read_status = DATA_READ_COMPLETE;
 }
 
 void DataReaderLoggerComponent::completeDataRead() {
     if (ctrl->debug_data) {
         Serial.printf("DEBUG: finished data read with %d errors for component '%s' at ", error_counter, id);
-        Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+        Serial.println(ctrl->getDateTime());
     }
     returnToIdle();
     finishData();
@@ -107,13 +115,13 @@ void DataReaderLoggerComponent::completeDataRead() {
 void DataReaderLoggerComponent::registerDataReadError() {
     error_counter++;
     Serial.printf("ERROR: component '%s' encountered an error (#%d) trying to read data at ", id, error_counter);
-    Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+    Serial.println(ctrl->getDateTime());
     ctrl->lcd->printLineTemp(1, "ERR: data read error");
 }
 
 void DataReaderLoggerComponent::handleDataReadTimeout() {
     Serial.printf("WARNING: data reading period exceeded with %d errors for component '%s' at ", error_counter, id);
-    Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+    Serial.println(ctrl->getDateTime());
     ctrl->lcd->printLineTemp(1, "ERR: timeout read");
     returnToIdle();
 }
@@ -121,7 +129,7 @@ void DataReaderLoggerComponent::handleDataReadTimeout() {
 /*** manage data ***/
 
 void DataReaderLoggerComponent::startData() {
-    unsigned long start_time = millis();
+    uint64_t start_time = System.millis();
     for (int i=0; i < data.size(); i++) data[i].setNewestDataTime(start_time);
 }
 
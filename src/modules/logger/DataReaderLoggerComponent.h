@@ -20,8 +20,8 @@ class DataReaderLoggerComponent : public LoggerComponent
 
     // data reading
     uint8_t data_read_status = DATA_READ_IDLE;
-    unsigned long data_read_start = 0; // time the read started
-    unsigned long data_received_last = 0; // last time data was received
+    uint64_t data_read_start = 0; // time the read started (System.millis())
+    uint64_t data_received_last = 0; // last time data was received (System.millis())
     unsigned int error_counter = 0; // number of errors encountered during the read
 
   public:
@@ -34,6 +34,7 @@ class DataReaderLoggerComponent : public LoggerComponent
 
     /*** loop ***/
     virtual void update();
+    virtual uint64_t getNextUpdate(); // every loop while reading, the next request while idle
 
     /*** read data ***/
     virtual bool isManualDataReader();
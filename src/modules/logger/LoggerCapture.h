@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+
+/**** Raw sample capture ****/
+
+// ring of the newest raw values saved by the data of a component (see LoggerComponent::enableCapture()) so the individual
+// reads behind an odd average are still there when it is noticed, frozen and downloaded on request (see CMD_DATA_CAPTURE)
+// each sample takes 9 bytes (data time, value as float, data index in separate arrays to avoid padding)
+struct LoggerCapture {
+
+    uint16_t size; // how many samples the ring holds
+    uint16_t n; // how many samples are in the ring
+    uint16_t next; // where the next sample goes
+    uint32_t* times; // data times (low 32 bits of System.millis(), in ms)
+    float* values;
+    uint8_t* indices; // data indices
+
+    // download
+    bool frozen; // whether new samples are ignored (while downloading)
+    uint16_t download_pos; // next sample to download (counted from the oldest)
+    uint16_t download_n; // number of samples in the download
+
+    public:
+
+        LoggerCapture(uint16_t size) : size(size) {
+            times = new uint32_t[size];
+            values = new float[size];
+            indices = new uint8_t[size];
+            clear();
+        }
+
+        void clear() {
+            n = 0;
+            next = 0;
+            frozen = false;
+            download_pos = 0;
+            download_n = 0;
+        }
+
+        void add(uint8_t idx, uint64_t time, double value) {
+            if (frozen) return;
+            times[next] = (uint32_t) time;
+            values[next] = (float) value;
+            indices[next] = idx;
+            next = (next + 1) % size;
+            if (n < size) n++;
+        }
+
+        // freeze the ring and set up the download of the samples of the last window ms (all if 0)
+        // @return the number of samples to download
+        uint16_t freeze(uint32_t window, uint64_t now) {
+            frozen = true;
+            download_n = 0;
+            for (; download_n < n && (window == 0 || (uint32_t) now - getTime(n - 1 - download_n) <= window); download_n++);
+            download_pos = n - download_n;
+            return(download_n);
+        }
+
+        // continue capturing (after the download)
+        void release() {
+            frozen = false;
+            download_pos = 0;
+            download_n = 0;
+        }
+
+        bool isDownloading() {
+            return(frozen && download_pos < n);
+        }
+
+        // sample i (0 = oldest)
+        uint32_t getTime(uint16_t i) {
+            return(times[(next + size - n + i) % size]);
+        }
+
+        float getValue(uint16_t i) {
+            return(values[(next + size - n + i) % size]);
+        }
+
+        uint8_t getIndex(uint16_t i) {
+            return(indices[(next + size - n + i) % size]);
+        }
+
+};
@@ -23,11 +23,24 @@ void LoggerComponent::completeStartup() {
     Serial.printf("INFO: completing startup for component '%s'...\n", id);
 }
 
+void LoggerComponent::enableCapture(uint16_t n_samples, int only_data) {
+    if (capture != NULL || n_samples == 0) return;
+    capture = new LoggerCapture(n_samples);
+    for (int i=0; i<data.size(); i++) {
+        if (only_data < 0 || only_data == i) data[i].capture = capture;
+    }
+    Serial.printf("INFO: capturing the last %d raw samples of component '%s' (%d bytes)\n", n_samples, id, n_samples * 9);
+}
+
 /*** loop ***/
 
 void LoggerComponent::update() {
 }
 
+uint64_t LoggerComponent::getNextUpdate() {
+    return(0);
+}
+
 /*** state management ***/
 
 void LoggerComponent::setEEPROMStart(size_t start) { 
@@ -90,8 +103,7 @@ void LoggerComponent::assembleStateVariable() {
 
 void LoggerComponent::assembleDataVariable() {
   for (int i=0; i<data.size(); i++) {
-    data[i].assembleInfo();
-    ctrl->addToDataVariableBuffer(data[i].json);
+    ctrl->addToDataVariableBuffer(data[i]);
   }
 }
 
@@ -103,13 +115,20 @@ void LoggerComponent::clearData(bool clear_persistent) {
             (clear_persistent) ?
                 Serial.printf("DEBUG: clearing all component '%s' data at ", id):
                 Serial.printf("DEBUG: clearing only non-persistant component '%s' data at ", id);
-            Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+            Serial.println(ctrl->getDateTime());
         }
         for (int i=0; i<data.size(); i++) data[i].clear(clear_persistent);
+    } else {
+        // time weighted data always start a new window (their level carries over)
+        for (int i=0; i<data.size(); i++) {
+            if (data[i].isTimeWeighted()) data[i].clear(clear_persistent);
+        }
     }
 };
 
 void LoggerComponent::logData() {
+    // count the current levels of time weighted data up to the log
+    for (int i=0; i<data.size(); i++) data[i].updateTimeWeighting(System.millis());
     last_data_log_index = -1;
     // chunked data logging
     while (assembleDataLog()) {
@@ -120,6 +139,19 @@ void LoggerComponent::logData() {
     }
 };
 
+void LoggerComponent::clearRollupData(int rollup) {
+    for (int i=0; i<data.size(); i++) {
+        if (auto_clear_data || data[i].isTimeWeighted()) data[i].clearRollup(rollup);
+    }
+}
+
+void LoggerComponent::logRollupData(int rollup) {
+    // same data logs as for the log period (without the side effects of derived logData()) but from the rollup's stats
+    for (int i=0; i<data.size(); i++) data[i].swapRollup(rollup);
+    LoggerComponent::logData();
+    for (int i=0; i<data.size(); i++) data[i].swapRollup(rollup);
+}
+
 bool LoggerComponent::assembleDataLog() {
 
     // first reporting index
@@ -146,10 +178,18 @@ bool LoggerComponent::assembleDataLog() {
     ctrl->resetDataLog();
 
     // all data that fits
+    uint8_t packed[DATA_PACKED_MAX_BYTES];
+    size_t packed_size;
     i = first_data_log_index;
     for(; i < data.size(); i++) {
-        if(data[i].assembleLog(!data_have_same_time_offset)) {
-            if (!ctrl->addToDataLogBuffer(data[i].json)) {
+        if (ctrl->isPackingDataLogs()) {
+            packed_size = data[i].assemblePackedLog(packed, sizeof(packed), !data_have_same_time_offset, ctrl->getDataLogTime());
+            if (packed_size > 0 && !ctrl->addToPackedDataLogBuffer(packed, packed_size)) {
+                // no more space - stop here for this log
+                break;
+            }
+        } else if(data[i].assembleLog(ctrl->data_text, sizeof(ctrl->data_text), !data_have_same_time_offset, ctrl->getDataLogTime())) {
+            if (!ctrl->addToDataLogBuffer(ctrl->data_text)) {
                 // no more space - stop here for this log
                 break;
             }
@@ -159,7 +199,7 @@ bool LoggerComponent::assembleDataLog() {
 
     // finalize data log
     if (data_have_same_time_offset) {
-        unsigned long common_time = millis() - (unsigned long) data[first_data_log_index].getDataTime();
+        unsigned long common_time = (unsigned long) (ctrl->getDataLogTime() - data[first_data_log_index].getDataTime());
         return(ctrl->finalizeDataLog(true, common_time));
     } else {
         return(ctrl->finalizeDataLog(false));
@@ -39,6 +39,18 @@ class LoggerComponent
     // data
     std::vector<LoggerData> data;
 
+    // optional raw sample capture (see enableCapture(), NULL if not enabled)
+    LoggerCapture* capture = NULL;
+
+    // update scheduling (see getNextUpdate() and LoggerController::updateComponents())
+    uint64_t next_update = 0; // when update() is due next (System.millis(), 0 = every loop)
+    bool update_every_loop = true; // whether getNextUpdate() asked for every loop after the last update()
+    unsigned long update_last = 0; // when update() last ran (micros())
+    // update statistics (since they were last reset)
+    uint32_t update_n = 0; // number of updates
+    unsigned long update_period_max = 0; // longest time between updates while running every loop (in us, i.e. the loop period)
+    unsigned long update_latency_max = 0; // longest a scheduled update() waited past its deadline (in us)
+
     /*** constructors ***/
     LoggerComponent (const char *id, LoggerController *ctrl, bool data_have_same_time_offset, bool auto_clear_data) : id(id), ctrl(ctrl), data_have_same_time_offset(data_have_same_time_offset), auto_clear_data(auto_clear_data) {}
 
@@ -49,9 +61,15 @@ class LoggerComponent
     virtual uint8_t setupDataVector(uint8_t start_idx); // setup data vector - override in derived clases, has to return the new index
     virtual void init();
     virtual void completeStartup();
+    // keep the last n_samples raw values saved by the data (or only by data[only_data]) for download on request
+    // (see CMD_DATA_CAPTURE), each sample takes 9 bytes of memory (call after LoggerController::addComponent())
+    void enableCapture(uint16_t n_samples, int only_data = -1);
 
     /*** loop ***/
     virtual void update();
+    // when update() is due next (System.millis()), asked after every update(), 0 = every loop (default, e.g. for steppers)
+    // note: all components are due again right after a command (which might change what they are waiting for)
+    virtual uint64_t getNextUpdate();
 
     /*** state management ***/
     virtual void setEEPROMStart(size_t start);
@@ -80,5 +98,7 @@ class LoggerComponent
     virtual void clearData(bool clear_persistent = false);
     virtual void logData();
     virtual bool assembleDataLog();
+    virtual void clearRollupData(int rollup); // start a rollup window over (see LoggerController::addDataRollup)
+    virtual void logRollupData(int rollup); // data log(s) of a rollup window
 
 };
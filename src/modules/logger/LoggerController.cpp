@@ -1,6 +1,8 @@
 #include "application.h"
 #include "LoggerController.h"
 #include "LoggerComponent.h"
+#include "LoggerEncoding.h"
+#include <new>
 
 // EEPROM variables
 #define STATE_ADDRESS    0 // EEPROM storage location
@@ -51,6 +53,70 @@ void LoggerController::setDataUpdateCallback(void (*cb)()) {
   data_update_callback = cb;
 }
 
+/*** publish scheduling ***/
+
+void LoggerController::setPublishRate(float rate, float burst) {
+  publish_rate = (rate > 0) ? rate : PUBLISH_RATE;
+  publish_burst = (burst >= 1) ? burst : 1;
+  if (publish_tokens > publish_burst) publish_tokens = publish_burst;
+}
+
+void LoggerController::setDataLogQueueSize(size_t size) {
+  data_log_queue_size = (size > DATA_LOG_QUEUE_MIN) ? size : DATA_LOG_QUEUE_MIN;
+}
+
+void LoggerController::setPublishWeights(uint16_t state_weight, uint16_t data_weight) {
+  state_log_weight = (state_weight > 0) ? state_weight : 1;
+  data_log_weight = (data_weight > 0) ? data_weight : 1;
+}
+
+void LoggerController::setLogMaxAges(unsigned long state_max_age, unsigned long data_max_age) {
+  state_log_max_age = state_max_age;
+  data_log_max_age = data_max_age;
+}
+
+/*** data log batching ***/
+
+void LoggerController::batchDataLogs() {
+  batch_data_logs = true;
+}
+
+/*** packed data logs ***/
+
+void LoggerController::packDataLogs() {
+  pack_data_logs = true;
+}
+
+/*** data log merging ***/
+
+void LoggerController::mergeDataLogs() {
+  merge_data_logs = true;
+}
+
+/*** data rollups ***/
+
+bool LoggerController::addDataRollup(unsigned long period, bool logging) {
+  if (n_data_rollups >= DATA_ROLLUPS_MAX || period == 0) {
+    Serial.printlnf("ERROR: cannot add data rollup of %lu seconds (at most %d rollups)", period, DATA_ROLLUPS_MAX);
+    return(false);
+  }
+  data_rollups[n_data_rollups].period = period;
+  data_rollups[n_data_rollups].logging = logging;
+  n_data_rollups++;
+  return(true);
+}
+
+/*** log spool ***/
+
+void LoggerController::setLogSpool(LoggerLogSpool* spool) {
+  log_spool = spool;
+}
+
+uint32_t LoggerController::spoolLog(uint8_t type, const char* log, bool queued) {
+  if (log_spool == NULL) return(LOG_SPOOL_NO_RECORD);
+  return(log_spool->append(type, log, queued));
+}
+
 /*** setup ***/
 
 void LoggerController::addComponent(LoggerComponent* component) {
@@ -64,6 +130,8 @@ void LoggerController::addComponent(LoggerComponent* component) {
     }
     if (eeprom_location >= EEPROM_MAX) {
       Serial.printf("ERROR: component '%s' state would exceed EEPROM size, cannot add component.\n", component->id);
+    } else if (LoggerStringPool::hasOverflowed()) {
+      Serial.printf("ERROR: component '%s' keys and units would exceed the string pool, cannot add component.\n", component->id);
     } else {
       Serial.printf("INFO: adding component '%s' to the controller.\n", component->id);
       components.push_back(component);
@@ -76,7 +144,7 @@ void LoggerController::init() {
 
   // initialize
   Serial.printlnf("INFO: initializing controller '%s'...", version);
-  Serial.printlnf("INFO: available memory: %lu", System.freeMemory());
+  Serial.printlnf("INFO: available memory: %lu", (unsigned long) System.freeMemory());
 
   // capturing system reset information
   if (System.resetReason() == RESET_REASON_USER) {
@@ -115,13 +183,16 @@ void LoggerController::init() {
   state_log[2] = 0;
   strcpy(data_log, "{}");
   data_log[2] = 0;
+  strcpy(publish_variable, "{}");
+  publish_variable[2] = 0;
 
   // register particle functions
   Serial.println("INFO: registering logger cloud variables");
   Particle.subscribe("spark/", &LoggerController::captureName, this, MY_DEVICES);
   Particle.function(CMD_ROOT, &LoggerController::receiveCommand, this);
-  Particle.variable(STATE_INFO_VARIABLE, state_variable);
-  Particle.variable(DATA_INFO_VARIABLE, data_variable);
+  Particle.variable(STATE_INFO_VARIABLE, &LoggerController::getStateVariable, this);
+  Particle.variable(DATA_INFO_VARIABLE, &LoggerController::getDataVariable, this);
+  Particle.variable(PUBLISH_INFO_VARIABLE, publish_variable);
   if (debug_webhooks) {
     // report logs in variables instead of webhooks
     Particle.variable(STATE_LOG_WEBHOOK, state_log);
@@ -134,10 +205,14 @@ void LoggerController::init() {
 
   // components' init
   initComponents();
+  initDataRollups();
+
+  // log queues (after components so their allocations are accounted for)
+  initLogQueues();
   
   // startup time info
-  Serial.println(Time.format(Time.now(), "INFO: startup time: %Y-%m-%d %H:%M:%S %Z"));
-  Serial.printlnf("INFO: available memory: %lu", System.freeMemory());
+  Serial.printlnf("INFO: startup time: %s", getDateTime());
+  Serial.printlnf("INFO: available memory: %lu", (unsigned long) System.freeMemory());
 
 }
 
@@ -151,10 +226,57 @@ void LoggerController::initComponents()
   }
 }
 
+void LoggerController::initDataRollups() {
+  if (n_data_rollups == 0) return;
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    for (int i = 0; i < (*components_iter)->data.size(); i++) (*components_iter)->data[i].enableRollups(n_data_rollups);
+  }
+  for (int r = 0; r < n_data_rollups; r++) {
+    Serial.printlnf("INFO: data rollup window of %lu seconds (logging %s)", data_rollups[r].period, data_rollups[r].logging ? "on" : "off");
+  }
+}
+
+void LoggerController::initLogQueues() {
+  // state logs are rare, use a small fixed queue
+  if (!state_log_stack.init(STATE_LOG_QUEUE_SIZE)) {
+    Serial.printlnf("ERROR: could not allocate %d bytes for the state log queue", STATE_LOG_QUEUE_SIZE);
+  }
+
+  // data logs get a fixed size (falling back to smaller sizes if not available in one piece), the rest of the memory is left
+  // for the cloud connection, variable reads and the components
+  size_t size = data_log_queue_size;
+  while (!data_log_stack.init(size) && size > DATA_LOG_QUEUE_MIN) {
+    size = (size / 2 > DATA_LOG_QUEUE_MIN) ? size / 2 : DATA_LOG_QUEUE_MIN;
+  }
+  if (data_log_stack.getCapacity() == 0) {
+    Serial.printlnf("ERROR: could not allocate %d bytes for the data log queue", (int) size);
+  } else {
+    Serial.printlnf("INFO: data log queue holds %d bytes (at least %d data logs)", 
+      (int) data_log_stack.getCapacity(), (int) (data_log_stack.getCapacity() / (DATA_LOG_MAX_CHAR + LOG_QUEUE_RECORD_OVERHEAD)));
+  }
+
+  // merging packed data logs needs room to decode two logs and encode the merged one
+  if (merge_data_logs && pack_data_logs) {
+    data_log_merge_buffer = new (std::nothrow) uint8_t[3 * DATA_LOG_PACKED_MAX_BYTES];
+    if (data_log_merge_buffer == NULL) Serial.println("WARNING: not enough memory to merge packed data logs");
+  }
+
+  // headroom
+  min_free_memory = System.freeMemory();
+  Serial.printlnf("INFO: %lu bytes of memory left after allocating the log queues", min_free_memory);
+
+  // spooled logs from before the restart are published once the queues are empty
+  if (log_spool != NULL && !log_spool->init()) {
+    Serial.println("WARNING: continuing without log spool");
+  }
+}
+
 void LoggerController::completeStartup() {
   // update state and data information now that name is available
   updateStateVariable();
   updateDataVariable();
+  postPublishVariable();
 
   if (state->state_logging) {
     Serial.println("INFO: start-up completed.");
@@ -170,12 +292,23 @@ void LoggerController::completeStartup() {
   {
     (*components_iter)->completeStartup();
   }
+  rescheduleComponents();
 }
 
 /*** loop ***/
 
 void LoggerController::update() {
 
+    // epoch ms mapping (first so the second rollovers are observed as early as possible)
+    updateEpochTime();
+
+    // lowest free memory (the headroom left for the cloud connection, variable reads, etc.)
+    if (millis() - last_memory_check > MEMORY_CHECK_PERIOD) {
+      unsigned long free_memory = System.freeMemory();
+      if (free_memory < min_free_memory) min_free_memory = free_memory;
+      last_memory_check = millis();
+    }
+
     // cloud connection
     if (Particle.connected()) {
         if (!cloud_connected) {
@@ -184,7 +317,7 @@ void LoggerController::update() {
             Serial.printf("INFO: MAC address: %02x:%02x:%02x:%02x:%02x:%02x\n", 
             mac_address[0], mac_address[1], mac_address[2], mac_address[3], mac_address[4], mac_address[5]);
             Serial.println(Time.format(Time.now(), "INFO: cloud connection established at %H:%M:%S"));
-            Serial.printlnf("INFO: available memory: %lu", System.freeMemory());
+            Serial.printlnf("INFO: available memory: %lu", (unsigned long) System.freeMemory());
             cloud_connected = true;
             lcd->printLine(2, ""); // clear "connect wifi" message
 
@@ -228,6 +361,16 @@ void LoggerController::update() {
         clearData(false);
     }
 
+    // time to generate rollup data logs?
+    if (startup_complete) {
+        updateDataRollups();
+    }
+
+    // capture being downloaded?
+    if (startup_complete && capture_download != NULL) {
+        updateCaptureDownload();
+    }
+
     // out of memory?
     if (missed_data > 0 && !out_of_memory) {
       Serial.printlnf("INFO: no longer out of memory but missed %d data logs along the way", missed_data);
@@ -235,23 +378,36 @@ void LoggerController::update() {
       queueStateLog();
       missed_data = 0;
     }
+
+    // merged data logs while offline?
+    if (merged_data > 0 && Particle.connected()) {
+      Serial.printlnf("INFO: connected again but merged data logs %d times along the way", merged_data);
+      assembleMergedDataLog();
+      queueStateLog();
+      merged_data = 0;
+    }
     
+    // publish acknowledged?
+    if (publish_in_flight) {
+      checkPublish();
+    }
+
     // time to process logs?
-    if (startup_complete && Particle.connected() && millis() - last_log_published > publish_interval) {
-      if (!state_log_stack.empty()) {
-        // process state logs first
-        publishStateLog();
-      } else if (!data_log_stack.empty()) {
-        publishDataLog();
-      }
-      last_log_published = millis();
+    if (startup_complete && Particle.connected()) {
+      publishNextLog();
+    }
+
+    // spool sector erase ahead of time
+    if (log_spool != NULL) {
+      log_spool->update();
     }
 
     // time for time sync?
-    if (startup_complete && Particle.connected() && millis() - last_sync > ONE_DAY_MILLIS) {
+    if (startup_complete && Particle.connected() && System.millis() - last_sync > ONE_DAY_MILLIS) {
       // request time synchronization from the Particle Cloud
       Particle.syncTime();
-      last_sync = millis();
+      last_sync = System.millis();
+      epoch_resync = true;
     }
 
     // restart
@@ -265,21 +421,147 @@ void LoggerController::update() {
     }
 
     // components update
-    std::vector<LoggerComponent*>::iterator components_iter = components.begin();
-    for(; components_iter != components.end(); components_iter++) {
-        (*components_iter)->update();
-    }
+    updateComponents();
+
+    // requested cloud variables (after the components so this loop's changes are included)
+    if (state_variable_requested && state_variable_outdated) renderStateVariable();
+    if (data_variable_requested && data_variable_outdated) renderDataVariable();
 
     // lcd update
     lcd->update();
 
 }
 
+void LoggerController::updateComponents() {
+  // due components sorted by deadline once per pass (insertion sort, ties in the order the components were added)
+  uint64_t now = System.millis();
+  due_components.clear();
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    LoggerComponent* component = *components_iter;
+    if (component->next_update > now) continue;
+    due_components.push_back(component);
+    for (size_t i = due_components.size() - 1; i > 0 && due_components[i - 1]->next_update > component->next_update; i--) {
+      due_components[i] = due_components[i - 1];
+      due_components[i - 1] = component;
+    }
+  }
+
+  // earliest deadline first
+  for (size_t n = 0; n < due_components.size(); n++) {
+    LoggerComponent* next = due_components[n];
+    // every loop updates: time since the last update (loop period), scheduled ones: wait past the deadline (not after a command)
+    // in us, the deadline is on the System.millis() clock which micros() counts in us (modulo 2^32)
+    if (next->update_n > 0 && next->update_every_loop) {
+      unsigned long period = micros() - next->update_last;
+      if (period > next->update_period_max) next->update_period_max = period;
+    } else if (next->update_n > 0 && next->next_update > 0) {
+      int32_t latency = (int32_t) ((uint32_t) micros() - (uint32_t) (next->next_update * 1000));
+      if (latency > 0 && (unsigned long) latency > next->update_latency_max) next->update_latency_max = latency;
+    }
+    next->update_n++;
+    next->update_last = micros();
+    next->update();
+    next->next_update = next->getNextUpdate();
+    next->update_every_loop = next->next_update == 0;
+  }
+}
+
+void LoggerController::rescheduleComponents() {
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    (*components_iter)->next_update = 0;
+  }
+}
+
+void LoggerController::queueUpdateStatsLog() {
+  // one entry per component (split across several state logs if necessary), t = seconds covered by the statistics
+  LoggerWriter writer(state_log, sizeof(state_log));
+  writer.appendf("{\"id\":\"%s\",\"dt\":\"%s\",\"t\":\"%s\",\"s\":[{\"k\":\"t\",\"v\":%lu,\"u\":\"s\"}",
+    name, getDateTime(), CMD_LOG_TYPE_UPDATE_STATS, (millis() - update_stats_start) / 1000);
+  size_t header = writer.length;
+  const char footer[] = "],\"m\":\"u = updates, per = longest time between updates while running every loop [us], lat = longest wait of a scheduled update past its deadline [us]\",\"n\":\"\"}";
+  char entry[100];
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    LoggerWriter entry_writer(entry, sizeof(entry));
+    entry_writer.appendf("{\"k\":\"%s\",\"v\":{\"u\":%lu,\"per\":%lu,\"lat\":%lu}}", (*components_iter)->id, 
+      (unsigned long) (*components_iter)->update_n, (*components_iter)->update_period_max, (*components_iter)->update_latency_max);
+    if (entry_writer.overflow) continue; // too long (component id beyond the usual length)
+    if (!writer.fits(1 + entry_writer.length + strlen(footer))) {
+      // state log full, queue it and continue in the next one
+      writer.append(footer);
+      queueStateLog();
+      writer.truncate(header);
+    }
+    writer.append(',');
+    writer.append(entry, entry_writer.length);
+  }
+  writer.append(footer);
+  queueStateLog();
+}
+
+void LoggerController::resetUpdateStats() {
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    (*components_iter)->update_n = 0;
+    (*components_iter)->update_period_max = 0;
+    (*components_iter)->update_latency_max = 0;
+  }
+  update_stats_start = millis();
+}
+
+/*** timestamps ***/
+
+const char* LoggerController::getDateTime() {
+  return(getDateTime(Time.now()));
+}
+
+const char* LoggerController::getDateTime(time_t time) {
+  return(timestamp.getDateTime(time, Time.local() - Time.now()));
+}
+
+const char* LoggerController::getEpochTime(time_t time) {
+  return(timestamp.getEpoch(time));
+}
+
+// the mapping is anchored when the second is seen rolling over (Time only has second resolution), 
+// the true time at a rollover is at most the loop latency later than the second so a mapping that falls behind
+// is always re-anchored and one that runs ahead (millis drifting against the RTC) once it exceeds the tolerance
+void LoggerController::updateEpochTime() {
+  if (!Time.isValid() || Particle.syncTimePending()) return;
+  time_t now = Time.now();
+  if (now == epoch_second) return;
+  bool rollover = (epoch_second != 0 && now == epoch_second + 1); // not a jump (e.g. from a time sync)
+  epoch_second = now;
+  if (!rollover) return;
+  uint64_t ms = System.millis();
+  uint64_t now_ms = (uint64_t) now * 1000;
+  int64_t drift = (int64_t) (getEpochMillis(ms) - now_ms);
+  if (!epoch_anchored || epoch_resync || drift < 0 || drift > EPOCH_ANCHOR_TOLERANCE) {
+    if (debug_data && epoch_anchored) Serial.printlnf("DEBUG: epoch ms mapping re-anchored (drift %ld ms)", (long) drift);
+    epoch_anchor_millis = ms;
+    epoch_anchor = now_ms;
+    epoch_anchored = true;
+    epoch_resync = false;
+  }
+}
+
+uint64_t LoggerController::getEpochMillis(uint64_t ms) {
+  // before the first anchor: second resolution
+  if (!epoch_anchored) return((uint64_t) Time.now() * 1000 - (System.millis() - ms));
+  return(epoch_anchor + (int64_t) (ms - epoch_anchor_millis));
+}
+
+uint64_t LoggerController::getDataLogTime() {
+  return(data_log_time);
+}
+
 /*** logger name capture ***/
 
 void LoggerController::captureName(const char *topic, const char *data) {
   // store name and also assign it to Logger information
-  strncpy ( name, data, sizeof(name) );
+  strncpy ( name, data, sizeof(name) - 1 );
   name_handler_succeeded = true;
   Serial.printlnf("INFO: logger name '%s'", name);
   lcd->printLine(1, name);
@@ -356,6 +638,9 @@ int LoggerController::receiveCommand(String command_string) {
   command->extractVariable();
   parseCommand();
 
+  // the command might have changed what the components are waiting for
+  rescheduleComponents();
+
   // mark error if type still undefined
   if (!command->isTypeDefined()) command->errorCommand();
 
@@ -404,6 +689,14 @@ void LoggerController::parseCommand() {
     // restart getting parsed
   } else if (parsePage()) {
     // lcd paging
+  } else if (parsePublishStats()) {
+    // publish statistics
+  } else if (parseUpdateStats()) {
+    // component update statistics
+  } else if (parseDataRollup()) {
+    // data rollup logging
+  } else if (parseDataCapture()) {
+    // raw sample capture download
   } else {
     parseComponentsCommand();
   }
@@ -499,6 +792,113 @@ bool LoggerController::parseRestart() {
   return(command->isTypeDefined());
 }
 
+bool LoggerController::parsePublishStats() {
+  if (command->parseVariable(CMD_PUBLISH_STATS)) {
+    command->extractValue();
+    if (command->parseValue(CMD_PUBLISH_STATS_REPORT)) {
+      queuePublishStatsLog();
+      command->success(true);
+    } else if (command->parseValue(CMD_PUBLISH_STATS_RESET)) {
+      queuePublishStatsLog();
+      resetPublishStats();
+      command->success(true);
+    }
+    getStateStringText(CMD_PUBLISH_STATS, command->value, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
+  }
+  return(command->isTypeDefined());
+}
+
+bool LoggerController::parseUpdateStats() {
+  if (command->parseVariable(CMD_UPDATE_STATS)) {
+    command->extractValue();
+    if (command->parseValue(CMD_UPDATE_STATS_REPORT)) {
+      queueUpdateStatsLog();
+      command->success(true);
+    } else if (command->parseValue(CMD_UPDATE_STATS_RESET)) {
+      queueUpdateStatsLog();
+      resetUpdateStats();
+      command->success(true);
+    }
+    getStateStringText(CMD_UPDATE_STATS, command->value, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
+  }
+  return(command->isTypeDefined());
+}
+
+bool LoggerController::parseDataRollup() {
+  if (command->parseVariable(CMD_DATA_ROLLUP)) {
+    // which rollup window
+    command->extractValue();
+    command->extractUnits();
+    unsigned long period = atoi(command->value);
+    if (command->parseUnits(CMD_TIME_MIN)) period = 60 * period;
+    else if (command->parseUnits(CMD_TIME_HR)) period = 60 * 60 * period;
+    else if (command->parseUnits(CMD_TIME_DAY)) period = 24 * 60 * 60 * period;
+    else if (!command->parseUnits(CMD_TIME_SEC)) command->errorUnits();
+    int rollup = 0;
+    for (; rollup < n_data_rollups && data_rollups[rollup].period != period; rollup++);
+    if (!command->isTypeDefined() && rollup == n_data_rollups) {
+      // no such rollup window
+      command->errorValue();
+    } else if (!command->isTypeDefined()) {
+      // on/off
+      char on_off[5];
+      command->extractParam(on_off, sizeof(on_off) - 1);
+      if (strcmp(on_off, CMD_DATA_ROLLUP_ON) == 0) {
+        command->success(changeDataRollupLogging(rollup, true));
+      } else if (strcmp(on_off, CMD_DATA_ROLLUP_OFF) == 0) {
+        command->success(changeDataRollupLogging(rollup, false));
+      }
+      getStateDataRollupText(period, data_rollups[rollup].logging, command->data, sizeof(command->data));
+    }
+  }
+  return(command->isTypeDefined());
+}
+
+bool LoggerController::parseDataCapture() {
+  if (command->parseVariable(CMD_DATA_CAPTURE)) {
+    // which component
+    char id[20];
+    command->extractParam(id, sizeof(id) - 1);
+    LoggerComponent* component = NULL;
+    std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+    for(; components_iter != components.end(); components_iter++) {
+      if (strcmp((*components_iter)->id, id) == 0) component = *components_iter;
+    }
+    // window (whole capture if not provided)
+    command->extractValue();
+    command->extractUnits();
+    unsigned long window = atoi(command->value);
+    if (command->value[0] == 0) window = 0;
+    else if (command->parseUnits(CMD_TIME_MIN)) window = 60 * window;
+    else if (command->parseUnits(CMD_TIME_HR)) window = 60 * 60 * window;
+    else if (!command->parseUnits(CMD_TIME_SEC)) command->errorUnits();
+    char key[30];
+    snprintf(key, sizeof(key), "%s-%s", CMD_DATA_CAPTURE, id);
+    if (!command->isTypeDefined() && (component == NULL || component->capture == NULL)) {
+      // no such component or no capture
+      command->errorValue();
+    } else if (!command->isTypeDefined() && capture_download != NULL) {
+      // one download at a time
+      command->success(false);
+      snprintf(key, sizeof(key), "%s-%s", CMD_DATA_CAPTURE, capture_download->id);
+      getStateIntText(key, capture_download->capture->download_n, CMD_DATA_CAPTURE_UNITS, command->data, sizeof(command->data), PATTERN_KVU_JSON);
+    } else if (!command->isTypeDefined()) {
+      // freeze and start the download
+      uint16_t n = component->capture->freeze(window * 1000, System.millis());
+      if (n > 0) {
+        capture_download = component;
+        capture_chunk = 0;
+      } else {
+        component->capture->release();
+      }
+      Serial.printlnf("INFO: downloading %d raw samples from the capture of component '%s'", n, component->id);
+      command->success(n > 0);
+      getStateIntText(key, n, CMD_DATA_CAPTURE_UNITS, command->data, sizeof(command->data), PATTERN_KVU_JSON);
+    }
+  }
+  return(command->isTypeDefined());
+}
+
 bool LoggerController::parseDataLoggingPeriod() {
   if (command->parseVariable(CMD_DATA_LOG_PERIOD)) {
     // parse read period
@@ -702,9 +1102,19 @@ bool LoggerController::changeDataLogging (bool on) {
   return(changed);
 }
 
+// rollup logging (not saved in the state, rollups are set up in code)
+bool LoggerController::changeDataRollupLogging(int rollup, bool on) {
+  bool changed = on != data_rollups[rollup].logging;
+  data_rollups[rollup].logging = on;
+  if (debug_state) {
+    Serial.printlnf("DEBUG: data logging of the %lu second rollup %s %s", data_rollups[rollup].period, changed ? "turned" : "already", on ? "on" : "off");
+  }
+  return(changed);
+}
+
 // logging period
 bool LoggerController::changeDataLoggingPeriod(int period, int type) {
-  bool changed = period != state->data_logging_period | type != state->data_logging_type;
+  bool changed = period != state->data_logging_period || type != state->data_logging_type;
 
   if (changed) {
     state->data_logging_period = period;
@@ -713,7 +1123,7 @@ bool LoggerController::changeDataLoggingPeriod(int period, int type) {
 
   if (debug_state) {
     if (changed) Serial.printf("DEBUG: setting data logging period to %d %s\n", period, type == LOG_BY_TIME ? "seconds" : "reads");
-    else Serial.printf("DEBUG: data logging period unchanged (%d)\n", type == LOG_BY_TIME ? "seconds" : "reads");
+    else Serial.printf("DEBUG: data logging period unchanged (%d %s)\n", period, type == LOG_BY_TIME ? "seconds" : "reads");
   }
 
   if (changed) saveState();
@@ -830,15 +1240,202 @@ void LoggerController::updateDisplayComponentsStateInformation() {
   }
 }
 
+/*** publish scheduling ***/
+
+void LoggerController::refillPublishTokens() {
+  unsigned long now = millis();
+  publish_tokens += (now - publish_tokens_refilled) * publish_rate / 1000.0;
+  if (publish_tokens > publish_burst) publish_tokens = publish_burst;
+  publish_tokens_refilled = now;
+}
+
+void LoggerController::publishNextLog() {
+  if (publish_in_flight) return; // one publish at a time
+  refillPublishTokens();
+  if (publish_tokens < 1) return;
+
+  // a failed publish is retried before anything else
+  if (publish_type != PUBLISH_NONE) {
+    startPublish();
+    publish_tokens -= 1;
+    return;
+  }
+
+  // an empty queue does not save up its share for later
+  if (state_log_stack.empty()) state_log_pass = data_log_pass;
+  if (data_log_stack.empty()) data_log_pass = state_log_pass;
+
+  // queues whose oldest log is past the age limit go first (starting with that log)
+  bool state_expired = !state_log_stack.empty() && state_log_max_age > 0 && state_log_stack.getFrontAge() > state_log_max_age;
+  bool data_expired = !data_log_stack.empty() && data_log_max_age > 0 && data_log_stack.getFrontAge() > data_log_max_age;
+  bool state_due = state_expired || (!data_expired && !state_log_stack.empty());
+  bool data_due = data_expired || (!state_expired && !data_log_stack.empty());
+
+  // weighted fair interleaving of the due queues
+  if (state_due && (!data_due || state_log_pass <= data_log_pass)) {
+    publishStateLog(state_expired);
+    state_log_pass += PUBLISH_STRIDE / state_log_weight;
+  } else if (data_due) {
+    publishDataLog(data_expired);
+    data_log_pass += PUBLISH_STRIDE / data_log_weight;
+  } else if (log_spool != NULL && log_spool->getBacklog() > 0) {
+    // logs from before a restart or that did not fit into the queues
+    publishSpoolLog();
+  } else {
+    return; // nothing to publish
+  }
+  publish_tokens -= 1;
+
+  // keep passes small
+  uint32_t base = (state_log_pass < data_log_pass) ? state_log_pass : data_log_pass;
+  state_log_pass -= base;
+  data_log_pass -= base;
+}
+
+void LoggerController::startPublish() {
+  if (debug_cloud) {
+    Serial.printlnf("DEBUG: publishing %d log(s) to event '%s': '%s'", (int) publish_n, publish_webhook, publish_log);
+  }
+  LoggerPublishStats* stats = getPublishStats();
+  stats->publishes++;
+  if (publish_retry) stats->retries++;
+  publish_started = millis();
+  // does not wait for the cloud to acknowledge the publish (checkPublish picks up the result)
+  publish_future = Particle.publish(publish_webhook, publish_log, WITH_ACK);
+  publish_in_flight = true;
+}
+
+void LoggerController::checkPublish() {
+  if (!publish_future.isDone()) return;
+  publish_in_flight = false;
+  LoggerPublishStats* stats = getPublishStats();
+  stats->latency.add(millis() - publish_started);
+
+  if (publish_future.isSucceeded()) {
+    if (debug_cloud) {
+      Serial.printlnf("DEBUG: publish of %d log(s) to event '%s' successful.", (int) publish_n, publish_webhook);
+    }
+    if (publish_type == PUBLISH_DATA_LOG) {
+      if (publish_n > 1)
+        snprintf(lcd_buffer, sizeof(lcd_buffer), "INFO: %d logs sent", (int) publish_n);
+      else if (publish_queue_n > 1)
+        snprintf(lcd_buffer, sizeof(lcd_buffer), "data log %d sent", (int) publish_queue_n);
+      else
+        snprintf(lcd_buffer, sizeof(lcd_buffer), "INFO: data log sent");
+      lcd->printLineTemp(1, lcd_buffer);
+    } else if (publish_type == PUBLISH_SPOOL_LOG) {
+      snprintf(lcd_buffer, sizeof(lcd_buffer), "spool log %d sent", (int) publish_queue_n);
+      lcd->printLineTemp(1, lcd_buffer);
+    }
+    stats->succeeded++;
+    stats->logs += publish_n;
+    if (publish_type != PUBLISH_SPOOL_LOG) {
+      for (size_t i = 0; i < publish_n; i++) stats->residence.add((millis() - publish_times[i]) / 1000);
+    }
+    if (log_spool != NULL) {
+      if (publish_type == PUBLISH_SPOOL_LOG) {
+        log_spool->markNextLogPublished();
+      } else {
+        for (size_t i = 0; i < publish_n; i++) log_spool->markPublished(publish_refs[i]);
+      }
+    }
+    // free the publish slot
+    publish_type = PUBLISH_NONE;
+    publish_n = 0;
+    publish_retry = false;
+    postStateVariable(); // update state variable stack info
+  } else {
+    // keep the log(s) in the publish slot for a retry
+    stats->failed++;
+    publish_retry = true;
+    if (debug_cloud) {
+      Serial.printlnf("DEBUG: publish of %d log(s) to event '%s' failed!", (int) publish_n, publish_webhook);
+    }
+    if (publish_type == PUBLISH_DATA_LOG) {
+      snprintf(lcd_buffer, sizeof(lcd_buffer), "ERR: data log %d", (int) publish_queue_n);
+      lcd->printLineTemp(1, lcd_buffer);
+    } else if (publish_type == PUBLISH_SPOOL_LOG) {
+      snprintf(lcd_buffer, sizeof(lcd_buffer), "ERR: spool log %d", (int) publish_queue_n);
+      lcd->printLineTemp(1, lcd_buffer);
+    }
+  }
+  postPublishVariable();
+}
+
+/*** publish statistics ***/
+
+LoggerPublishStats* LoggerController::getPublishStats() {
+  if (publish_type == PUBLISH_STATE_LOG) return(&state_publish_stats);
+  if (publish_type == PUBLISH_DATA_LOG) return(&data_publish_stats);
+  return(&spool_publish_stats);
+}
+
+void LoggerController::postPublishVariable() {
+  // dt = datetime, t = seconds covered by the statistics, s = state logs, d = data logs, sp = spool logs (see LoggerPublishStats)
+  LoggerWriter writer(variable_render_buffer, sizeof(publish_variable));
+  writer.appendf("{\"dt\":\"%s\",\"t\":%lu,\"s\":", getDateTime(), (millis() - publish_stats_start) / 1000);
+  state_publish_stats.assembleJson(writer);
+  writer.append(",\"d\":");
+  data_publish_stats.assembleJson(writer);
+  if (log_spool != NULL) {
+    writer.append(",\"sp\":");
+    spool_publish_stats.assembleJson(writer);
+  }
+  writer.append('}');
+  if (writer.overflow) {
+    Serial.println("ERROR: publish variable buffer not large enough for publish statistics");
+    strcpy(variable_render_buffer, "{}");
+  }
+  updateVariableSnapshot(publish_variable, sizeof(publish_variable));
+  if (debug_cloud) {
+    Serial.printf("DEBUG: updated publish variable: %s\n", publish_variable);
+  }
+}
+
+void LoggerController::queuePublishStatsLog() {
+  // one entry per log source (split across several state logs if necessary), t = seconds covered by the statistics
+  LoggerWriter writer(state_log, sizeof(state_log));
+  writer.appendf("{\"id\":\"%s\",\"dt\":\"%s\",\"t\":\"%s\",\"s\":[{\"k\":\"t\",\"v\":%lu,\"u\":\"s\"}",
+    name, getDateTime(), CMD_LOG_TYPE_PUBLISH_STATS, (millis() - publish_stats_start) / 1000);
+  size_t header = writer.length;
+  const char footer[] = "],\"m\":\"p = publishes, ok = succeeded, f = failed, r = retries, l = logs, lat = latency [ms], res = residence [s]\",\"n\":\"\"}";
+  const char* keys[] = {"state", "data", "spool"};
+  LoggerPublishStats* stats[] = {&state_publish_stats, &data_publish_stats, &spool_publish_stats};
+  char entry[250];
+  for (int i = 0; i < (log_spool != NULL ? 3 : 2); i++) {
+    LoggerWriter entry_writer(entry, sizeof(entry));
+    entry_writer.appendf("{\"k\":\"%s\",\"v\":", keys[i]);
+    stats[i]->assembleJson(entry_writer);
+    entry_writer.append('}');
+    if (entry_writer.overflow) continue; // too long (does not happen with the counter sizes)
+    if (!writer.fits(1 + entry_writer.length + strlen(footer))) {
+      // state log full, queue it and continue in the next one
+      writer.append(footer);
+      queueStateLog();
+      writer.truncate(header);
+    }
+    writer.append(',');
+    writer.append(entry, entry_writer.length);
+  }
+  writer.append(footer);
+  queueStateLog();
+}
+
+void LoggerController::resetPublishStats() {
+  state_publish_stats.clear();
+  data_publish_stats.clear();
+  spool_publish_stats.clear();
+  publish_stats_start = millis();
+  postPublishVariable();
+}
+
 /*** logger state variable ***/
 
 void LoggerController::updateStateVariable() {
   updateDisplayStateInformation();
   updateDisplayComponentsStateInformation();
   if (state_update_callback) state_update_callback();
-  state_variable_buffer[0] = 0; // reset buffer
-  assembleStateVariable();
-  assembleComponentsStateVariable();
+  state_variable_entries_outdated = true;
   postStateVariable();
 }
 
@@ -851,6 +1448,9 @@ void LoggerController::assembleStateVariable() {
   if (state->data_reader) {
     getStateDataReadingPeriodText(state->data_reading_period, pair, sizeof(pair)); addToStateVariableBuffer(pair);
   }
+  for (int r = 0; r < n_data_rollups; r++) {
+    getStateDataRollupText(data_rollups[r].period, data_rollups[r].logging, pair, sizeof(pair)); addToStateVariableBuffer(pair);
+  }
 }
 
 void LoggerController::assembleComponentsStateVariable() {
@@ -862,29 +1462,51 @@ void LoggerController::assembleComponentsStateVariable() {
 }
 
 void LoggerController::addToStateVariableBuffer(char* info) {
-  if (state_variable_buffer[0] == 0) {
-    strncpy(state_variable_buffer, info, sizeof(state_variable_buffer));
-  } else {
-    snprintf(state_variable_buffer, sizeof(state_variable_buffer),
-        "%s,%s", state_variable_buffer, info);
-  }
+  state_variable_writer.appendElement(info);
 }
 
 void LoggerController::postStateVariable() {
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
+  refillPublishTokens();
+  state_variable_time = Time.now();
+  state_variable_outdated = true;
+  if (!Particle.connected()) {
+    Serial.println("WARNING: particle not (yet) connected, state variable only available when connected.");
+  }
+}
+
+void LoggerController::renderStateVariable() {
+  if (state_variable_entries_outdated) {
+    state_variable_writer.reset();
+    assembleStateVariable();
+    assembleComponentsStateVariable();
+    state_variable_entries_outdated = false;
+    if (state_variable_writer.overflow) {
+      Serial.println("ERROR: state variable buffer not large enough for all state information");
+    }
+  }
   // dt = datetime, s = state information
-  snprintf(state_variable, sizeof(state_variable), 
-    "{\"dt\":\"%s\",\"version\":\"%s\",\"mac\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"mem\":%lu,\"sls\":%d,\"dls\":%d,\"s\":[%s]}",
-    date_time_buffer, version, 
+  snprintf(variable_render_buffer, sizeof(state_variable), 
+    "{\"dt\":\"%s\",\"version\":\"%s\",\"mac\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"mem\":%lu,\"mmin\":%lu,\"sls\":%d,\"sla\":%lu,\"dls\":%d,\"dla\":%lu,\"dlf\":%d,\"spl\":%lu,\"pn\":%d,\"pt\":%.1f,\"s\":[%s]}",
+    getDateTime(state_variable_time), version, 
     mac_address[0], mac_address[1], mac_address[2], mac_address[3], mac_address[4], mac_address[5],
-    System.freeMemory(), state_log_stack.size(), data_log_stack.size(),
-    state_variable_buffer);
+    (unsigned long) System.freeMemory(), min_free_memory, (int) state_log_stack.size(), state_log_stack.getFrontAge() / 1000, 
+    (int) data_log_stack.size(), data_log_stack.getFrontAge() / 1000, (int) data_log_stack.getFreeBytes(),
+    (log_spool != NULL) ? (unsigned long) log_spool->getBacklog() : 0UL, (int) publish_n, publish_tokens, state_variable_buffer);
+  updateVariableSnapshot(state_variable, sizeof(state_variable));
+  state_variable_outdated = false;
+  state_variable_requested = false;
   if (debug_cloud) {
-    Serial.printf("DEBUG: updated state variable: %s\n", state_variable);
+    Serial.printf("DEBUG: assembled state variable: %s\n", state_variable);
   }
-  if (!Particle.connected()) {
-    Serial.println("WARNING: particle not (yet) connected, state variable only available when connected.");
+}
+
+String LoggerController::getStateVariable() {
+  state_variable_requested = true;
+  String snapshot;
+  SINGLE_THREADED_BLOCK() {
+    snapshot = state_variable;
   }
+  return(snapshot);
 }
 
 /*** particle webhook state log ***/
@@ -914,14 +1536,23 @@ void LoggerController::assembleMissedDataLog() {
   assembleStateLog();
 }
 
+void LoggerController::assembleMergedDataLog() {
+  command->reset();
+  strcpy(command->type, CMD_LOG_TYPE_DATA_MERGED);
+  char data[40];
+  snprintf(data, sizeof(data), "{\"k\":\"merged_data_logs\",\"v\":\"%d\"}", merged_data);
+  strcpy(command->data, data);
+  strcpy(command->msg, "lack of cloud connection and low memory lead to merged data logs (ml)");
+  assembleStateLog();
+}
+
 void LoggerController::assembleStateLog() {
   state_log[0] = 0;
   if (command->data[0] == 0) strcpy(command->data, "{}"); // empty data entry
   // id = Logger name, dt = log datetime, t = state log type, s = state change, m = message, n = notes
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
   int buffer_size = snprintf(state_log, sizeof(state_log),
      "{\"id\":\"%s\",\"dt\":\"%s\",\"t\":\"%s\",\"s\":[%s],\"m\":\"%s\",\"n\":\"%s\"}",
-     name, date_time_buffer, command->type, command->data, command->msg, command->notes);
+     name, getDateTime(), command->type, command->data, command->msg, command->notes);
   if (buffer_size < 0 || buffer_size >= sizeof(state_log)) {
     Serial.println("ERROR: state log buffer not large enough for state log");
     lcd->printLineTemp(1, "ERR: statelog too big");
@@ -929,40 +1560,94 @@ void LoggerController::assembleStateLog() {
   }
 }
 
-void LoggerController::queueStateLog() {
+uint16_t LoggerController::getDataSchemaId() {
+  uint16_t crc = 0xFFFF;
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    std::vector<LoggerData>& data = (*components_iter)->data;
+    for (int i = 0; i < data.size(); i++) {
+      crc = updateCRC16(crc, (const uint8_t*) &data[i].idx, sizeof(data[i].idx));
+      crc = updateCRC16(crc, data[i].getVariable());
+      crc = updateCRC16(crc, data[i].getUnits());
+    }
+  }
+  return(crc == 0 ? 1 : crc); // 0 = no schema logged yet
+}
+
+void LoggerController::queueDataSchemaLogs() {
+  // the schema lists index, key and units of all data (split across several state logs if necessary)
+  // sc = schema id referenced by packed data logs
+  data_schema = getDataSchemaId();
+  bool queued = true;
+  size_t header = snprintf(state_log, sizeof(state_log), "{\"id\":\"%s\",\"dt\":\"%s\",\"t\":\"%s\",\"s\":[{\"k\":\"sc\",\"v\":\"%04x\"}",
+    name, getDateTime(), CMD_LOG_TYPE_DATA_SCHEMA, data_schema);
+  char footer[50];
+  snprintf(footer, sizeof(footer), "],\"m\":\"packed data log format v%d\",\"n\":\"\"}", DATA_LOG_PACKED_VERSION);
+  char entry[2 * STRING_POOL_MAX_CHAR + 25];
+  size_t length = header;
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    std::vector<LoggerData>& data = (*components_iter)->data;
+    for (int i = 0; i < data.size(); i++) {
+      snprintf(entry, sizeof(entry), PATTERN_IKU_JSON, data[i].idx, data[i].getVariable(), data[i].getUnits());
+      if (length + 1 + strlen(entry) + strlen(footer) >= sizeof(state_log)) {
+        // state log full, queue it and continue in the next one
+        strcpy(state_log + length, footer);
+        queued = queueStateLog() && queued;
+        length = header;
+      }
+      state_log[length++] = ',';
+      strcpy(state_log + length, entry);
+      length += strlen(entry);
+    }
+  }
+  strcpy(state_log + length, footer);
+  queued = queueStateLog() && queued;
+  // only current once all parts are queued, otherwise the schema is logged again with the next data log
+  if (queued) data_schema_queued = data_schema;
+}
+
+bool LoggerController::queueStateLog() {
+  bool dropped = false;
   if (!startup_complete) {
     Serial.printlnf("WARNING: state log '%s' NOT queued because startup is not yet complete.", state_log);
   } else if (debug_webhooks) {
     Serial.printlnf("WARNING: state log '%s' NOT queued because in WEBHOOKS_DEBUG_ON mode.", state_log);
   } else {
-    state_log_stack.push_back(state_log);
-    if (debug_cloud) {
-      Serial.printlnf("DEBUG: added log #%d to state log stack: '%s'", state_log_stack.size(), state_log_stack.back().c_str());
+    bool queued = state_log_stack.fits(strlen(state_log));
+    uint32_t spool_address = spoolLog(LOG_SPOOL_STATE_LOG, state_log, queued);
+    if (queued) {
+      state_log_stack.push(state_log, spool_address);
+      if (debug_cloud) {
+        Serial.printlnf("DEBUG: added log #%d to state log stack: '%s'", (int) state_log_stack.size(), state_log_stack.back());
+      }
+    } else if (spool_address != LOG_SPOOL_NO_RECORD) {
+      Serial.printlnf("WARNING: state log '%s' only queued in the log spool because the state log queue is full.", state_log);
+    } else {
+      Serial.printlnf("WARNING: state log '%s' NOT queued because the state log queue is full.", state_log);
+      dropped = true;
     }
   }
   postStateVariable(); // update state variable stack info
+  return(!dropped);
 }
 
-void LoggerController::publishStateLog() {
+void LoggerController::publishStateLog(bool oldest) {
   
   if (!state_log_stack.empty()) {
 
-    // process from back to front (i.e. always latest log first) for speed and to avoid memory fragmentation
-    if (debug_cloud) {
-      Serial.printf("DEBUG: publishing last state log (#%d) to event '%s': '%s'... ", 
-        state_log_stack.size(), STATE_LOG_WEBHOOK, state_log_stack.back().c_str());
-    }
-    
-    bool success = Particle.publish(STATE_LOG_WEBHOOK, state_log_stack.back().c_str(), WITH_ACK);
-    if (debug_cloud) {
-      if (success) Serial.println("successful.");
-      else Serial.println("failed!");
-    }
-
-    if (success) {
-      state_log_stack.pop_back();
-      postStateVariable(); // update state variable stack info
-    }
+    // process from back to front (i.e. always latest log first) unless the oldest log is due
+    publish_queue_n = state_log_stack.size();
+    const char* log = oldest ? state_log_stack.front() : state_log_stack.back();
+    strcpy(publish_log, log);
+    publish_refs[0] = state_log_stack.getRef(log);
+    publish_times[0] = state_log_stack.getTime(log);
+    if (oldest) state_log_stack.popFront();
+    else state_log_stack.popBack();
+    publish_type = PUBLISH_STATE_LOG;
+    publish_webhook = STATE_LOG_WEBHOOK;
+    publish_n = 1;
+    startPublish();
 
   }
   
@@ -972,8 +1657,6 @@ void LoggerController::publishStateLog() {
 
 void LoggerController::updateDataVariable() {
   if (data_update_callback) data_update_callback();
-  data_variable_buffer[0] = 0; // reset buffer
-  assembleComponentsDataVariable();
   postDataVariable();
 }
 
@@ -986,24 +1669,98 @@ void LoggerController::assembleComponentsDataVariable() {
 }
 
 void LoggerController::addToDataVariableBuffer(char* info) {
-  if (data_variable_buffer[0] == 0) {
-    strncpy(data_variable_buffer, info, sizeof(data_variable_buffer));
+  // entry without change tracking --> assemble the rest of the buffer from here
+  if (!data_variable_rebuild) {
+    data_variable_rebuild = true;
+    data_variable_writer.truncate(data_variable_cursor);
+  }
+  data_variable_writer.appendElement(info);
+  data_variable_cursor = data_variable_writer.length;
+}
+
+void LoggerController::addToDataVariableBuffer(LoggerData& data) {
+  LoggerWriter& writer = data_variable_writer;
+  size_t start = data_variable_cursor + (data_variable_cursor > 0 ? 1 : 0); // after the separator
+  // the previous entry of this data is still at the cursor (no data were added or removed before it)
+  bool in_place = !data_variable_rebuild && data.info_pos >= 0 && data.info_pos + data_variable_shift == (int) start &&
+    start + data.info_length <= writer.length;
+  if (in_place && !data.info_outdated) {
+    // unchanged --> keep the entry
+    data.info_pos = start;
+    data_variable_cursor = start + data.info_length;
+    return;
+  }
+  data.assembleInfo(data_text, sizeof(data_text));
+  size_t n = strlen(data_text);
+  if (in_place && writer.length - data.info_length + n <= writer.size - 1) {
+    // changed --> replace the entry (moving the ones after it)
+    memmove(writer.buffer + start + n, writer.buffer + start + data.info_length, writer.length - start - data.info_length + 1);
+    memcpy(writer.buffer + start, data_text, n);
+    writer.length = writer.length - data.info_length + n;
+    data_variable_shift += (int) n - data.info_length;
   } else {
-    snprintf(data_variable_buffer, sizeof(data_variable_buffer),
-        "%s,%s", data_variable_buffer, info);
+    // new position or does not fit --> assemble the rest of the buffer from here
+    if (!data_variable_rebuild) {
+      data_variable_rebuild = true;
+      writer.truncate(data_variable_cursor);
+    }
+    if (!writer.appendElement(data_text)) {
+      data.info_pos = -1;
+      return;
+    }
   }
+  data.info_pos = start;
+  data.info_length = n;
+  data.info_outdated = false;
+  data_variable_cursor = start + n;
 }
 
 void LoggerController::postDataVariable() {
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
+  data_variable_time = Time.now();
+  data_variable_outdated = true;
+  if (!Particle.connected()) {
+    Serial.println("WARNING: particle not (yet) connected, data variable only available when connected.");
+  }
+}
+
+void LoggerController::renderDataVariable() {
+  data_variable_cursor = 0;
+  data_variable_shift = 0;
+  data_variable_rebuild = false;
+  assembleComponentsDataVariable();
+  // entries of data that no longer exist
+  if (!data_variable_rebuild && data_variable_cursor < data_variable_writer.length) {
+    data_variable_writer.truncate(data_variable_cursor);
+  }
+  if (data_variable_writer.overflow) {
+    Serial.println("ERROR: data variable buffer not large enough for all data");
+  }
   // dt = datetime, d = structured data
-  snprintf(data_variable, sizeof(data_variable), "{\"dt\":\"%s\",\"d\":[%s]}",
-    date_time_buffer, data_variable_buffer);
+  snprintf(variable_render_buffer, sizeof(data_variable), "{\"dt\":\"%s\",\"d\":[%s]}",
+    getDateTime(data_variable_time), data_variable_buffer);
+  updateVariableSnapshot(data_variable, sizeof(data_variable));
+  data_variable_outdated = false;
+  data_variable_requested = false;
   if (debug_cloud) {
-    Serial.printf("DEBUG: updated data variable: %s\n", data_variable);
+    Serial.printf("DEBUG: assembled data variable: %s\n", data_variable);
   }
-  if (!Particle.connected()) {
-    Serial.println("WARNING: particle not (yet) connected, data variable only available when connected.");
+}
+
+String LoggerController::getDataVariable() {
+  data_variable_requested = true;
+  String snapshot;
+  SINGLE_THREADED_BLOCK() {
+    snapshot = data_variable;
+  }
+  return(snapshot);
+}
+
+// the system thread can read a cloud variable at any time, it never sees a partially replaced one
+void LoggerController::updateVariableSnapshot(char* variable, size_t size) {
+  size_t length = strnlen(variable_render_buffer, size - 1);
+  SINGLE_THREADED_BLOCK() {
+    memcpy(variable, variable_render_buffer, length);
+    variable[length] = 0;
   }
 }
 
@@ -1014,10 +1771,9 @@ bool LoggerController::isTimeForDataLogAndClear() {
   if (state->data_logging_type == LOG_BY_TIME) {
     // go by time
     unsigned long log_period = state->data_logging_period * 1000;
-    if ((millis() - last_data_log) > log_period) {
+    if ((System.millis() - last_data_log) > log_period) {
       if (debug_data) {
-        Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
-        Serial.printf("DEBUG: triggering data log at %s (after %d seconds)\n", date_time_buffer, state->data_logging_period);
+        Serial.printf("DEBUG: triggering data log at %s (after %d seconds)\n", getDateTime(), state->data_logging_period);
       }
       return(true);
     }
@@ -1027,8 +1783,7 @@ bool LoggerController::isTimeForDataLogAndClear() {
     // go by read number
     if (data[0].getN() >= state->data_logging_period) {
       if (debug_data) {
-      Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
-      Serial.printf("INFO: triggering data log at %s (after %d reads)\n", date_time_buffer, state->data_logging_period);
+      Serial.printf("INFO: triggering data log at %s (after %d reads)\n", getDateTime(), state->data_logging_period);
       }
       return(true);
     }
@@ -1041,10 +1796,12 @@ bool LoggerController::isTimeForDataLogAndClear() {
 }
 
 void LoggerController::restartLastDataLog() {
-  last_data_log = millis();
+  last_data_log = System.millis();
 }
 
 void LoggerController::clearData(bool clear_persistent) {
+  // the data variable shows the data of the last update, assemble it before the data is cleared (once per data log)
+  if (data_variable_outdated) renderDataVariable();
   // clear data for components
   std::vector<LoggerComponent*>::iterator components_iter = components.begin();
   for(; components_iter != components.end(); components_iter++) {
@@ -1060,6 +1817,10 @@ void LoggerController::logData() {
     override_data_log = true;
   }
   if (state->data_logging | override_data_log) {
+      // packed data logs refer to the data schema which has to be logged first (and again whenever it changes)
+      if (pack_data_logs && getDataSchemaId() != data_schema_queued) {
+        queueDataSchemaLogs();
+      }
       // log data for components
       std::vector<LoggerComponent*>::iterator components_iter = components.begin();
       for(; components_iter != components.end(); components_iter++) {
@@ -1072,9 +1833,132 @@ void LoggerController::logData() {
   }
 }
 
+/*** particle webhook data rollup logs ***/
+
+void LoggerController::updateDataRollups() {
+  for (int r = 0; r < n_data_rollups; r++) {
+    if ((System.millis() - data_rollups[r].last_log) > (uint64_t) data_rollups[r].period * 1000) {
+      if (debug_data) {
+        Serial.printf("DEBUG: completed %lu second data rollup window at %s\n", data_rollups[r].period, getDateTime());
+      }
+      if (data_rollups[r].logging) logRollupData(r);
+      data_rollups[r].last_log = System.millis();
+      clearRollupData(r);
+    }
+  }
+}
+
+void LoggerController::logRollupData(int rollup) {
+  if (state->data_logging | debug_webhooks) {
+    if (pack_data_logs && getDataSchemaId() != data_schema_queued) {
+      queueDataSchemaLogs();
+    }
+    data_log_rollup = rollup;
+    std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+    for(; components_iter != components.end(); components_iter++) {
+      (*components_iter)->logRollupData(rollup);
+    }
+    data_log_rollup = -1;
+  }
+}
+
+void LoggerController::clearRollupData(int rollup) {
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    (*components_iter)->clearRollupData(rollup);
+  }
+}
+
+/*** particle webhook capture logs ***/
+
+void LoggerController::updateCaptureDownload() {
+  // the normal data logs go first
+  if (!data_log_stack.empty()) return;
+
+  // chunk of samples {"i":index,"v":value,"to":ms back from the log reference time} (always JSON, the data schema does not cover it)
+  LoggerCapture* capture = capture_download->capture;
+  resetDataLog();
+  data_log_capture = true;
+  char sample[60];
+  char value[20];
+  uint16_t start = capture->download_pos;
+  uint16_t end = start;
+  for (; end < capture->n; end++) {
+    uint16_t i = end;
+    int decimals = 0;
+    for (int j = 0; j < capture_download->data.size(); j++) {
+      if (capture_download->data[j].idx == capture->getIndex(i)) decimals = capture_download->data[j].getDecimals();
+    }
+    print_to_decimals(value, sizeof(value), capture->getValue(i), decimals);
+    snprintf(sample, sizeof(sample), "{\"i\":%d,\"v\":%s,\"to\":%lu}", 
+      capture->getIndex(i), value, (unsigned long) ((uint32_t) data_log_time - capture->getTime(i)));
+    if (!addToDataLogBuffer(sample)) break;
+  }
+  // the samples only count as downloaded once the chunk is queued, a chunk that cannot be assembled (no sample fits or the
+  // log is too long) or queued (the data log queue was empty, so it will not fit later either) stops the download
+  const char* error = NULL;
+  if (end == start) error = "has no room for a sample";
+  else if (!finalizeDataLog(false)) error = "could not be assembled";
+  else if (!queueDataLog()) error = "does not fit into the data log queue";
+  data_log_capture = false;
+  if (error != NULL) {
+    Serial.printlnf("ERROR: capture chunk #%d of component '%s' %s, download stopped at sample %d of %d",
+      capture_chunk, capture_download->id, error, capture->download_pos - (capture->n - capture->download_n), capture->download_n);
+    capture->release();
+    capture_download = NULL;
+    return;
+  }
+  capture->download_pos = end;
+  if (debug_cloud) {
+    Serial.printlnf("DEBUG: queued capture chunk #%d of component '%s' with samples %d to %d", 
+      capture_chunk, capture_download->id, start, end - 1);
+  }
+  capture_chunk++;
+
+  // done?
+  if (!capture->isDownloading()) {
+    Serial.printlnf("INFO: finished capture download of component '%s' in %d chunks", capture_download->id, capture_chunk);
+    capture->release();
+    capture_download = NULL;
+  }
+}
+
 void LoggerController::resetDataLog() {
   data_log[0] = 0;
-  data_log_buffer[0] = 0;
+  data_log_time = System.millis();
+  data_log_writer.reset();
+  packed_data_log_size = 0;
+  data_log_reserve = 0;
+}
+
+// everything of the data log before the data, {"id":"name"[window],"dt":"...","ms":...[,"to":...]
+int LoggerController::printDataLogHeader(char* target, size_t size, bool use_common_time, unsigned long common_time) {
+  // ms = epoch ms of the log's reference time (the time offsets count back from it)
+  char epoch_ms[TIMESTAMP_EPOCH_MAX_CHAR];
+  LoggerTimestamp::printInteger(epoch_ms, getEpochMillis(data_log_time));
+  // w = window of a rollup data log (in seconds, not included for the data log period)
+  // cap = component of a capture chunk, ch = chunk number, cn = number of samples in the download (capture chunks are never merged)
+  char window[50] = "";
+  if (data_log_rollup >= 0) snprintf(window, sizeof(window), ",\"w\":%lu", data_rollups[data_log_rollup].period);
+  if (data_log_capture) snprintf(window, sizeof(window), ",\"cap\":\"%s\",\"ch\":%d,\"cn\":%d", 
+    capture_download->id, capture_chunk, capture_download->capture->download_n);
+  // id = Logger name, dt = log datetime, ms = log reference time, to = time offset from log reference time (global)
+  return(use_common_time ?
+    snprintf(target, size, "{\"id\":\"%s\"%s,\"dt\":\"%s\",\"ms\":%s,\"to\":%lu", name, window, getDateTime(), epoch_ms, common_time) :
+    snprintf(target, size, "{\"id\":\"%s\"%s,\"dt\":\"%s\",\"ms\":%s", name, window, getDateTime(), epoch_ms));
+}
+
+// characters the data log needs besides its data: header (with the longest common time offset), footer and \0
+// (depends on the logger name, rollup window and capture chunk, determined with the first data of each log)
+size_t LoggerController::getDataLogReserve() {
+  if (data_log_reserve == 0) {
+    int header = printDataLogHeader(NULL, 0, true, (unsigned long) UINT32_MAX);
+    int footer = (pack_data_logs && !data_log_capture) ?
+      snprintf(NULL, 0, ",\"pv\":%d,\"sc\":\"%04x\",\"p\":\"\"}", DATA_LOG_PACKED_VERSION, data_schema) : 
+      (int) strlen(",\"d\":[]}");
+    data_log_reserve = (header > 0 ? header : 0) + footer + 1;
+  }
+  return(data_log_reserve);
 }
 
 bool LoggerController::addToDataLogBuffer(char* info) {
@@ -1082,40 +1966,45 @@ bool LoggerController::addToDataLogBuffer(char* info) {
   // debug
   if (debug_data) Serial.printf("DEBUG: trying to add '%s' to data log... ", info);
 
-  // characters reserved for rest of data log
-  const uid_t reserve = 50;
-  if (strlen(data_log_buffer) + strlen(info) + reserve >= sizeof(data_log)) {
+  // data with separator plus the rest of the data log
+  size_t length = data_log_writer.length + (data_log_writer.empty() ? 0 : 1) + strlen(info);
+  if (length + getDataLogReserve() > sizeof(data_log)) {
     // not enough space in the data log to add more to the buffer
     if (debug_data) Serial.println("but log is at the size limit.");
     return(false);
   }
 
   // still enough space
-  if (data_log_buffer[0] == 0) {
-    // buffer empty, start from scratch
-    if (debug_data) Serial.println("success (first data).");
-    strncpy(data_log_buffer, info, sizeof(data_log_buffer));
-  } else {
-    // concatenate existing buffer with new info
-    if (debug_data) Serial.println("success.");
-    snprintf(data_log_buffer, sizeof(data_log_buffer),
-        "%s,%s", data_log_buffer, info);
+  if (debug_data) Serial.println(data_log_writer.empty() ? "success (first data)." : "success.");
+  return(data_log_writer.appendElement(info));
+}
+
+bool LoggerController::addToPackedDataLogBuffer(const uint8_t* record, size_t size) {
+  // base64 encoding turns every 3 bytes into 4 characters
+  size_t max_size = (sizeof(data_log) - getDataLogReserve()) / 4 * 3;
+  if (packed_data_log_size + size > sizeof(packed_data_log_buffer) || packed_data_log_size + size > max_size) {
+    // not enough space in the data log to add more to the buffer
+    if (debug_data) Serial.printlnf("DEBUG: packed data log is at the size limit (%d bytes), record NOT added.", (int) packed_data_log_size);
+    return(false);
   }
+  memcpy(packed_data_log_buffer + packed_data_log_size, record, size);
+  packed_data_log_size += size;
+  if (debug_data) Serial.printlnf("DEBUG: added %d byte record to packed data log (now %d bytes).", (int) size, (int) packed_data_log_size);
   return(true);
 }
 
 bool LoggerController::finalizeDataLog(bool use_common_time, unsigned long common_time) {
-  // data
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
-  int buffer_size;
-  if (use_common_time) {
-    // id = Logger name, dt = log datetime, to = time offset from log datetime (global), d = structured data
-    buffer_size = snprintf(data_log, sizeof(data_log), "{\"id\":\"%s\",\"dt\":\"%s\",\"to\":%lu,\"d\":[%s]}", 
-      name, date_time_buffer, common_time, data_log_buffer);
-  } else {
-    // indivudal time
-    buffer_size = snprintf(data_log, sizeof(data_log), "{\"id\":\"%s\",\"dt\":\"%s\",\"d\":[%s]}", 
-      name, date_time_buffer, data_log_buffer);
+  int buffer_size = printDataLogHeader(data_log, sizeof(data_log), use_common_time, common_time);
+  if (buffer_size >= 0 && (size_t) buffer_size < sizeof(data_log)) {
+    if (pack_data_logs && !data_log_capture) {
+      // pv = packed format version, sc = data schema id, p = packed data (base64)
+      encodeBase64(data_log_buffer, sizeof(data_log_buffer), packed_data_log_buffer, packed_data_log_size);
+      buffer_size += snprintf(data_log + buffer_size, sizeof(data_log) - buffer_size, ",\"pv\":%d,\"sc\":\"%04x\",\"p\":\"%s\"}", 
+        DATA_LOG_PACKED_VERSION, data_schema, data_log_buffer);
+    } else {
+      // d = structured data
+      buffer_size += snprintf(data_log + buffer_size, sizeof(data_log) - buffer_size, ",\"d\":[%s]}", data_log_buffer);
+    }
   }
   if (buffer_size < 0 || buffer_size >= sizeof(data_log)) {
     Serial.println("ERROR: data log buffer not large enough for data log - this should NOT be possible to happen");
@@ -1125,60 +2014,269 @@ bool LoggerController::finalizeDataLog(bool use_common_time, unsigned long commo
   return(true);
 }
 
-void LoggerController::queueDataLog() {
+bool LoggerController::queueDataLog() {
+  bool dropped = false;
   if (strlen(data_log) == 0) {
     Serial.println("WARNING: no data log queued because there is none.");
   } else if (!startup_complete) {
     Serial.printlnf("WARNING: data log '%s' NOT queued because startup is not yet complete.", data_log);
   } else if (debug_webhooks) {
     Serial.printlnf("WARNING: data log '%s' NOT queued because in WEBHOOKS_DEBUG_ON mode.", data_log);
-  } else if (System.freeMemory() < memory_reserve) {
-    out_of_memory = true;
-    missed_data++;
-    Serial.printlnf("WARNING: data log '%s' NOT queued because free memory < memory reserve (%d bytes), total %d data logs missed.", 
-      data_log, memory_reserve, missed_data);
   } else {
-    out_of_memory = false;
-    data_log_stack.push_back(data_log);
-    if (debug_cloud) {
-      Serial.printlnf("DEBUG: added log #%d to data log stack: '%s'", data_log_stack.size(), data_log_stack.back().c_str());
+    bool queued = data_log_stack.fits(strlen(data_log));
+    uint32_t spool_address = spoolLog(LOG_SPOOL_DATA_LOG, data_log, queued);
+    if (!queued && spool_address == LOG_SPOOL_NO_RECORD && merge_data_logs) {
+      // make room by merging older data logs
+      while (!(queued = data_log_stack.fits(strlen(data_log))) && mergeQueuedDataLogs());
+      if (queued && debug_cloud) {
+        Serial.printlnf("DEBUG: merged queued data logs to make room (%d merges so far)", merged_data);
+      }
+    }
+    if (queued) {
+      out_of_memory = false;
+      data_log_stack.push(data_log, spool_address);
+      if (debug_cloud) {
+        Serial.printlnf("DEBUG: added log #%d to data log stack: '%s'", (int) data_log_stack.size(), data_log_stack.back());
+      }
+    } else if (spool_address != LOG_SPOOL_NO_RECORD) {
+      out_of_memory = false;
+      if (debug_cloud) {
+        Serial.printlnf("DEBUG: data log queue is full, added log #%lu to log spool: '%s'", (unsigned long) log_spool->getBacklog(), data_log);
+      }
+    } else {
+      out_of_memory = true;
+      missed_data++;
+      Serial.printlnf("WARNING: data log '%s' NOT queued because the data log queue is full (%d bytes free), total %d data logs missed.", 
+        data_log, (int) data_log_stack.getFreeBytes(), missed_data);
+      dropped = true;
     }
   }
   postStateVariable(); // update state variable stack info
+  return(!dropped);
+}
+
+// merge the oldest pair of neighbouring data logs that stand for the same number of original logs (like a binary counter)
+// so the resolution of the queued data decreases with its age (falls back to the oldest pair)
+bool LoggerController::mergeQueuedDataLogs() {
+  for (const char* log = data_log_stack.front(); log != NULL; log = data_log_stack.after(log)) {
+    const char* next = data_log_stack.after(log);
+    if (next == NULL) break;
+    const char* log_ml = findJsonValue(log, log + strcspn(log, "["), "ml");
+    const char* next_ml = findJsonValue(next, next + strcspn(next, "["), "ml");
+    if ((log_ml ? atoi(log_ml) : 1) == (next_ml ? atoi(next_ml) : 1) && mergeDataLogPair(log)) return(true);
+  }
+  return(mergeDataLogPair(data_log_stack.front()));
+}
+
+bool LoggerController::mergeDataLogPair(const char* older) {
+  const char* newer = data_log_stack.after(older);
+  if (newer == NULL) return(false);
+  unsigned long newer_time = data_log_stack.getTime(newer);
+  if (assembleDataLogMerge(older, newer, newer_time - data_log_stack.getTime(older)) == 0) return(false);
+  uint32_t older_ref = data_log_stack.getRef(older);
+  uint32_t newer_ref = data_log_stack.getRef(newer);
+  if (!data_log_stack.replacePair(older, data_log_batch, LOG_QUEUE_NO_REF, newer_time)) return(false);
+  // the merged log replaces the spooled originals
+  if (log_spool != NULL) {
+    log_spool->markPublished(older_ref);
+    log_spool->markPublished(newer_ref);
+  }
+  merged_data++;
+  return(true);
+}
+
+// merged log: header of the newer log (incl. its reference time ms) with the combined common time offset and number of merged logs (ml),
+// then the data of both logs with the same index combined (exact means and standard deviations of the logged values)
+size_t LoggerController::assembleDataLogMerge(const char* older, const char* newer, unsigned long log_time_difference) {
+  // same logger and format
+  const char* older_dt = strstr(older, "\"dt\":\"");
+  const char* newer_dt = strstr(newer, "\"dt\":\"");
+  if (older_dt == NULL || newer_dt == NULL || older_dt - older != newer_dt - newer || strncmp(older, newer, newer_dt - newer) != 0) return(0);
+  bool packed = strstr(newer, "\"pv\":") != NULL;
+  const char* data_key = packed ? "\"pv\":" : "\"d\":[";
+  const char* older_data = strstr(older, data_key);
+  const char* newer_data = strstr(newer, data_key);
+  if (older_data == NULL || newer_data == NULL) return(0);
+  const char* older_packed = packed ? strstr(older_data, "\"p\":\"") : NULL;
+  const char* newer_packed = packed ? strstr(newer_data, "\"p\":\"") : NULL;
+  if (packed && (data_log_merge_buffer == NULL || older_packed == NULL || newer_packed == NULL || 
+      older_packed - older_data != newer_packed - newer_data || strncmp(older_data, newer_data, newer_packed - newer_data) != 0))
+    return(0); // different packed format version or data schema
+  const char* older_to = findJsonValue(older, older_data, "to");
+  const char* newer_to = findJsonValue(newer, newer_data, "to");
+  if ((older_to == NULL) != (newer_to == NULL)) return(0);
+  const char* older_ml = findJsonValue(older, older_data, "ml");
+  const char* newer_ml = findJsonValue(newer, newer_data, "ml");
+  const char* older_ms = findJsonValue(older, older_data, "ms");
+  const char* newer_ms = findJsonValue(newer, newer_data, "ms");
+  if (older_ms != NULL && newer_ms != NULL) {
+    // exact difference of the reference times
+    log_time_difference = strtoull(newer_ms, NULL, 10) - strtoull(older_ms, NULL, 10);
+  }
+
+  // data records
+  LoggerDataRecordReader older_records, newer_records;
+  uint8_t* merged_packed = data_log_merge_buffer + 2 * DATA_LOG_PACKED_MAX_BYTES;
+  if (packed) {
+    older_packed += 5;
+    newer_packed += 5;
+    older_records.setPackedData(data_log_merge_buffer, 
+      decodeBase64(data_log_merge_buffer, DATA_LOG_PACKED_MAX_BYTES, older_packed, strcspn(older_packed, "\"")));
+    newer_records.setPackedData(data_log_merge_buffer + DATA_LOG_PACKED_MAX_BYTES, 
+      decodeBase64(data_log_merge_buffer + DATA_LOG_PACKED_MAX_BYTES, DATA_LOG_PACKED_MAX_BYTES, newer_packed, strcspn(newer_packed, "\"")));
+  } else {
+    older_records.setJsonData(older_data + 5, older_data + strcspn(older_data, "]"));
+    newer_records.setJsonData(newer_data + 5, newer_data + strcspn(newer_data, "]"));
+  }
+
+  // common time offset (weighted by the number of values)
+  LoggerDataRecord record, match;
+  RunningStats older_common, newer_common;
+  while (older_records.next(record)) older_common.merge(record.value);
+  while (newer_records.next(record)) newer_common.merge(record.value);
+  if (older_common.n == 0 || newer_common.n == 0) return(0); // no valid data
+  older_common.mean = (older_to != NULL) ? atof(older_to) + log_time_difference : 0;
+  newer_common.mean = (newer_to != NULL) ? atof(newer_to) : 0;
+  newer_common.M2 = older_common.M2 = 0;
+  newer_common.merge(older_common);
+
+  // header
+  size_t size = sizeof(data_log_batch);
+  size_t length = strchr(newer_dt + 6, '"') + 1 - newer;
+  memcpy(data_log_batch, newer, length);
+  if (newer_ms != NULL) {
+    size_t ms_length = strcspn(newer_ms, ",}");
+    if (length + 6 + ms_length >= size) return(0);
+    memcpy(data_log_batch + length, ",\"ms\":", 6);
+    memcpy(data_log_batch + length + 6, newer_ms, ms_length);
+    length += 6 + ms_length;
+  }
+  if (newer_to != NULL) length += snprintf(data_log_batch + length, size - length, ",\"to\":%lu", (unsigned long) round(newer_common.mean));
+  length += snprintf(data_log_batch + length, size - length, ",\"ml\":%d", (older_ml ? atoi(older_ml) : 1) + (newer_ml ? atoi(newer_ml) : 1));
+  if (packed) {
+    if (length + 1 + (newer_packed - newer_data) >= size) return(0);
+    data_log_batch[length++] = ',';
+    memcpy(data_log_batch + length, newer_data, newer_packed - newer_data);
+    length += newer_packed - newer_data;
+  } else {
+    length += snprintf(data_log_batch + length, size - length, ",\"d\":[");
+  }
+  if (length >= size) return(0);
+
+  // data: newer records (merged with the older record of the same index) followed by older records not in the newer log
+  size_t packed_size = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    LoggerDataRecordReader& records = (pass == 0) ? newer_records : older_records;
+    LoggerDataRecordReader& others = (pass == 0) ? older_records : newer_records;
+    records.restart();
+    while (records.next(record)) {
+      bool found = false;
+      others.restart();
+      while (!found && others.next(match)) found = (match.idx == record.idx);
+      if (pass == 0 && found) {
+        record.merge(match, log_time_difference);
+      } else if (pass == 1 && found) {
+        continue; // already merged
+      } else if (pass == 1) {
+        record.time_offset.mean += log_time_difference;
+      }
+      if (packed) {
+        size_t record_size = record.assemblePackedLog(merged_packed + packed_size, DATA_LOG_PACKED_MAX_BYTES - packed_size);
+        if (record_size == 0) return(0);
+        packed_size += record_size;
+      } else {
+        if (data_log_batch[length - 1] != '[') data_log_batch[length++] = ',';
+        size_t record_length = (length + 3 < size) ? record.assembleLog(data_log_batch + length, size - length - 2) : 0;
+        if (record_length == 0) return(0);
+        length += record_length;
+      }
+    }
+  }
+
+  // close
+  if (packed) {
+    if (!encodeBase64(data_log_batch + length, size - length - 2, merged_packed, packed_size)) return(0);
+    length += getBase64Length(packed_size);
+    strcpy(data_log_batch + length, "\"}");
+  } else {
+    strcpy(data_log_batch + length, "]}");
+  }
+  return(length + 2);
 }
 
-void LoggerController::publishDataLog() {
+size_t LoggerController::assembleDataLogBatch(bool oldest) {
+  // logs from this logger all start with the same id which the batch lists only once
+  char id_prefix[sizeof(name) + 10];
+  size_t id_prefix_length = snprintf(id_prefix, sizeof(id_prefix), "{\"id\":\"%s\",", name);
+  size_t length = snprintf(data_log_batch, sizeof(data_log_batch), "{\"v\":%d,\"id\":\"%s\",\"l\":[", DATA_LOG_BATCH_VERSION, name);
+
+  // add logs from back to front (i.e. latest first) or from the oldest log forward as long as they fit
+  size_t batch_n = 0;
+  const char* log = oldest ? data_log_stack.front() : data_log_stack.back();
+  for (; log != NULL && batch_n < PUBLISH_MAX_LOGS; log = oldest ? data_log_stack.after(log) : data_log_stack.before(log)) {
+    if (strncmp(log, id_prefix, id_prefix_length) != 0) break; // logged under a different name
+    const char* entry = log + id_prefix_length;
+    size_t entry_length = strlen(entry);
+    // separator + '{' + entry + closing ']}' + \0
+    if (length + (batch_n > 0) + 1 + entry_length + 3 > sizeof(data_log_batch)) break;
+    if (batch_n > 0) data_log_batch[length++] = ',';
+    data_log_batch[length++] = '{';
+    memcpy(data_log_batch + length, entry, entry_length);
+    length += entry_length;
+    batch_n++;
+  }
+  strcpy(data_log_batch + length, "]}");
+  return(batch_n);
+}
+
+void LoggerController::publishDataLog(bool oldest) {
   
   if (!data_log_stack.empty()) {
 
-    size_t log_n = data_log_stack.size();
-
-    // process from back to front (i.e. always latest log first) for speed and to avoid memory fragmentation
-    if (debug_cloud) {
-      Serial.printf("DEBUG: publishing last data log (#%d) to event '%s': '%s'... ", 
-        log_n, DATA_LOG_WEBHOOK, data_log_stack.back().c_str());
+    publish_queue_n = data_log_stack.size();
+
+    // process from back to front (i.e. always latest log first) unless the oldest log is due
+    publish_webhook = DATA_LOG_WEBHOOK;
+    publish_n = 1;
+    if (batch_data_logs && publish_queue_n > 1) {
+      size_t batch_n = assembleDataLogBatch(oldest);
+      if (batch_n > 1) {
+        publish_webhook = DATA_LOG_BATCH_WEBHOOK;
+        publish_n = batch_n;
+        strcpy(publish_log, data_log_batch);
+      }
     }
-
-    // particle is connected, try to publish the latest log
-    bool success = Particle.publish(DATA_LOG_WEBHOOK, data_log_stack.back().c_str(), WITH_ACK);
-    
-    if (debug_cloud) {
-      if (success) Serial.println("successful.");
-      else Serial.println("failed!");
+    if (publish_n == 1) {
+      strcpy(publish_log, oldest ? data_log_stack.front() : data_log_stack.back());
     }
 
-    if (success) {
-      (log_n > 1) ?
-        snprintf(lcd_buffer, sizeof(lcd_buffer), "INFO: data log %d sent", log_n) :
-        snprintf(lcd_buffer, sizeof(lcd_buffer), "INFO: data log sent");
-      lcd->printLineTemp(1, lcd_buffer);
-      data_log_stack.pop_back();
-      postStateVariable(); // update state variable stack info
-    } else {
-      snprintf(lcd_buffer, sizeof(lcd_buffer), "ERR: data log %d error", log_n);
-      lcd->printLineTemp(1, lcd_buffer);
+    // the logs leave the queue, they are in the publish slot until the publish succeeds
+    for (size_t i = 0; i < publish_n; i++) {
+      const char* log = oldest ? data_log_stack.front() : data_log_stack.back();
+      publish_refs[i] = data_log_stack.getRef(log);
+      publish_times[i] = data_log_stack.getTime(log);
+      if (oldest) data_log_stack.popFront();
+      else data_log_stack.popBack();
     }
+    publish_type = PUBLISH_DATA_LOG;
+    startPublish();
 
   }
   
 }
+
+void LoggerController::publishSpoolLog() {
+
+  uint8_t type;
+  if (log_spool != NULL && log_spool->nextLog(publish_log, sizeof(publish_log), &type)) {
+
+    // process from oldest to newest (spool is drained in order), the log stays in the spool until the publish succeeds
+    publish_queue_n = log_spool->getBacklog();
+    publish_type = PUBLISH_SPOOL_LOG;
+    publish_webhook = (type == LOG_SPOOL_STATE_LOG) ? STATE_LOG_WEBHOOK : DATA_LOG_WEBHOOK;
+    publish_n = 1;
+    startPublish();
+
+  }
+
+}
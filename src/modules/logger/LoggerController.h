@@ -1,11 +1,17 @@
 #pragma once
 #include <vector>
 #include "LoggerUtils.h"
+#include "LoggerWriter.h"
 #include "LoggerCommand.h"
 #include "LoggerDisplay.h"
+#include "LoggerLogQueue.h"
+#include "LoggerLogSpool.h"
+#include "LoggerPublishStats.h"
+#include "LoggerTimestamp.h"
 
 /*** time sync ***/
 #define ONE_DAY_MILLIS (24 * 60 * 60 * 1000)
+#define EPOCH_ANCHOR_TOLERANCE 100 // ms the millis to epoch ms mapping may run ahead of the second rollovers before it is re-anchored
 
 /*** spark cloud constants ***/
 #define CMD_ROOT              "device" // command root (i.e. registered particle call function)
@@ -15,8 +21,39 @@
 #define STATE_LOG_MAX_CHAR    621  // spark.publish is limited to 622 bytes of device OS 0.8.0 (previously just 255)
 #define DATA_INFO_VARIABLE    "data" // name of the particle exposed data variable
 #define DATA_INFO_MAX_CHAR    621 // how long is the data information maximally
+#define DATA_TEXT_MAX_CHAR    200 // how long the text of a single data entry is maximally
+#define PUBLISH_INFO_VARIABLE "publish" // name of the particle exposed publish statistics variable
+#define PUBLISH_INFO_MAX_CHAR 621 // how long is the publish statistics information maximally
+#define VARIABLE_RENDER_MAX_CHAR 621 // the longest of the above (variables are rendered into one buffer before they are replaced)
 #define DATA_LOG_WEBHOOK      "data_log"  // name of the webhook to Logger data log
 #define DATA_LOG_MAX_CHAR     621  // spark.publish is limited to 622 bytes of device OS 0.8.0 (previously just 255)
+#define DATA_LOG_BATCH_WEBHOOK  "data_logs" // name of the webhook for batches of data logs (see batchDataLogs())
+#define DATA_LOG_BATCH_VERSION  1 // batch format version: {"v":1,"id":"name","l":[{data log without id},...]}
+#define DATA_LOG_PACKED_VERSION 3 // packed data log format version (see packDataLogs())
+#define DATA_LOG_PACKED_MAX_BYTES ((DATA_LOG_MAX_CHAR - 140) / 4 * 3) // packed data that fits into a data log after base64 encoding
+
+/*** data rollups ***/
+#define DATA_ROLLUPS_MAX      3 // how many rollup windows there can be (see addDataRollup())
+
+/*** log queues ***/
+#define STATE_LOG_QUEUE_SIZE  3000 // bytes reserved for queued state logs
+#define DATA_LOG_QUEUE_SIZE   20000 // default bytes preallocated for queued data logs (see setDataLogQueueSize())
+#define DATA_LOG_QUEUE_MIN    2000 // smallest acceptable data log queue in bytes (if the requested size is not available in one piece)
+#define MEMORY_CHECK_PERIOD   1000 // how often the lowest free memory is checked (in ms)
+
+/*** publish scheduling ***/
+#define PUBLISH_RATE          1.0 // publish tokens per second (device OS allows 1 event per second on average)
+#define PUBLISH_BURST         4 // publish token bucket size (device OS allows bursts of up to 4 events)
+#define PUBLISH_STRIDE        840 // stride scheduling: a queue advances by PUBLISH_STRIDE / weight per publish
+#define PUBLISH_MAX_LOGS      32 // most logs published in one event (batches)
+#define PUBLISH_NONE          0 // publish slot: empty
+#define PUBLISH_STATE_LOG     1 // publish slot: state log
+#define PUBLISH_DATA_LOG      2 // publish slot: data log(s)
+#define PUBLISH_SPOOL_LOG     3 // publish slot: log from the spool
+#define STATE_LOG_WEIGHT      3 // share of publishes for state logs when both queues have logs
+#define DATA_LOG_WEIGHT       1 // share of publishes for data logs when both queues have logs
+#define STATE_LOG_MAX_AGE     (10 * 60 * 1000) // oldest queued state log gets priority once it is older than this (ms, 0 = no limit)
+#define DATA_LOG_MAX_AGE      (60 * 60 * 1000) // oldest queued data log gets priority once it is older than this (ms, 0 = no limit)
 
 /*** commands ***/
 // return codes:
@@ -58,6 +95,10 @@
 #define CMD_LOG_TYPE_STATE_UNCHANGED        "state unchanged"
 #define CMD_LOG_TYPE_STATE_UNCHANGED_SHORT  "SAME"
 #define CMD_LOG_TYPE_STARTUP                "startup"
+#define CMD_LOG_TYPE_DATA_SCHEMA            "data schema"
+#define CMD_LOG_TYPE_DATA_MERGED            "data merged"
+#define CMD_LOG_TYPE_PUBLISH_STATS          "publish stats"
+#define CMD_LOG_TYPE_UPDATE_STATS           "update stats"
 
 // locking
 #define CMD_LOCK            "lock" // device "lock on/off [notes]" : locks/unlocks the Logger
@@ -104,6 +145,25 @@
 // paging
 #define CMD_PAGE       "page" // device "page [#]" : switch to the next page (or a specific page number if provided)
 
+// publish statistics
+#define CMD_PUBLISH_STATS          "publish-stats" // device "publish-stats report/reset [notes]" : queue a state log with the publish statistics
+  #define CMD_PUBLISH_STATS_REPORT "report" // only report
+  #define CMD_PUBLISH_STATS_RESET  "reset" // report and start over
+
+// component update statistics
+#define CMD_UPDATE_STATS           "update-stats" // device "update-stats report/reset [notes]" : queue a state log with the update statistics of the components
+  #define CMD_UPDATE_STATS_REPORT  "report" // only report
+  #define CMD_UPDATE_STATS_RESET   "reset" // report and start over
+
+// data rollups
+#define CMD_DATA_ROLLUP          "rollup" // device "rollup number unit on/off [notes]" : turns data logging of a rollup window on/off (e.g. "rollup 1 h on", see addDataRollup())
+  #define CMD_DATA_ROLLUP_ON     "on"
+  #define CMD_DATA_ROLLUP_OFF    "off"
+
+// raw sample capture
+#define CMD_DATA_CAPTURE         "capture" // device "capture component [number unit] [notes]" : freeze and download the raw samples of the last number unit (all if not provided) from the capture of a component (e.g. "capture OD 2 m", see LoggerComponent::enableCapture())
+  #define CMD_DATA_CAPTURE_UNITS "samples"
+
 
 /*** reset codes ***/
 #define RESET_UNDEF    1
@@ -252,6 +312,22 @@ static void getStateDataReadingPeriodText(int reading_period, char* target, int
   }
 }
 
+// data rollup logging (any pattern), the key includes the window period (e.g. "rollup-1h")
+static void getStateDataRollupText(unsigned long period, bool logging, char* target, int size, char* pattern, bool include_key = true) {
+  char key[20];
+  if (period % 86400 == 0) snprintf(key, sizeof(key), "%s-%lu%s", CMD_DATA_ROLLUP, period / 86400, CMD_TIME_DAY);
+  else if (period % 3600 == 0) snprintf(key, sizeof(key), "%s-%lu%s", CMD_DATA_ROLLUP, period / 3600, CMD_TIME_HR);
+  else if (period % 60 == 0) snprintf(key, sizeof(key), "%s-%lu%s", CMD_DATA_ROLLUP, period / 60, CMD_TIME_MIN);
+  else snprintf(key, sizeof(key), "%s-%lu%s", CMD_DATA_ROLLUP, period, CMD_TIME_SEC);
+  getStateBooleanText(key, logging, CMD_DATA_ROLLUP_ON, CMD_DATA_ROLLUP_OFF, target, size, pattern, include_key);
+}
+
+// data rollup logging (standard patterns)
+static void getStateDataRollupText(unsigned long period, bool logging, char* target, int size, bool value_only = false) {
+  if (value_only) getStateDataRollupText(period, logging, target, size, PATTERN_V_SIMPLE, false);
+  else getStateDataRollupText(period, logging, target, size, PATTERN_KV_JSON_QUOTED, true);
+}
+
 /*** watchdog ***/
 
 static void watchdogHandler() {
@@ -262,6 +338,14 @@ static void watchdogHandler() {
 
 // forward declaration for component
 class LoggerComponent;
+struct LoggerData;
+
+// rollup window: an additional averaging window of all data with its own log period (see addDataRollup())
+struct LoggerDataRollup {
+  unsigned long period = 0; // window length (in seconds)
+  bool logging = true; // whether the windows are data logged (see CMD_DATA_ROLLUP)
+  uint64_t last_log = 0; // System.millis() when the current window started
+};
 
 // controller class
 class LoggerController {
@@ -280,7 +364,14 @@ class LoggerController {
     bool reset = false;
     
     // time sync
-    unsigned long last_sync = 0;
+    uint64_t last_sync = 0;
+
+    // System.millis() to epoch ms mapping (anchored at a rollover of the second, again after each time sync)
+    bool epoch_anchored = false;
+    bool epoch_resync = false; // time sync requested, re-anchor once it is done
+    time_t epoch_second = 0; // last observed second
+    uint64_t epoch_anchor_millis = 0; // System.millis() at the anchor
+    uint64_t epoch_anchor = 0; // epoch ms at the anchor
 
     // state log exceptions
     bool override_state_log = false;
@@ -317,35 +408,117 @@ class LoggerController {
     void (*state_update_callback)() = 0;
     void (*data_update_callback)() = 0;
 
-    // buffer for date time
-    char date_time_buffer[25];
+    // date time text (formatted once per second)
+    LoggerTimestamp timestamp;
 
     // buffer and information variables
+    // the cloud variables are read by the system thread at any time, so a request only returns the last snapshot and flags
+    // the variable as requested, loop() then renders it if it is outdated (the flags mark which parts are outdated and the
+    // times are those of the last update) and replaces the snapshot as a whole (see updateVariableSnapshot())
+    char variable_render_buffer[VARIABLE_RENDER_MAX_CHAR];
     char state_variable[STATE_INFO_MAX_CHAR];
+    bool state_variable_outdated = false;
+    volatile bool state_variable_requested = false; // set by the cloud variable callback (system thread)
+    bool state_variable_entries_outdated = false;
+    time_t state_variable_time = 0;
     char state_variable_buffer[STATE_INFO_MAX_CHAR-50];
+    LoggerWriter state_variable_writer = LoggerWriter(state_variable_buffer, sizeof(state_variable_buffer));
     char data_variable[DATA_INFO_MAX_CHAR];
     char data_variable_buffer[DATA_INFO_MAX_CHAR-50];
+    LoggerWriter data_variable_writer = LoggerWriter(data_variable_buffer, sizeof(data_variable_buffer));
+    bool data_variable_outdated = false;
+    volatile bool data_variable_requested = false; // set by the cloud variable callback (system thread)
+    time_t data_variable_time = 0;
+    // entries of unchanged data are kept in the data variable buffer, changed ones are spliced in
+    size_t data_variable_cursor = 0; // end of the entries added so far
+    int data_variable_shift = 0; // how far the entries moved from their previous positions
+    bool data_variable_rebuild = false; // whether the rest of the buffer is assembled from scratch
+    char publish_variable[PUBLISH_INFO_MAX_CHAR];
 
     // buffers for log events
     char state_log[STATE_LOG_MAX_CHAR];
     char data_log[DATA_LOG_MAX_CHAR];
     char data_log_buffer[DATA_LOG_MAX_CHAR-10];
+    LoggerWriter data_log_writer = LoggerWriter(data_log_buffer, sizeof(data_log_buffer));
 
     // data logging tracker
-    unsigned long last_data_log = 0;
-
-    // log stacks
-    std::vector<std::string> state_log_stack;
-    std::vector<std::string> data_log_stack;
-
-    // log stack processing
-    unsigned long last_log_published = 0;
-    const int publish_interval = 1000; // 1/s is the max frequency for particle cloud publishing
-
-    // memory reserve
-    uint memory_reserve = 5000; // memory reserve in bytes
-    bool out_of_memory = false; // whether out of memory
-    uint missed_data = 0; // how many data points missed b/c no internet and out of memory
+    uint64_t last_data_log = 0;
+    uint64_t data_log_time = 0; // reference time of the current data log (its "ms" and the "to" offsets)
+
+    // log stacks (preallocated ring buffers, see LoggerLogQueue)
+    LoggerLogQueue state_log_stack;
+    LoggerLogQueue data_log_stack;
+
+    // optional persistent log spool (see LoggerLogSpool)
+    LoggerLogSpool* log_spool = NULL;
+
+    // log stack processing: token bucket for the publish rate and stride scheduling between the log queues
+    // (the queue with the lowest pass publishes next, its pass advances by PUBLISH_STRIDE / weight)
+    float publish_rate = PUBLISH_RATE;
+    float publish_burst = PUBLISH_BURST;
+    float publish_tokens = PUBLISH_BURST;
+    unsigned long publish_tokens_refilled = 0;
+    uint16_t state_log_weight = STATE_LOG_WEIGHT;
+    uint16_t data_log_weight = DATA_LOG_WEIGHT;
+    uint32_t state_log_pass = 0;
+    uint32_t data_log_pass = 0;
+    unsigned long state_log_max_age = STATE_LOG_MAX_AGE;
+    unsigned long data_log_max_age = DATA_LOG_MAX_AGE;
+    // publish slot: the log(s) of the current publish are taken out of their queue when the publish starts and only dropped
+    // once it is acknowledged, the loop does not wait for the acknowledgement (failed publishes are retried from here first)
+    uint8_t publish_type = PUBLISH_NONE;
+    char publish_log[DATA_LOG_MAX_CHAR];
+    const char* publish_webhook = NULL;
+    size_t publish_n = 0; // number of logs in the publish
+    size_t publish_queue_n = 0; // number of logs that were queued when the publish was assembled
+    uint32_t publish_refs[PUBLISH_MAX_LOGS]; // spool addresses of the logs
+    bool publish_in_flight = false;
+    Future<bool> publish_future;
+    unsigned long publish_started = 0; // millis() when the publish in flight started
+    unsigned long publish_times[PUBLISH_MAX_LOGS]; // millis() when the logs in the publish slot were queued
+    bool publish_retry = false; // whether the publish slot failed before
+
+    // publish statistics per log source (since publish_stats_start)
+    LoggerPublishStats state_publish_stats;
+    LoggerPublishStats data_publish_stats;
+    LoggerPublishStats spool_publish_stats; // residence unknown (logs can be from before a restart)
+    unsigned long publish_stats_start = 0;
+    bool batch_data_logs = false; // whether to publish several data logs per event
+    char data_log_batch[DATA_LOG_MAX_CHAR];
+
+    // packed data logs
+    bool pack_data_logs = false; // whether to log data in the packed format
+    uint8_t packed_data_log_buffer[DATA_LOG_PACKED_MAX_BYTES];
+    size_t packed_data_log_size = 0;
+    size_t data_log_reserve = 0; // characters of the data log around its data (0 = not determined yet, see getDataLogReserve())
+    uint16_t data_schema = 0; // id of the data schema referenced by packed data logs (0 = none yet)
+    uint16_t data_schema_queued = 0; // id of the last data schema whose state logs were all queued (logged again otherwise)
+
+    // memory
+    size_t data_log_queue_size = DATA_LOG_QUEUE_SIZE; // bytes requested for the data log queue
+    unsigned long min_free_memory = 0; // lowest free memory seen since the log queues were allocated (the real headroom)
+    unsigned long last_memory_check = 0;
+    bool out_of_memory = false; // whether out of log queue memory
+    uint missed_data = 0; // how many data points missed b/c no internet and log queue full
+
+    // merging of queued data logs when out of memory
+    bool merge_data_logs = false; // whether to merge queued data logs instead of missing new ones
+    uint merged_data = 0; // how many times two queued data logs were merged into one
+    uint8_t* data_log_merge_buffer = NULL; // decoded packed data for merging (3 x DATA_LOG_PACKED_MAX_BYTES, only with packed data logs)
+
+    // data rollups
+    LoggerDataRollup data_rollups[DATA_ROLLUPS_MAX];
+    uint8_t n_data_rollups = 0;
+    int data_log_rollup = -1; // rollup window of the data log that is being assembled (-1 = the data log period)
+
+    // component update dispatch
+    std::vector<LoggerComponent*> due_components; // components due in the current dispatch pass
+    unsigned long update_stats_start = 0; // start of the update statistics of the components (millis())
+
+    // raw sample capture download (chunks of JSON data logs, queued one at a time when no other data logs are waiting)
+    LoggerComponent* capture_download = NULL; // component whose capture is being downloaded (NULL if none)
+    uint16_t capture_chunk = 0; // number of the next chunk
+    bool data_log_capture = false; // whether the data log that is being assembled is a capture chunk
 
   public:
 
@@ -367,7 +540,10 @@ class LoggerController {
 
     // global tracker of sequential data reader
     bool sequential_data_read_in_progress = false;
-    unsigned long sequential_data_idle_start = 0;
+    uint64_t sequential_data_idle_start = 0;
+
+    // render buffer shared by all data (one data entry of a data log or the data variable at a time)
+    char data_text[DATA_TEXT_MAX_CHAR];
 
     /*** constructors ***/
     LoggerController (const char *version, int reset_pin) : LoggerController(version, reset_pin, new LoggerDisplay()) {}
@@ -391,18 +567,59 @@ class LoggerController {
     void setStateUpdateCallback(void (*cb)()); // callback executed when state variable is updated
     void setDataUpdateCallback(void (*cb)()); // callback executed when data variable is updated
 
+    /*** publish scheduling ***/
+    void setPublishRate(float rate, float burst); // token bucket: publishes per second and max burst of publishes
+    void setPublishWeights(uint16_t state_weight, uint16_t data_weight); // relative share of publishes when both state and data logs are queued
+    void setLogMaxAges(unsigned long state_max_age, unsigned long data_max_age); // age (ms) beyond which the oldest queued log is published first (0 = no limit)
+
+    /*** log queues ***/
+    void setDataLogQueueSize(size_t size); // bytes preallocated for queued data logs (call before init, default DATA_LOG_QUEUE_SIZE)
+
+    /*** data log batching ***/
+    void batchDataLogs(); // publish as many queued data logs as fit into one event (to DATA_LOG_BATCH_WEBHOOK)
+
+    /*** packed data logs ***/
+    void packDataLogs(); // log data as packed binary records (base64) with a separate data schema state log
+    bool isPackingDataLogs() { return(pack_data_logs); }
+
+    /*** data log merging ***/
+    void mergeDataLogs(); // when out of memory, merge the oldest queued data logs pairwise (exact means and standard deviations) instead of missing new data logs
+
+    /*** data rollups ***/
+    bool addDataRollup(unsigned long period, bool logging = true); // additional averaging window of all data logged every period seconds (call before init)
+
+    /*** log spool ***/
+    void setLogSpool(LoggerLogSpool* spool); // keep queued logs in external flash across restarts (call before init)
+    uint32_t spoolLog(uint8_t type, const char* log, bool queued); // write log to the spool (if there is one), returns its address
+
     /*** setup ***/
     void addComponent(LoggerComponent* component);
     void init(); 
     virtual void initComponents();
+    virtual void initDataRollups();
+    void initLogQueues();
     virtual void completeStartup();
 
     /*** loop ***/
     void update();
+    // earliest deadline first dispatch of the component updates that are due (see LoggerComponent::getNextUpdate()),
+    // components that run every loop (e.g. steppers) go first and idle readers are not updated until their next request
+    virtual void updateComponents();
+    void rescheduleComponents(); // all components due right away (e.g. after a command)
+    virtual void queueUpdateStatsLog(); // state log with the update statistics of the components
+    void resetUpdateStats();
 
     /*** logger name capture ***/
     void captureName(const char *topic, const char *data);
 
+    /*** timestamps ***/
+    const char* getDateTime(); // now as "%Y-%m-%d %H:%M:%S %Z" (without heap allocation, formatted at most once per second)
+    const char* getDateTime(time_t time);
+    const char* getEpochTime(time_t time); // compact form (seconds since 1970)
+    virtual void updateEpochTime(); // re-anchor the millis to epoch ms mapping when the second rolls over (if needed)
+    uint64_t getEpochMillis(uint64_t ms); // epoch ms of a System.millis() time
+    uint64_t getDataLogTime(); // System.millis() time the time offsets of the current data log refer to
+
     /*** state management ***/
     virtual size_t getStateSize() { return(sizeof(*state)); }
     virtual void loadState(bool reset);
@@ -423,6 +640,10 @@ class LoggerController {
     bool parseReset();
     bool parseRestart();
     bool parsePage();
+    bool parsePublishStats();
+    bool parseUpdateStats();
+    bool parseDataRollup();
+    bool parseDataCapture();
 
     /*** state changes ***/
     bool changeLocked(bool on);
@@ -430,6 +651,7 @@ class LoggerController {
     bool changeDataLogging(bool on);
     bool changeDataLoggingPeriod(int period, int type);
     bool changeDataReadingPeriod(int period);
+    bool changeDataRollupLogging(int rollup, bool on);
 
     /*** command info to display ***/
     virtual void updateDisplayCommandInformation();
@@ -442,25 +664,46 @@ class LoggerController {
     virtual void showDisplayStateInformation();
     virtual void updateDisplayComponentsStateInformation();
 
+    /*** publish scheduling ***/
+    virtual void refillPublishTokens();
+    virtual void publishNextLog(); // publish from the log queue that is due next (if there is a token and no publish in flight)
+    virtual void startPublish(); // publish the log(s) in the publish slot (without waiting for the acknowledgement)
+    virtual void checkPublish(); // finish the publish in flight once it is acknowledged (or failed)
+
+    /*** publish statistics ***/
+    LoggerPublishStats* getPublishStats(); // statistics for the log source in the publish slot
+    virtual void postPublishVariable();
+    virtual void queuePublishStatsLog(); // state log with the publish statistics
+    void resetPublishStats();
+
     /*** logger state variable ***/
-    virtual void updateStateVariable();
+    virtual void updateStateVariable(); // state entries changed
     virtual void assembleStateVariable();
     virtual void assembleComponentsStateVariable();
     void addToStateVariableBuffer(char* info);
-    virtual void postStateVariable();
+    virtual void postStateVariable(); // state variable header (memory, logs, publishes) changed
+    virtual void renderStateVariable(); // renders only what is outdated
+    String getStateVariable(); // cloud variable callback, returns the last snapshot and requests a render if outdated
 
     /*** particle webhook state log ***/
     virtual void assembleStartupLog(); 
     virtual void assembleMissedDataLog();
+    virtual void assembleMergedDataLog();
     virtual void assembleStateLog(); 
-    virtual void queueStateLog(); 
-    virtual void publishStateLog();
+    virtual uint16_t getDataSchemaId(); // checksum of the index, key and units of all data
+    virtual void queueDataSchemaLogs(); // state log(s) with the data schema for packed data logs
+    virtual bool queueStateLog(); // returns false if the log was dropped because the queue (and spool) are full
+    virtual void publishStateLog(bool oldest = false); // move the newest (or the oldest) state log to the publish slot and publish it
 
     /*** logger data variable ***/
-    virtual void updateDataVariable();
+    virtual void updateDataVariable(); // data changed
     virtual void assembleComponentsDataVariable();
     void addToDataVariableBuffer(char* info);
+    void addToDataVariableBuffer(LoggerData& data); // keeps the entry of unchanged data
     virtual void postDataVariable();
+    virtual void renderDataVariable();
+    String getDataVariable(); // cloud variable callback, returns the last snapshot and requests a render if outdated
+    void updateVariableSnapshot(char* variable, size_t size); // replace a cloud variable with the render buffer
 
     /*** particle webhook data log ***/
     virtual bool isTimeForDataLogAndClear(); // whether it's time for data clear and log (if logging is on)
@@ -468,9 +711,25 @@ class LoggerController {
     virtual void clearData(bool clear_persistent = false); // clear data fields
     virtual void logData(); 
     virtual void resetDataLog();
+    int printDataLogHeader(char* target, size_t size, bool use_common_time, unsigned long common_time); // returns the length (as snprintf)
+    size_t getDataLogReserve();
     virtual bool addToDataLogBuffer(char* info);
+    virtual bool addToPackedDataLogBuffer(const uint8_t* record, size_t size);
     virtual bool finalizeDataLog(bool use_common_time, unsigned long common_time = 0);
-    virtual void queueDataLog();
-    virtual void publishDataLog();
+    virtual bool queueDataLog(); // returns false if the log was dropped because the queue (and spool) are full
+    virtual bool mergeQueuedDataLogs(); // merge one pair of queued data logs to free up memory, returns false if not possible
+    virtual bool mergeDataLogPair(const char* older); // merge a queued data log with the next newer one
+    virtual size_t assembleDataLogMerge(const char* older, const char* newer, unsigned long log_time_difference); // merged data log in data_log_batch, returns its length (0 if not mergeable)
+    virtual size_t assembleDataLogBatch(bool oldest = false); // batch of the newest (or the oldest) data logs in data_log_batch, returns the number of logs
+    virtual void publishDataLog(bool oldest = false); // move the newest (or the oldest) data log(s) to the publish slot and publish them
+    virtual void publishSpoolLog(); // copy the next log that is only in the spool to the publish slot and publish it
+
+    /*** particle webhook data rollup logs ***/
+    virtual void updateDataRollups(); // log and restart the rollup windows that are complete
+    virtual void logRollupData(int rollup);
+    virtual void clearRollupData(int rollup);
+
+    /*** particle webhook capture logs ***/
+    virtual void updateCaptureDownload(); // queue the next chunk of a frozen capture (only if no data logs are waiting)
 
 };
@@ -1,6 +1,7 @@
 #include "application.h"
 #include "LoggerData.h"
 #include "LoggerUtils.h"
+#include "LoggerEncoding.h"
 
 /** DEBUG **/
 
@@ -11,10 +12,23 @@ void LoggerData::debug() {
 /** CLEARING **/
 
 void LoggerData::clear(bool clear_persistent) {
+  if (time_weighted && level_valid && System.millis() >= second_start + 1000) {
+    // the level carries over (drop the whole seconds that were not counted, e.g. while data logging is off)
+    second_start += (System.millis() - second_start) / 1000 * 1000;
+    level_time = System.millis();
+    second_sum = level * (level_time - second_start);
+  }
   if (!persistent || clear_persistent) {
-    setNewestValueInvalid();
+    if (!time_weighted) setNewestValueInvalid();
     value.clear();
     data_time.clear();
+    if (summary != NULL) summary->clear();
+    rejected = 0;
+  }
+  // full clear: also start the rollup windows and the outlier filter over
+  if (clear_persistent) {
+    for (int i = 0; i < n_rollups; i++) clearRollup(i, true);
+    if (outlier_filter != NULL) outlier_filter->clear();
   }
 }
 
@@ -22,6 +36,137 @@ void LoggerData::makePersistent() {
   persistent = true;
 }
 
+/** SUMMARY **/
+
+void LoggerData::enableSummary(uint8_t percentile1, uint8_t percentile2, uint8_t percentile3) {
+  if (summary == NULL) summary = new RunningSummary();
+  summary->setPercentiles(percentile1, percentile2, percentile3); // covers the values saved from now on
+}
+
+bool LoggerData::getSummary(LoggerDataSummary& target) {
+  target.valid = summary != NULL && swapped_rollup < 0 && getN() > 1 && summary->getN() == getN();
+  if (target.valid) target.set(*summary);
+  return(target.valid);
+}
+
+/** OUTLIER REJECTION **/
+
+void LoggerData::enableOutlierFilter(uint8_t window, float threshold, double resolution) {
+  // reconfigured in place if already enabled (copies of the data share the filter)
+  if (outlier_filter == NULL) outlier_filter = new HampelFilter(window, threshold);
+  else outlier_filter->configure(window, threshold);
+  outlier_resolution = resolution;
+}
+
+int LoggerData::getRejected() {
+  // only reported for the data log window (not for rollups)
+  return( (outlier_filter != NULL && swapped_rollup < 0) ? rejected : -1 );
+}
+
+/** TIME WEIGHTING **/
+
+void LoggerData::enableTimeWeighting() {
+  time_weighted = true;
+}
+
+bool LoggerData::isTimeWeighted() {
+  return(time_weighted);
+}
+
+void LoggerData::updateTimeWeighting(uint64_t time) {
+  if (!time_weighted || !level_valid || time <= level_time) return;
+
+  // still within the incomplete second
+  uint64_t second_end = second_start + 1000;
+  if (time < second_end) {
+    second_sum += level * (time - level_time);
+    level_time = time;
+    return;
+  }
+
+  // complete the second: the average of the levels within it (weighted by their ms)
+  second_sum += level * (second_end - level_time);
+  RunningStats rs_value, rs_data_time;
+  rs_value.add(second_sum / 1000.0);
+  rs_data_time.add(second_start + 500.0);
+
+  // the whole seconds at the current level with the data time in the middle
+  int seconds = (time - second_end) / 1000;
+  if (seconds > 0) {
+    RunningStats rs_level, rs_level_time;
+    rs_level.n = seconds;
+    rs_level.mean = level;
+    rs_level_time.n = seconds;
+    rs_level_time.mean = second_end + seconds * 500.0;
+    rs_value.merge(rs_level);
+    rs_data_time.merge(rs_level_time);
+  }
+
+  value.merge(rs_value);
+  data_time.merge(rs_data_time);
+  for (int i = 0; i < n_rollups; i++) {
+    rollups[2 * i].merge(rs_value);
+    rollups[2 * i + 1].merge(rs_data_time);
+  }
+
+  // the rest is counted with the next update
+  second_start = second_end + (uint64_t) seconds * 1000;
+  second_sum = level * (time - second_start);
+  level_time = time;
+}
+
+/** ROLLUPS **/
+
+void LoggerData::enableRollups(int n) {
+  if (rollups != NULL || n <= 0) return;
+  rollups = new RunningStats[2 * n];
+  n_rollups = n;
+}
+
+void LoggerData::clearRollup(int rollup, bool clear_persistent) {
+  if (rollup < n_rollups && (!persistent || clear_persistent)) {
+    rollups[2 * rollup].clear();
+    rollups[2 * rollup + 1].clear();
+  }
+}
+
+void LoggerData::swapRollup(int rollup) {
+  if (rollup >= n_rollups) return;
+  RunningStats swap = value;
+  value = rollups[2 * rollup];
+  rollups[2 * rollup] = swap;
+  swap = data_time;
+  data_time = rollups[2 * rollup + 1];
+  rollups[2 * rollup + 1] = swap;
+  swapped_rollup = (swapped_rollup == rollup) ? -1 : rollup;
+}
+
+void LoggerDataSummary::set(RunningSummary& rs) {
+  min = rs.getMin();
+  max = rs.getMax();
+  n_quantiles = 0;
+  for (int i = 0; i < SUMMARY_MAX_QUANTILES; i++) {
+    if (rs.quantiles[i].percentile > 0) {
+      percentiles[n_quantiles] = rs.quantiles[i].percentile;
+      quantiles[n_quantiles] = rs.quantiles[i].get();
+      n_quantiles++;
+    }
+  }
+}
+
+void LoggerDataSummary::merge(LoggerDataSummary& other, int n, int other_n) {
+  if (!valid || !other.valid || n_quantiles != other.n_quantiles || memcmp(percentiles, other.percentiles, n_quantiles) != 0) {
+    // can only combine summaries of the same quantiles
+    valid = false;
+    return;
+  }
+  if (other.min < min) min = other.min;
+  if (other.max > max) max = other.max;
+  for (int i = 0; i < n_quantiles; i++) {
+    quantiles[i] = (quantiles[i] * n + other.quantiles[i] * other_n) / (n + other_n);
+  }
+}
+
 /** DATA **/
 
 int LoggerData::getN() {
@@ -36,20 +181,27 @@ double LoggerData::getStdDev() {
   return value.getStdDev();
 }
 
-unsigned long LoggerData::getDataTime() {
-  return (unsigned long) round(data_time.mean);
+uint64_t LoggerData::getDataTime() {
+  return (uint64_t) round(data_time.mean);
+}
+
+const char* LoggerData::getVariable() {
+  return(LoggerStringPool::get(variable));
 }
 
-void LoggerData::setVariable(char* var) {
-  strncpy(variable, var, sizeof(variable) - 1);
-  variable[sizeof(variable)-1] = 0;
+void LoggerData::setVariable(const char* var) {
+  LoggerString handle = LoggerStringPool::intern(var);
+  if (handle != variable) info_outdated = true;
+  variable = handle;
 }
 
 void LoggerData::setIndex(int i) {
+  info_outdated = true;
   idx = i;
 }
 
 void LoggerData::setNewestValue(double val) {
+  if (!newest_value_valid || val != newest_value) info_outdated = true;
   newest_value = val;
   newest_value_valid = true;
 }
@@ -57,59 +209,87 @@ void LoggerData::setNewestValue(double val) {
 // @param add_decimals how many decimals to add tot he infered decimals (only matters if inferred)
 // @param strict checks that only white spaces are left at the end
 bool LoggerData::setNewestValue(char* val, bool strict, bool infer_decimals, int add_decimals, const char* sep) {
-  char* double_end;
-  double d = strtod (val, &double_end);
-  int converted = double_end - val;
-  int remaining = strlen(val) - converted;
-  // nothing converted
-  if (converted == 0) {
+  // one pass over the text (stops at the first character after the number unless strict)
+  DecimalParser parser(sep[0]);
+  for (char* c = val; *c != 0; c++) {
+    if (!parser.add(*c) && (!strict || parser.trailing_garbage)) break;
+  }
+  return(setNewestValue(parser, strict, infer_decimals, add_decimals));
+}
+
+bool LoggerData::setNewestValue(DecimalParser& parser, bool strict, bool infer_decimals, int add_decimals) {
+  // nothing converted (or more than white spaces after the value if strict)
+  if (!parser.isValid(strict)) {
     setNewestValueInvalid();
     return(false);
   }
-  // check for remainder to be only white spaces if strict
-  if (strict) {
-    char c;
-    for (int i = 0; i < remaining; i++) {
-      c = val[converted+i];
-      if (!isspace(c)) {
-        setNewestValueInvalid();
-        return(false);
-      }
-    }
-  }
   // infer decimals
   if (infer_decimals) {
-    decimals = strlen(val) - strcspn(val, sep) - 1 - remaining + add_decimals;
-    if (decimals < 0) decimals = 0;
+    int inferred = parser.getDecimals() + add_decimals;
+    if (inferred < 0) inferred = 0;
+    if (inferred != decimals) info_outdated = true;
+    decimals = inferred;
   }
 
-  setNewestValue(d);
+  setNewestValue(parser.getValue());
   return(true);
 }
 
 
 void LoggerData::setNewestValueInvalid() {
+  if (newest_value_valid) info_outdated = true;
   newest_value_valid = false;
 }
 
-void LoggerData::setNewestDataTime(unsigned long dt) {
+void LoggerData::setNewestDataTime(uint64_t dt) {
   newest_data_time = dt;
 }
 
 void LoggerData::saveNewestValue(bool average) {
-  if (newest_value_valid) {
+  if (newest_value_valid && capture != NULL) capture->add(idx, newest_data_time, newest_value);
+  if (newest_value_valid && time_weighted) {
+    // count the previous level up to the data time and continue with the new level (always averaged)
+    if (level_valid) {
+      updateTimeWeighting(newest_data_time);
+    } else {
+      level_time = newest_data_time;
+      second_start = newest_data_time;
+      second_sum = 0.0;
+    }
+    level = newest_value;
+    level_valid = true;
+    if (debug_data) {
+      char text[100];
+      getDataDoubleText(idx, getVariable(), level, getUnits(), text, sizeof(text), PATTERN_IKVU_SIMPLE, decimals);
+      Serial.printf("DEBUG: new time weighted level saved for %s (from %lu ms)\n", text, (unsigned long) level_time);
+    }
+  } else if (newest_value_valid && average && outlier_filter != NULL &&
+      !outlier_filter->accept(newest_value, (outlier_resolution > 0) ? outlier_resolution : pow(10.0, -decimals))) {
+    // outlier (the resolution of the values is the smallest deviation that counts)
+    rejected++;
+    if (debug_data) {
+      char text[100];
+      getDataDoubleText(idx, getVariable(), newest_value, getUnits(), text, sizeof(text), PATTERN_IKVU_SIMPLE, decimals);
+      Serial.printf("DEBUG: outlier NOT saved for %s (%d rejected so far)\n", text, rejected);
+    }
+  } else if (newest_value_valid) {
 
-    // clear/overwrite values if not averaging or data time has overflowed (for safety)
-    if (!average || newest_data_time < getDataTime()) {
-      if (newest_data_time < getDataTime())
-        Serial.println("WARNING: data time has overflowed --> restarting value to avoid incorrect data");
+    // clear/overwrite values if not averaging (data times are 64-bit and do not overflow)
+    if (!average) {
       value.clear();
       data_time.clear();
+      if (summary != NULL) summary->clear();
+      for (int i = 0; i < n_rollups; i++) clearRollup(i, true);
     }
 
     // add new values
     value.add(newest_value);
     data_time.add(newest_data_time);
+    if (summary != NULL) summary->add(newest_value);
+    for (int i = 0; i < n_rollups; i++) {
+      rollups[2 * i].add(newest_value);
+      rollups[2 * i + 1].add(newest_data_time);
+    }
 
     // debug
     //Serial.printf("value add: %3.10f, datatime add: %lu\nvalue    : %3.10f, datatime    : %lu, stdev  : %.10f\n",
@@ -119,14 +299,15 @@ void LoggerData::saveNewestValue(bool average) {
       (average) ?
         Serial.print("DEBUG: new average value saved for ") :
         Serial.print("DEBUG: single value saved for ");
+      char text[100];
       (getN() > 1) ?
-        getDataDoubleWithSigmaText(idx, variable, getValue(), getStdDev(), units, getN(), json, sizeof(json), PATTERN_IKVSUN_SIMPLE, decimals) :
-        getDataDoubleText(idx, variable, getValue(), units, json, sizeof(json), PATTERN_IKVU_SIMPLE, decimals);
-      Serial.printf("%s (data time = %Lu ms)\n", json, getDataTime());
+        getDataDoubleWithSigmaText(idx, getVariable(), getValue(), getStdDev(), getUnits(), getN(), text, sizeof(text), PATTERN_IKVSUN_SIMPLE, decimals) :
+        getDataDoubleText(idx, getVariable(), getValue(), getUnits(), text, sizeof(text), PATTERN_IKVU_SIMPLE, decimals);
+      Serial.printf("%s (data time = %lu ms)\n", text, (unsigned long) getDataTime());
     }
     
   } else {
-    Serial.printf("WARNING: newest value for #%d (%s) not valid and therefore not saved\n", idx, variable);
+    Serial.printf("WARNING: newest value for #%d (%s) not valid and therefore not saved\n", idx, getVariable());
   }
 }
 
@@ -137,24 +318,47 @@ void LoggerData::saveRunningStatsValue(RunningStats rs) {
     value.set(rs);
     data_time.clear();
     data_time.add(newest_data_time);
+    if (summary != NULL) summary->clear(); // the individual values are not known
+    // rollups: combine with the values of the window so far (exact, the data time counts for all values)
+    RunningStats rs_data_time;
+    rs_data_time.n = rs.getN();
+    rs_data_time.mean = newest_data_time;
+    for (int i = 0; i < n_rollups; i++) {
+      rollups[2 * i].merge(rs);
+      rollups[2 * i + 1].merge(rs_data_time);
+    }
     if (debug_data) {
       Serial.print("DEBUG: new value saved from running stats for ");
+      char text[100];
       (getN() > 1) ?
-        getDataDoubleWithSigmaText(idx, variable, getValue(), getStdDev(), units, getN(), json, sizeof(json), PATTERN_IKVSUN_SIMPLE, decimals) :
-        getDataDoubleText(idx, variable, getValue(), units, json, sizeof(json), PATTERN_IKVU_SIMPLE, decimals);
-      Serial.printf("%s (data time = %Lu ms)\n", json, getDataTime());
+        getDataDoubleWithSigmaText(idx, getVariable(), getValue(), getStdDev(), getUnits(), getN(), text, sizeof(text), PATTERN_IKVSUN_SIMPLE, decimals) :
+        getDataDoubleText(idx, getVariable(), getValue(), getUnits(), text, sizeof(text), PATTERN_IKVU_SIMPLE, decimals);
+      Serial.printf("%s (data time = %lu ms)\n", text, (unsigned long) getDataTime());
     }
   } else {
-    Serial.printf("WARNING: running stats for #%d (%s) has no data and is therefore not saved\n", idx, variable);
+    Serial.printf("WARNING: running stats for #%d (%s) has no data and is therefore not saved\n", idx, getVariable());
   }
 }
 
-void LoggerData::setUnits(char* u) {
-  strncpy(units, u, sizeof(units) - 1);
-  units[sizeof(units)-1] = 0;
+const char* LoggerData::getUnits() {
+  return(LoggerStringPool::get(units));
+}
+
+const char* LoggerData::getLogUnits(char* buffer, int size) {
+  if (units_suffix == NULL || units_suffix[0] == 0) return(getUnits());
+  snprintf(buffer, size, "%s %s", getUnits(), units_suffix);
+  return(buffer);
+}
+
+void LoggerData::setUnits(const char* u) {
+  LoggerString handle = LoggerStringPool::intern(u);
+  if (handle == 0 && u[0] != 0) return; // pool is full (error reported), keep the previous units rather than logging none
+  if (handle != units) info_outdated = true;
+  units = handle;
 }
 
 void LoggerData::setDecimals(int d) {
+  if (d != decimals) info_outdated = true;
   decimals = d;
 }
 
@@ -164,16 +368,16 @@ int LoggerData::getDecimals() {
 
 /**** OPERATIONS ****/
 
-bool LoggerData::isVariableIdentical(char* comparison) {
-  if (strcmp(variable, comparison) == 0) {
+bool LoggerData::isVariableIdentical(const char* comparison) {
+  if (strcmp(getVariable(), comparison) == 0) {
     return(true);
   } else {
     return(false);
   }
 }
 
-bool LoggerData::isUnitsIdentical(char* comparison) {
-  if (strcmp(units, comparison) == 0) {
+bool LoggerData::isUnitsIdentical(const char* comparison) {
+  if (strcmp(getUnits(), comparison) == 0) {
     return(true);
   } else {
     return(false);
@@ -182,32 +386,276 @@ bool LoggerData::isUnitsIdentical(char* comparison) {
 
 /***** LOGGING *****/
 
-bool LoggerData::assembleLog(bool include_time_offset) {
+// add the number of rejected values to the end of a JSON data record: {..,"r":..}
+static void appendRejectedText(char* target, int size, int rejected) {
+  int length = strlen(target);
+  if (length == 0 || target[length - 1] != '}') return;
+  snprintf(target + length - 1, size - length + 1, ",\"r\":%d}", rejected);
+}
+
+// add the summary to the end of a JSON data record: {..,"min":..,"max":..,"p50":..}
+static void appendSummaryText(char* target, int size, LoggerDataSummary& summary, int decimals) {
+  int length = strlen(target);
+  if (length == 0 || target[length - 1] != '}') return;
+  length--;
+  for (int i = -2; i < summary.n_quantiles && length + 1 < size; i++) {
+    if (i == -2) length += snprintf(target + length, size - length, ",\"min\":");
+    else if (i == -1) length += snprintf(target + length, size - length, ",\"max\":");
+    else length += snprintf(target + length, size - length, ",\"p%d\":", summary.percentiles[i]);
+    if (length + 1 >= size) break;
+    print_to_decimals(target + length, size - length, (i == -2) ? summary.min : (i == -1) ? summary.max : summary.quantiles[i], decimals);
+    length += strlen(target + length);
+  }
+  if (length + 1 < size) {
+    target[length++] = '}';
+    target[length] = 0;
+  }
+}
+
+bool LoggerData::assembleLog(char* target, int size, bool include_time_offset) {
+  return(assembleLog(target, size, include_time_offset, System.millis()));
+}
+
+bool LoggerData::assembleLog(char* target, int size, bool include_time_offset, uint64_t log_time) {
+  char units_buffer[2 * STRING_POOL_MAX_CHAR];
+  const char* log_units = getLogUnits(units_buffer, sizeof(units_buffer));
   if (getN() > 1) {
     // have data
     (include_time_offset) ?
-      getDataDoubleWithSigmaText(idx, variable, getValue(), getStdDev(), units, getN(), millis() - getDataTime(), json, sizeof(json), PATTERN_IKVSUNT_JSON, decimals) :
-      getDataDoubleWithSigmaText(idx, variable, getValue(), getStdDev(), units, getN(), json, sizeof(json), PATTERN_IKVSUN_JSON, decimals);
+      getDataDoubleWithSigmaText(idx, getVariable(), getValue(), getStdDev(), log_units, getN(), (unsigned long) (log_time - getDataTime()), target, size, PATTERN_IKVSUNT_JSON, decimals) :
+      getDataDoubleWithSigmaText(idx, getVariable(), getValue(), getStdDev(), log_units, getN(), target, size, PATTERN_IKVSUN_JSON, decimals);
+    if (getRejected() >= 0) appendRejectedText(target, size, getRejected());
+    LoggerDataSummary summary_values;
+    if (getSummary(summary_values)) appendSummaryText(target, size, summary_values, decimals);
     return(true);
   } else if (getN() == 1) {
     // have single data point (sigma is not meaningful)
     (include_time_offset) ?
-      getDataDoubleText(idx, variable, getValue(), units, getN(), millis() - getDataTime(), json, sizeof(json), PATTERN_IKVUNT_JSON, decimals) :
-      getDataDoubleText(idx, variable, getValue(), units, getN(), json, sizeof(json), PATTERN_IKVUN_JSON, decimals);
+      getDataDoubleText(idx, getVariable(), getValue(), log_units, getN(), (unsigned long) (log_time - getDataTime()), target, size, PATTERN_IKVUNT_JSON, decimals) :
+      getDataDoubleText(idx, getVariable(), getValue(), log_units, getN(), target, size, PATTERN_IKVUN_JSON, decimals);
+    if (getRejected() >= 0) appendRejectedText(target, size, getRejected());
     return(true);
   } else {
     return (false);// don't include if there is no data
   }
 }
 
-void LoggerData::assembleInfo() {
+// packed record: [idx varint][flags][decimals int8][n varint][value][sigma (if n > 1)][time offset in ms varint (if included)]
+//   [rejected varint (if included)][min][max][number of quantiles][percentile uint8][quantile]... (if the summary is included)
+// value, sigma and summary values are zigzag varints of the value scaled by 10^decimals (the same precision as the JSON log)
+// or raw doubles if any scaled value is not representable (DATA_PACKED_RAW)
+static bool isPackable(double scaled) {
+  return(isfinite(scaled) && fabs(scaled) <= 9e15);
+}
+
+static bool packDataValue(uint8_t* target, size_t size, size_t& pos, double value, double factor, bool raw) {
+  return(raw ? packBytes(target, size, pos, &value, sizeof(value)) : packSignedVarint(target, size, pos, (int64_t) round(value * factor)));
+}
+
+static bool unpackDataValue(const uint8_t* data, size_t size, size_t& pos, double& value, double factor, bool raw) {
+  if (raw) return(unpackBytes(data, size, pos, &value, sizeof(value)));
+  int64_t scaled;
+  if (!unpackSignedVarint(data, size, pos, scaled)) return(false);
+  value = scaled / factor;
+  return(true);
+}
+
+static size_t packDataRecord(uint8_t* target, size_t size, int idx, int decimals, int n, double value, double sigma, bool include_time_offset, unsigned long time_offset, int rejected, LoggerDataSummary& summary) {
+  double factor = pow(10.0, decimals);
+  bool raw = !isPackable(round(value * factor)) || !isPackable(round(sigma * factor));
+  if (summary.valid) {
+    raw = raw || !isPackable(round(summary.min * factor)) || !isPackable(round(summary.max * factor));
+    for (int i = 0; i < summary.n_quantiles; i++) raw = raw || !isPackable(round(summary.quantiles[i] * factor));
+  }
+  uint8_t flags = (n > 1 ? DATA_PACKED_SIGMA : 0) | (include_time_offset ? DATA_PACKED_TIME_OFFSET : 0) | (raw ? DATA_PACKED_RAW : 0) |
+    (rejected >= 0 ? DATA_PACKED_REJECTED : 0) | (summary.valid ? DATA_PACKED_SUMMARY : 0);
+
+  size_t pos = 0;
+  bool fits = packVarint(target, size, pos, idx) && packByte(target, size, pos, flags) &&
+    packByte(target, size, pos, (uint8_t) (int8_t) decimals) && packVarint(target, size, pos, n);
+  fits = fits && packDataValue(target, size, pos, value, factor, raw);
+  if (flags & DATA_PACKED_SIGMA) fits = fits && packDataValue(target, size, pos, sigma, factor, raw);
+  if (include_time_offset) fits = fits && packVarint(target, size, pos, time_offset);
+  if (rejected >= 0) fits = fits && packVarint(target, size, pos, rejected);
+  if (summary.valid) {
+    fits = fits && packDataValue(target, size, pos, summary.min, factor, raw) && packDataValue(target, size, pos, summary.max, factor, raw) &&
+      packByte(target, size, pos, summary.n_quantiles);
+    for (int i = 0; i < summary.n_quantiles; i++) {
+      fits = fits && packByte(target, size, pos, summary.percentiles[i]) && packDataValue(target, size, pos, summary.quantiles[i], factor, raw);
+    }
+  }
+  return(fits ? pos : 0);
+}
+
+size_t LoggerData::assemblePackedLog(uint8_t* target, size_t size, bool include_time_offset) {
+  return(assemblePackedLog(target, size, include_time_offset, System.millis()));
+}
+
+size_t LoggerData::assemblePackedLog(uint8_t* target, size_t size, bool include_time_offset, uint64_t log_time) {
+  if (getN() == 0) return(0); // don't include if there is no data
+  LoggerDataSummary summary_values;
+  getSummary(summary_values);
+  return(packDataRecord(target, size, idx, decimals, getN(), getValue(), getStdDev(), include_time_offset, (unsigned long) (log_time - getDataTime()), getRejected(), summary_values));
+}
+
+void LoggerData::assembleInfo(char* target, int size) {
   if (newest_value_valid) {
     // valid data
-    (strlen(units) > 0) ?
-      getDataDoubleText(idx, variable, newest_value, units, json, sizeof(json), PATTERN_IKVU_JSON, decimals) :
-      getDataDoubleText(idx, variable, newest_value, json, sizeof(json), PATTERN_IKV_JSON, decimals);
+    char units_buffer[2 * STRING_POOL_MAX_CHAR];
+    const char* log_units = getLogUnits(units_buffer, sizeof(units_buffer));
+    (log_units[0] != 0) ?
+      getDataDoubleText(idx, getVariable(), newest_value, log_units, target, size, PATTERN_IKVU_JSON, decimals) :
+      getDataDoubleText(idx, getVariable(), newest_value, target, size, PATTERN_IKV_JSON, decimals);
   } else {
     // no valid data
-    getDataNullText(idx, variable, json, sizeof(json), PATTERN_IKV_JSON);
+    getDataNullText(idx, getVariable(), target, size, PATTERN_IKV_JSON);
+  }
+}
+
+/***** DATA RECORDS *****/
+
+bool LoggerDataRecord::parseLog(const char* json, const char* end) {
+  const char* idx_value = findJsonValue(json, end, "i");
+  const char* number_value = findJsonValue(json, end, "v");
+  if (idx_value == NULL || number_value == NULL) return(false);
+  if (!copyJsonString(findJsonValue(json, end, "k"), end, variable, sizeof(variable))) return(false);
+  if (!copyJsonString(findJsonValue(json, end, "u"), end, units, sizeof(units))) units[0] = 0;
+  idx = atoi(idx_value);
+
+  // value and sigma are printed with the data's decimals
+  char* number_end;
+  double mean = strtod(number_value, &number_end);
+  if (number_end == number_value) return(false);
+  const char* decimal_point = (const char*) memchr(number_value, '.', number_end - number_value);
+  decimals = (decimal_point != NULL) ? number_end - decimal_point - 1 : 0;
+  const char* n_value = findJsonValue(json, end, "n");
+  const char* sigma_value = findJsonValue(json, end, "s");
+  value.n = (n_value != NULL) ? atoi(n_value) : 1;
+  if (value.n < 1) return(false);
+  value.mean = mean;
+  double sigma = (sigma_value != NULL) ? atof(sigma_value) : 0.0;
+  value.M2 = sigma * sigma * (value.n - 1);
+
+  // time offset
+  const char* time_offset_value = findJsonValue(json, end, "to");
+  has_time_offset = (time_offset_value != NULL);
+  time_offset.n = value.n;
+  time_offset.mean = has_time_offset ? strtod(time_offset_value, NULL) : 0.0;
+  time_offset.M2 = 0.0;
+
+  // rejected outliers
+  const char* rejected_value = findJsonValue(json, end, "r");
+  rejected = (rejected_value != NULL) ? atoi(rejected_value) : -1;
+
+  // summary
+  const char* min_value = findJsonValue(json, end, "min");
+  const char* max_value = findJsonValue(json, end, "max");
+  summary.valid = (min_value != NULL && max_value != NULL);
+  summary.n_quantiles = 0;
+  if (summary.valid) {
+    summary.min = atof(min_value);
+    summary.max = atof(max_value);
+    // "p<percentile>":<quantile>
+    for (const char* p = json; p + 5 < end && summary.n_quantiles < SUMMARY_MAX_QUANTILES; p++) {
+      if (p[0] != '"' || p[1] != 'p' || !isdigit(p[2])) continue;
+      char* percentile_end;
+      long percentile = strtol(p + 2, &percentile_end, 10);
+      if (percentile_end + 1 >= end || percentile_end[0] != '"' || percentile_end[1] != ':' || percentile < 1 || percentile > 99) continue;
+      summary.percentiles[summary.n_quantiles] = percentile;
+      summary.quantiles[summary.n_quantiles] = atof(percentile_end + 2);
+      summary.n_quantiles++;
+    }
+  }
+  return(true);
+}
+
+bool LoggerDataRecord::parsePackedLog(const uint8_t* data, size_t size, size_t& pos) {
+  uint64_t number;
+  uint8_t flags, decimals_byte;
+  if (!unpackVarint(data, size, pos, number)) return(false);
+  idx = number;
+  if (!unpackByte(data, size, pos, flags) || !unpackByte(data, size, pos, decimals_byte) || !unpackVarint(data, size, pos, number)) return(false);
+  decimals = (int8_t) decimals_byte;
+  value.n = number;
+  if (value.n < 1) return(false);
+  double mean, sigma = 0.0;
+  double factor = pow(10.0, decimals);
+  bool raw = (flags & DATA_PACKED_RAW);
+  if (!unpackDataValue(data, size, pos, mean, factor, raw)) return(false);
+  if ((flags & DATA_PACKED_SIGMA) && !unpackDataValue(data, size, pos, sigma, factor, raw)) return(false);
+  value.mean = mean;
+  value.M2 = sigma * sigma * (value.n - 1);
+  has_time_offset = (flags & DATA_PACKED_TIME_OFFSET);
+  time_offset.n = value.n;
+  time_offset.mean = 0.0;
+  time_offset.M2 = 0.0;
+  if (has_time_offset) {
+    if (!unpackVarint(data, size, pos, number)) return(false);
+    time_offset.mean = number;
+  }
+  rejected = -1;
+  if (flags & DATA_PACKED_REJECTED) {
+    if (!unpackVarint(data, size, pos, number)) return(false);
+    rejected = number;
+  }
+  summary.valid = (flags & DATA_PACKED_SUMMARY);
+  summary.n_quantiles = 0;
+  if (summary.valid) {
+    uint8_t n_quantiles;
+    if (!unpackDataValue(data, size, pos, summary.min, factor, raw) || !unpackDataValue(data, size, pos, summary.max, factor, raw) ||
+        !unpackByte(data, size, pos, n_quantiles) || n_quantiles > SUMMARY_MAX_QUANTILES) return(false);
+    for (; summary.n_quantiles < n_quantiles; summary.n_quantiles++) {
+      if (!unpackByte(data, size, pos, summary.percentiles[summary.n_quantiles]) ||
+          !unpackDataValue(data, size, pos, summary.quantiles[summary.n_quantiles], factor, raw)) return(false);
+    }
+  }
+  return(true);
+}
+
+void LoggerDataRecord::merge(LoggerDataRecord& older, unsigned long log_time_difference) {
+  // the older data's time offsets are relative to the older log
+  RunningStats older_time_offset = older.time_offset;
+  older_time_offset.mean += log_time_difference;
+  summary.merge(older.summary, value.n, older.value.n);
+  if (older.rejected >= 0) rejected = (rejected >= 0) ? rejected + older.rejected : older.rejected;
+  value.merge(older.value);
+  time_offset.merge(older_time_offset);
+  if (older.decimals > decimals) decimals = older.decimals;
+}
+
+size_t LoggerDataRecord::assembleLog(char* target, size_t size) {
+  unsigned long offset = (unsigned long) round(time_offset.mean);
+  if (value.n > 1) {
+    (has_time_offset) ?
+      getDataDoubleWithSigmaText(idx, variable, value.getMean(), value.getStdDev(), units, value.getN(), offset, target, size, PATTERN_IKVSUNT_JSON, decimals) :
+      getDataDoubleWithSigmaText(idx, variable, value.getMean(), value.getStdDev(), units, value.getN(), target, size, PATTERN_IKVSUN_JSON, decimals);
+    if (rejected >= 0) appendRejectedText(target, size, rejected);
+    if (summary.valid) appendSummaryText(target, size, summary, decimals);
+  } else {
+    (has_time_offset) ?
+      getDataDoubleText(idx, variable, value.getMean(), units, value.getN(), offset, target, size, PATTERN_IKVUNT_JSON, decimals) :
+      getDataDoubleText(idx, variable, value.getMean(), units, value.getN(), target, size, PATTERN_IKVUN_JSON, decimals);
+    if (rejected >= 0) appendRejectedText(target, size, rejected);
+  }
+  size_t length = strlen(target);
+  return((length + 1 < size) ? length : 0);
+}
+
+size_t LoggerDataRecord::assemblePackedLog(uint8_t* target, size_t size) {
+  return(packDataRecord(target, size, idx, decimals, value.getN(), value.getMean(), value.getStdDev(),
+    has_time_offset, (unsigned long) round(time_offset.mean), rejected, summary));
+}
+
+bool LoggerDataRecordReader::next(LoggerDataRecord& record) {
+  if (packed != NULL) {
+    return(pos < packed_size && record.parsePackedLog(packed, packed_size, pos));
+  } else if (json != NULL) {
+    const char* start = (const char*) memchr(json + pos, '{', json_end - json - pos);
+    if (start == NULL) return(false);
+    const char* end = (const char*) memchr(start, '}', json_end - start);
+    if (end == NULL) return(false);
+    pos = end + 1 - json;
+    return(record.parseLog(start, end + 1));
   }
+  return(false);
 }
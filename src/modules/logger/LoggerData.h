@@ -1,52 +1,113 @@
 #pragma once
 #include "LoggerMath.h"
+#include "LoggerStringPool.h"
+#include "LoggerCapture.h"
 
-// Logger data for spark cloud
-struct LoggerData {
+// packed data record (see assemblePackedLog)
+#define DATA_PACKED_MAX_BYTES     96 // largest possible packed record
+#define DATA_PACKED_SIGMA         0x01 // flag: record includes the standard deviation
+#define DATA_PACKED_TIME_OFFSET   0x02 // flag: record includes the time offset
+#define DATA_PACKED_RAW           0x04 // flag: value and sigma are raw little endian doubles instead of scaled integers
+#define DATA_PACKED_SUMMARY       0x08 // flag: record includes min, max and quantiles (see LoggerDataSummary)
+#define DATA_PACKED_REJECTED      0x10 // flag: record includes the number of values rejected as outliers
 
-  // debug
-  bool debug_data = false;
+// min, max and quantiles of the values of a data log record (from the data's RunningSummary)
+// logged as "min", "max" and "p<percentile>" (e.g. "p50" for the median) with the data's decimals
+struct LoggerDataSummary {
+  bool valid = false;
+  double min = NAN;
+  double max = NAN;
+  int n_quantiles = 0;
+  uint8_t percentiles[SUMMARY_MAX_QUANTILES];
+  double quantiles[SUMMARY_MAX_QUANTILES];
 
-  // data information
-  char variable[25]; // the name of the data variable
-  int idx; // the index of the data
-  char units[25]; // the units the data is recorded in
-  char aux[25]; // any auxiliary or temporary information 
+  void set(RunningSummary& rs);
+  // combine with the summary of another set of values (min and max are exact, quantiles are n weighted estimates)
+  void merge(LoggerDataSummary& other, int n, int other_n);
+};
+
+// Logger data for spark cloud
+// compact (keys and units are handles into the shared LoggerStringPool, texts are rendered into a buffer of the caller)
+struct LoggerData {
 
   // newest data
-  unsigned long newest_data_time; // the last recorded datetime (in ms)
+  uint64_t newest_data_time; // the last recorded datetime (System.millis(), in ms)
   double newest_value; // the last recorded value
-  bool newest_value_valid; // whether the newest value is valid
 
   // saved data
   RunningStats value;
   RunningStats data_time;
 
+  // data information
+  int idx; // the index of the data
+  LoggerString variable; // the name of the data variable (see getVariable())
+  LoggerString units; // the units the data is recorded in (see getUnits())
+  const char* units_suffix = NULL; // text appended to the units in logs and info (e.g. the gas of an MFC, owned by the component)
+
+  // output parameters
+  int decimals; // what should the decimals be? (idxitive = decimals, negative = integers)
+
+  // data variable entry (see LoggerController::addToDataVariableBuffer)
+  int info_pos = -1; // where the info was added to the data variable buffer (-1 if it is not in there)
+  int info_length = 0;
+  bool info_outdated = true; // whether the info (newest value, units, etc.) changed since it was last added to the data variable
+
+  bool newest_value_valid; // whether the newest value is valid
+
   // clearing
   // FIXME: consider deprecating this attribute (formerly auto_clear) and all related functionality
   // UPDATE: see use case in Scale! should remain
   // check if it is needed / useded anywhere?
   bool persistent;
 
-  // output parameters
-  int decimals; // what should the decimals be? (idxitive = decimals, negative = integers)
-  char json[100]; // full data log text
+  // debug
+  bool debug_data = false;
+
+  // optional summary of the values (see enableSummary(), NULL if not enabled)
+  // note: allocated once and never freed, copies of the data share it
+  RunningSummary* summary = NULL;
+
+  // rollup windows (see LoggerController::addDataRollup(), NULL if there are none)
+  // value and data time stats of each window [value 1, data time 1, value 2, ..], fed by the same saveNewestValue() calls
+  // note: allocated once and never freed, copies of the data share them
+  RunningStats* rollups = NULL;
+  uint8_t n_rollups = 0;
+  int8_t swapped_rollup = -1; // the rollup whose stats are in value and data_time (see swapRollup(), -1 if none)
+
+  // optional outlier rejection in front of the averaging (see enableOutlierFilter(), NULL if not enabled)
+  // note: allocated once and never freed, copies of the data share it
+  HampelFilter* outlier_filter = NULL;
+  double outlier_resolution = 0.0;
+  uint16_t rejected = 0; // number of values rejected as outliers since the last clear
+
+  // optional time weighting for piecewise-constant values (see enableTimeWeighting())
+  bool time_weighted = false;
+  bool level_valid = false; // whether there is a current level
+  double level; // the current level
+  uint64_t level_time; // from when on the current level is not yet counted (System.millis(), in ms)
+  uint64_t second_start; // start of the second that is not yet complete (System.millis(), in ms)
+  double second_sum; // level x ms from the second_start up to the level_time (the levels in the incomplete second)
+
+  // optional raw sample capture (see LoggerComponent::enableCapture(), NULL if not enabled)
+  // note: shared by all data of the component and copies of the data, every valid saved value goes in before any averaging
+  LoggerCapture* capture = NULL;
 
   LoggerData() {
     idx = 0;
-    variable[0] = 0;
-    units[0] = 0;
+    variable = 0;
+    units = 0;
     decimals = 0;
     persistent = false;
+    newest_value_valid = false;
     clear(true);
   };
 
   LoggerData(int idx) : LoggerData() { setIndex(idx); }
-  LoggerData(int idx, char* var) : LoggerData(idx) { setVariable(var); }
-  LoggerData(int idx, char* var, char* units) : LoggerData(idx, var) { setUnits(units); }
+  LoggerData(int idx, const char* var) : LoggerData(idx) { setVariable(var); }
+  LoggerData(int idx, const char* var, const char* units) : LoggerData(idx, var) { setUnits(units); }
   LoggerData(int idx, int d) : LoggerData(idx) { setDecimals(d); }
-  LoggerData(int idx, char* var, int d) : LoggerData(idx, var) { setDecimals(d); }
-  LoggerData(int idx, char* var, char* units, int d) : LoggerData(idx, var, units) { setDecimals(d); }
+  LoggerData(int idx, const char* var, int d) : LoggerData(idx, var) { setDecimals(d); }
+  LoggerData(int idx, const char* var, const char* units, int d) : LoggerData(idx, var, units) { setDecimals(d); }
 
   // debug
   void debug();
@@ -55,29 +116,99 @@ struct LoggerData {
   void clear(bool clear_persistent = false);
   void makePersistent();
 
+  // summary: also log min, max and up to 3 quantile estimates (in %, 1-99, 0 = not used) of the values
+  void enableSummary(uint8_t percentile1 = 50, uint8_t percentile2 = 0, uint8_t percentile3 = 0);
+  bool getSummary(LoggerDataSummary& target); // whether the summary covers the values (only if enabled and n > 1)
+
+  // outlier rejection: saveNewestValue(true) skips values that are further than threshold robust standard deviations from the
+  // median of the last window values (Hampel filter), the data logs include the number of rejected values ("r")
+  // @param resolution smallest step of the values (e.g. 0.0625 for a DS18 sensor), 0 = based on the decimals
+  void enableOutlierFilter(uint8_t window = 7, float threshold = 3.0, double resolution = 0.0);
+  int getRejected(); // number of values rejected in the current window (-1 if there is no outlier filter)
+
+  // time weighting: for values that change in steps (e.g. the speed of a stirrer), saveNewestValue() starts a new level
+  // and the averages weight each level by how long it lasted (in ms), counted as one value per whole second (the exact time
+  // weighted average of the levels within that second) so means, rollups and merged logs are exact without logging every change
+  void enableTimeWeighting();
+  bool isTimeWeighted();
+  void updateTimeWeighting(uint64_t time); // count the current level up to the time (System.millis(), e.g. right before a data log)
+
+  // rollups
+  void enableRollups(int n);
+  void clearRollup(int rollup, bool clear_persistent = false);
+  void swapRollup(int rollup); // swap the stats of a rollup window into value and data_time (to log them), call again to swap back
+
   // data
   int getN();
   double getValue();
   double getStdDev();
-  unsigned long getDataTime();
-  void setVariable(char* var);
+  uint64_t getDataTime();
+  const char* getVariable();
+  void setVariable(const char* var);
   void setIndex(int idx);
   void setNewestValue(double val);
   // returns whether the value is a valid number or not (if strict, expects only white spaces after the value)
   bool setNewestValue(char* val, bool strict = true, bool infer_decimals = false, int add_decimals = 1, const char* sep = ".");
+  // same from a parser that was fed the value byte by byte (e.g. SerialReaderLoggerComponent::value_parser)
+  bool setNewestValue(DecimalParser& parser, bool strict = true, bool infer_decimals = false, int add_decimals = 1);
   void setNewestValueInvalid();
   void saveNewestValue(bool average); // set value based on current newest_value (calculate average if true)
   void saveRunningStatsValue(RunningStats rs); // set value from existing running stats
-  void setNewestDataTime(unsigned long dt);
-  void setUnits(char* u);
+  void setNewestDataTime(uint64_t dt);
+  const char* getUnits();
+  const char* getLogUnits(char* buffer, int size); // units with the suffix (rendered into the buffer if there is one)
+  void setUnits(const char* u);
   void setDecimals(int d);
   int getDecimals();
 
   // operations
-  bool isVariableIdentical(char* comparison);
-  bool isUnitsIdentical(char* comparison);
+  bool isVariableIdentical(const char* comparison);
+  bool isUnitsIdentical(const char* comparison);
+
+  // logging (into the target, e.g. the controller's shared data_text)
+  bool assembleLog(char* target, int size, bool include_time_offset = true); // assemble log (with our without time offset, in seconds)
+  bool assembleLog(char* target, int size, bool include_time_offset, uint64_t log_time); // time offset back from the log's reference time (System.millis())
+  size_t assemblePackedLog(uint8_t* target, size_t size, bool include_time_offset = true); // assemble packed log, returns its size (0 if no data)
+  size_t assemblePackedLog(uint8_t* target, size_t size, bool include_time_offset, uint64_t log_time);
+  void assembleInfo(char* target, int size); // assemble data info
+};
+
+// data of a single index read back from a queued data log (JSON or packed), used to merge queued data logs
+struct LoggerDataRecord {
+
+  int idx = 0;
+  char variable[25] = "";
+  char units[25] = "";
+  int decimals = 0;
+  RunningStats value;
+  RunningStats time_offset; // ms from the average data time to the log time (weighted like the value)
+  bool has_time_offset = false;
+  int rejected = -1; // number of values rejected as outliers (-1 if not included)
+  LoggerDataSummary summary;
+
+  // reading back (false if the text/record is not a valid data record)
+  bool parseLog(const char* json, const char* end); // {"i":..,"k":..,"v":..[,"s":..],"u":..,"n":..[,"to":..][,"r":..][,"min":..,"max":..,"p50":..]}
+  bool parsePackedLog(const uint8_t* data, size_t size, size_t& pos); // see LoggerData::assemblePackedLog
+
+  // combine with the same index from an older log (log_time_difference = ms between the two logs)
+  void merge(LoggerDataRecord& older, unsigned long log_time_difference);
+
+  // logging (same formats as LoggerData), return the length (0 if it does not fit)
+  size_t assembleLog(char* target, size_t size);
+  size_t assemblePackedLog(uint8_t* target, size_t size);
+};
+
+// reads the data records of a queued data log one after the other
+struct LoggerDataRecordReader {
+
+  const char* json = NULL; // JSON data: {..},{..} (without the enclosing brackets)
+  const char* json_end = NULL;
+  const uint8_t* packed = NULL; // decoded packed data
+  size_t packed_size = 0;
+  size_t pos = 0;
 
-  // logging
-  bool assembleLog(bool include_time_offset = true); // assemble log (with our without time offset, in seconds)
-  void assembleInfo(); // assemble data info
+  void setJsonData(const char* start, const char* end) { json = start; json_end = end; packed = NULL; pos = 0; }
+  void setPackedData(const uint8_t* data, size_t size) { packed = data; packed_size = size; json = NULL; pos = 0; }
+  void restart() { pos = 0; }
+  bool next(LoggerDataRecord& record); // false once there are no more (valid) records
 };
@@ -207,7 +207,7 @@ void LoggerDisplay::print(const char c[], bool temp)
 		}
 
 		if (debug_display) {
-			Serial.printlnf(" - finished (new cursor location = line %d, col %d), text buffer:\n[1]%s[%d]", line_now, col_now, text, strlen(text));
+			Serial.printlnf(" - finished (new cursor location = line %d, col %d), text buffer:\n[1]%s[%d]", line_now, col_now, text, (int) strlen(text));
 		}
 	}
 }
@@ -243,7 +243,7 @@ void LoggerDisplay::printLine(uint8_t line, const char text[], uint8_t start, ui
 		} else if (align == LCD_ALIGN_RIGHT) {
 			space_start = 0;
 			space_end = (strlen(text) < length) ? length - strlen(text) : 0;
-			strncpy(full_text + space_end, text, length - space_end);
+			memcpy(full_text + space_end, text, length - space_end); // the end of the text (exactly the remaining length)
 		} else {
 			Serial.println("ERROR: unsupported alignment");
 		}
@@ -269,11 +269,11 @@ void LoggerDisplay::printLine(uint8_t line, const char text[], uint8_t start, ui
 
 		if (debug_display) {
 			if (align == LCD_ALIGN_LEFT)
-				Serial.printf("Info @ %Lu: printing%s '%s' LEFT on line %u (%u to %u)\n",
-							millis(), (temp ? " TEMPORARY" : ""), full_text, line, start, end);
+				Serial.printf("Info @ %lu: printing%s '%s' LEFT on line %u (%u to %u)\n",
+							(unsigned long) millis(), (temp ? " TEMPORARY" : ""), full_text, line, start, end);
 			else if (align == LCD_ALIGN_RIGHT)
-				Serial.printf("Info @ %Lu: printing%s '%s' RIGHT on line %u (%u to %u)\n",
-							millis(), (temp ? " TEMPORARY" : ""), full_text, line, start, end);
+				Serial.printf("Info @ %lu: printing%s '%s' RIGHT on line %u (%u to %u)\n",
+							(unsigned long) millis(), (temp ? " TEMPORARY" : ""), full_text, line, start, end);
 		}
 
 		// send to print
@@ -324,16 +324,13 @@ void LoggerDisplay::printLineTempRightFromBuffer(uint8_t line, uint8_t length, u
 
 // assemble buffer
 void LoggerDisplay::resetBuffer() {
-	buffer[0] = 0; // reset buffer
+	buffer_writer.reset();
 }
 
 void LoggerDisplay::addToBuffer(char* add) {
-  if (buffer[0] == 0) {
-    strncpy(buffer, add, sizeof(buffer));
-  } else {
-    snprintf(buffer, sizeof(buffer),
-        "%s%s", buffer, add);
-  }
+	// text beyond the buffer is cut off (like on the screen)
+	size_t length = strlen(add);
+	buffer_writer.append(add, length < buffer_writer.remaining() ? length : buffer_writer.remaining());
 }
 
 
@@ -357,12 +354,12 @@ void LoggerDisplay::clearTempText()
 {
 
 	// revert data
-	char revert[cols];
+	char revert[cols + 1];
 	int needs_revert = -1;
 	uint16_t pos, i;
 
 	if (debug_display) {
-		Serial.printf("Info @ %Lu: clearing temp messages...\n", millis());
+		Serial.printf("Info @ %lu: clearing temp messages...\n", (unsigned long) millis());
 		for (uint8_t line = 1; line <= lines; line++)
 		{
 			for (uint8_t col = 1; col <= cols; col++)
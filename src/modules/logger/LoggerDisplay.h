@@ -3,6 +3,7 @@
  * https://github.com/BulldogLowell/LiquidCrystal_I2C_Spark
  **/
 #pragma once
+#include "LoggerWriter.h"
 
 // alignments
 #define LCD_ALIGN_LEFT   1
@@ -104,8 +105,9 @@ private:
 
 public:
 
-	// text buffer for lcd text assembly by user --> use resetBuffer and addToBuffer
+	// text buffer for lcd text assembly by user --> use resetBuffer and addToBuffer (or write it directly after resetBuffer)
 	char buffer[LCD_MAX_SIZE + 1];	 
+	LoggerWriter buffer_writer = LoggerWriter(buffer, sizeof(buffer));
 
 	// empty constructor (no screen)
 	LoggerDisplay() : LoggerDisplay(0, 0) {
@@ -0,0 +1,144 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**** CHECKSUMS ****/
+
+// CRC-16/CCITT (start with crc = 0xFFFF)
+static uint16_t updateCRC16(uint16_t crc, const uint8_t* data, size_t length) {
+  while (length--) {
+    crc ^= (uint16_t) *data++ << 8;
+    for (int i = 0; i < 8; i++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return(crc);
+}
+
+static uint16_t updateCRC16(uint16_t crc, const char* text) {
+  // includes the terminating \0 so that consecutive strings are unambiguous
+  return(updateCRC16(crc, (const uint8_t*) text, strlen(text) + 1));
+}
+
+/**** PACKED BINARY FUNCTIONS ****/
+// all functions write at target[pos] and advance pos, they return false (and leave pos) if there is not enough space
+
+static bool packByte(uint8_t* target, size_t size, size_t& pos, uint8_t value) {
+  if (pos + 1 > size) return(false);
+  target[pos++] = value;
+  return(true);
+}
+
+static bool packBytes(uint8_t* target, size_t size, size_t& pos, const void* data, size_t length) {
+  if (pos + length > size) return(false);
+  memcpy(target + pos, data, length);
+  pos += length;
+  return(true);
+}
+
+// unsigned LEB128: 7 bits per byte, high bit set on all but the last byte
+static bool packVarint(uint8_t* target, size_t size, size_t& pos, uint64_t value) {
+  size_t start = pos;
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    if (value) byte |= 0x80;
+    if (!packByte(target, size, pos, byte)) {
+      pos = start;
+      return(false);
+    }
+  } while (value);
+  return(true);
+}
+
+// zigzag encoding keeps small negative numbers short (0, -1, 1, -2, ... -> 0, 1, 2, 3, ...)
+static bool packSignedVarint(uint8_t* target, size_t size, size_t& pos, int64_t value) {
+  return(packVarint(target, size, pos, ((uint64_t) value << 1) ^ (uint64_t) (value >> 63)));
+}
+
+// counterparts of the pack functions: read at data[pos] and advance pos, return false if the data ends early
+
+static bool unpackByte(const uint8_t* data, size_t size, size_t& pos, uint8_t& value) {
+  if (pos + 1 > size) return(false);
+  value = data[pos++];
+  return(true);
+}
+
+static bool unpackBytes(const uint8_t* data, size_t size, size_t& pos, void* target, size_t length) {
+  if (pos + length > size) return(false);
+  memcpy(target, data + pos, length);
+  pos += length;
+  return(true);
+}
+
+static bool unpackVarint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && pos < size; shift += 7) {
+    uint8_t byte = data[pos++];
+    value |= (uint64_t) (byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return(true);
+  }
+  return(false);
+}
+
+static bool unpackSignedVarint(const uint8_t* data, size_t size, size_t& pos, int64_t& value) {
+  uint64_t zigzag;
+  if (!unpackVarint(data, size, pos, zigzag)) return(false);
+  value = (int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1);
+  return(true);
+}
+
+/**** BASE64 ****/
+
+// number of base64 characters for length bytes (with padding, without \0)
+static size_t getBase64Length(size_t length) {
+  return((length + 2) / 3 * 4);
+}
+
+// encode into target (standard alphabet with padding, JSON safe), returns false if target is too small
+static bool encodeBase64(char* target, size_t size, const uint8_t* data, size_t length) {
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  if (getBase64Length(length) + 1 > size) return(false);
+  size_t i = 0;
+  for (; i + 2 < length; i += 3) {
+    uint32_t block = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+    *target++ = alphabet[(block >> 18) & 0x3F];
+    *target++ = alphabet[(block >> 12) & 0x3F];
+    *target++ = alphabet[(block >> 6) & 0x3F];
+    *target++ = alphabet[block & 0x3F];
+  }
+  if (i < length) {
+    uint32_t block = data[i] << 16;
+    if (i + 1 < length) block |= data[i + 1] << 8;
+    *target++ = alphabet[(block >> 18) & 0x3F];
+    *target++ = alphabet[(block >> 12) & 0x3F];
+    *target++ = (i + 1 < length) ? alphabet[(block >> 6) & 0x3F] : '=';
+    *target++ = '=';
+  }
+  *target = 0;
+  return(true);
+}
+
+// decode length base64 characters (until the end or the first '=') into target, returns the number of bytes (0 if invalid or too large)
+static size_t decodeBase64(uint8_t* target, size_t size, const char* text, size_t length) {
+  size_t n = 0;
+  uint32_t block = 0;
+  int bits = 0;
+  for (size_t i = 0; i < length && text[i] != '='; i++) {
+    char c = text[i];
+    int value;
+    if (c >= 'A' && c <= 'Z') value = c - 'A';
+    else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+    else if (c >= '0' && c <= '9') value = c - '0' + 52;
+    else if (c == '+') value = 62;
+    else if (c == '/') value = 63;
+    else return(0);
+    block = (block << 6) | value;
+    bits += 6;
+    if (bits >= 8) {
+      if (n >= size) return(0);
+      bits -= 8;
+      target[n++] = (block >> bits) & 0xFF;
+    }
+  }
+  return(n);
+}
@@ -0,0 +1,203 @@
+#include "application.h"
+#include "LoggerLogQueue.h"
+#include <new>
+
+/*** setup ***/
+
+bool LoggerLogQueue::init(size_t size) {
+  if (buffer != NULL) delete[] buffer;
+  buffer = new (std::nothrow) uint8_t[size];
+  capacity = (buffer != NULL) ? size : 0;
+  clear();
+  return(buffer != NULL);
+}
+
+/*** record sizes ***/
+
+uint16_t LoggerLogQueue::readSize(size_t pos) {
+  uint16_t size;
+  memcpy(&size, buffer + pos, sizeof(size));
+  return(size);
+}
+
+void LoggerLogQueue::writeSize(size_t pos, uint16_t size) {
+  memcpy(buffer + pos, &size, sizeof(size));
+}
+
+void LoggerLogQueue::writeRecord(size_t pos, const char* log, size_t length, uint32_t ref, uint32_t time) {
+  uint16_t size = length + 1;
+  writeSize(pos, size);
+  memcpy(buffer + pos + sizeof(size), &ref, sizeof(ref));
+  memcpy(buffer + pos + sizeof(size) + sizeof(ref), &time, sizeof(time));
+  memcpy(buffer + pos + LOG_QUEUE_RECORD_HEADER, log, size);
+  writeSize(pos + LOG_QUEUE_RECORD_HEADER + size, size);
+}
+
+/*** queue management ***/
+
+bool LoggerLogQueue::push(const char* log, uint32_t ref) {
+  size_t length = strlen(log);
+  if (!fits(length)) return(false);
+
+  // place at the end of the buffer, otherwise wrap around to the start
+  size_t record = length + LOG_QUEUE_RECORD_OVERHEAD;
+  if (n > 0 && wrap == 0 && capacity - tail < record) {
+    wrap = tail;
+    tail = 0;
+  }
+
+  // store record
+  writeRecord(tail, log, length, ref, millis());
+  tail += record;
+  used += record;
+  n++;
+  return(true);
+}
+
+// the replacement takes the place of the older log and the newer logs in the same part of the buffer move up to close the gap
+bool LoggerLogQueue::replacePair(const char* log, const char* replacement, uint32_t ref, unsigned long time) {
+  const char* next = after(log);
+  if (next == NULL) return(false);
+  size_t first = getRecordStart(log);
+  size_t first_record = getRecordSize(first);
+  size_t second = getRecordStart(next);
+  size_t second_end = second + getRecordSize(second);
+  size_t length = strlen(replacement);
+  size_t record = length + LOG_QUEUE_RECORD_OVERHEAD;
+  if (length >= UINT16_MAX) return(false);
+
+  if (second == first + first_record) {
+    // both in the same part of the buffer
+    if (record > second_end - first) return(false);
+    bool at_end = (wrap > 0 && first >= head); // in the records at the end of the buffer
+    size_t part_end = at_end ? wrap : tail;
+    writeRecord(first, replacement, length, ref, time);
+    memmove(buffer + first + record, buffer + second_end, part_end - second_end);
+    if (at_end) wrap -= second_end - first - record;
+    else tail -= second_end - first - record;
+  } else {
+    // the pair wraps around: the replacement stays at the end of the buffer (if it fits) and the newer logs move to the start
+    if (first + record > capacity) return(false);
+    writeRecord(first, replacement, length, ref, time);
+    wrap = first + record;
+    memmove(buffer, buffer + second_end, tail - second_end);
+    tail -= second_end;
+    if (tail == 0) {
+      // no more records at the start of the buffer
+      tail = wrap;
+      wrap = 0;
+    }
+  }
+  used = used - first_record - (second_end - second) + record;
+  n--;
+  return(true);
+}
+
+const char* LoggerLogQueue::front() {
+  if (n == 0) return(NULL);
+  return((const char*) buffer + head + LOG_QUEUE_RECORD_HEADER);
+}
+
+const char* LoggerLogQueue::back() {
+  if (n == 0) return(NULL);
+  uint16_t size = readSize(tail - sizeof(uint16_t));
+  return((const char*) buffer + tail - sizeof(uint16_t) - size);
+}
+
+const char* LoggerLogQueue::before(const char* log) {
+  if (log == NULL) return(NULL);
+  size_t end = getRecordStart(log); // start of this record
+  if (end == head) return(NULL);
+  if (end == 0 && wrap > 0) end = wrap; // previous record is at the end of the buffer
+  uint16_t size = readSize(end - sizeof(uint16_t));
+  return((const char*) buffer + end - sizeof(uint16_t) - size);
+}
+
+const char* LoggerLogQueue::after(const char* log) {
+  if (log == NULL) return(NULL);
+  size_t start = getRecordStart(log);
+  start += getRecordSize(start); // start of the next record
+  if (wrap > 0 && start == wrap) start = 0; // next record is at the start of the buffer
+  if (start == tail) return(NULL);
+  return((const char*) buffer + start + LOG_QUEUE_RECORD_HEADER);
+}
+
+uint32_t LoggerLogQueue::getRef(const char* log) {
+  if (log == NULL) return(LOG_QUEUE_NO_REF);
+  uint32_t ref;
+  memcpy(&ref, log - LOG_QUEUE_RECORD_HEADER + sizeof(uint16_t), sizeof(ref));
+  return(ref);
+}
+
+unsigned long LoggerLogQueue::getTime(const char* log) {
+  if (log == NULL) return(0);
+  uint32_t time;
+  memcpy(&time, log - sizeof(time), sizeof(time));
+  return(time);
+}
+
+unsigned long LoggerLogQueue::getFrontAge() {
+  if (n == 0) return(0);
+  return(millis() - getTime(front()));
+}
+
+void LoggerLogQueue::popFront() {
+  if (n == 0) return;
+  size_t record = readSize(head) + LOG_QUEUE_RECORD_OVERHEAD - 1;
+  head += record;
+  used -= record;
+  n--;
+  if (wrap > 0 && head == wrap) {
+    // reached the end of the records at the end of the buffer
+    head = 0;
+    wrap = 0;
+  }
+  clearIfEmpty();
+}
+
+void LoggerLogQueue::popBack() {
+  if (n == 0) return;
+  size_t record = readSize(tail - sizeof(uint16_t)) + LOG_QUEUE_RECORD_OVERHEAD - 1;
+  tail -= record;
+  used -= record;
+  n--;
+  if (wrap > 0 && tail == 0) {
+    // removed the last record at the start of the buffer
+    tail = wrap;
+    wrap = 0;
+  }
+  clearIfEmpty();
+}
+
+void LoggerLogQueue::clear() {
+  head = 0;
+  tail = 0;
+  wrap = 0;
+  used = 0;
+  n = 0;
+}
+
+// an empty queue always starts over at the beginning of the buffer
+void LoggerLogQueue::clearIfEmpty() {
+  if (n == 0) clear();
+}
+
+/*** queue information ***/
+
+// largest contiguous space available for the next record
+size_t LoggerLogQueue::getFreeSpace() {
+  if (n == 0) return(capacity);
+  else if (wrap > 0) return(head - tail);
+  else return((capacity - tail > head) ? capacity - tail : head);
+}
+
+size_t LoggerLogQueue::getFreeBytes() {
+  size_t space = getFreeSpace();
+  if (space <= LOG_QUEUE_RECORD_OVERHEAD) return(0);
+  space -= LOG_QUEUE_RECORD_OVERHEAD;
+  return(space < UINT16_MAX ? space : UINT16_MAX - 1);
+}
+
+bool LoggerLogQueue::fits(size_t length) {
+  return(length < UINT16_MAX && length + LOG_QUEUE_RECORD_OVERHEAD <= getFreeSpace());
+}
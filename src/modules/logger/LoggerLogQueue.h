@@ -0,0 +1,68 @@
+#pragma once
+#include "application.h"
+
+/**** Log queue ****/
+
+// fixed-capacity ring buffer for queued logs, allocated once at startup to avoid per-log heap allocations
+// each log is stored as one contiguous record: [uint16 size][uint32 ref][uint32 time][log + \0][uint16 size]
+// the size at both ends allows removing records from the front (oldest) and the back (newest) in O(1)
+// the ref is an optional reference to another copy of the log (e.g. its address in the LoggerLogSpool)
+// the time is millis() when the log was queued (for the age of queued logs)
+// records never wrap around the end of the buffer (the unused tail is skipped instead) so logs can be read in place
+
+#define LOG_QUEUE_RECORD_HEADER     (sizeof(uint16_t) + 2 * sizeof(uint32_t)) // size + ref + time
+#define LOG_QUEUE_RECORD_OVERHEAD   (LOG_QUEUE_RECORD_HEADER + sizeof(uint16_t) + 1) // header + size + terminating \0
+#define LOG_QUEUE_NO_REF            UINT32_MAX
+
+class LoggerLogQueue {
+
+  private:
+
+    uint8_t* buffer = NULL;
+    size_t capacity = 0; // size of the buffer in bytes
+    size_t head = 0; // start of the oldest record
+    size_t tail = 0; // end of the newest record (where the next record goes)
+    size_t wrap = 0; // end of the records at the end of the buffer if the queue wraps around (0 if it does not)
+    size_t used = 0; // bytes occupied by records
+    size_t n = 0; // number of records
+
+    uint16_t readSize(size_t pos);
+    void writeSize(size_t pos, uint16_t size);
+    size_t getRecordStart(const char* log) { return((const uint8_t*) log - LOG_QUEUE_RECORD_HEADER - buffer); }
+    size_t getRecordSize(size_t pos) { return(readSize(pos) + LOG_QUEUE_RECORD_OVERHEAD - 1); }
+    void writeRecord(size_t pos, const char* log, size_t length, uint32_t ref, uint32_t time);
+    void clearIfEmpty();
+    size_t getFreeSpace();
+
+  public:
+
+    /*** constructors ***/
+    LoggerLogQueue() {};
+
+    /*** setup ***/
+    bool init(size_t size); // allocate the buffer, returns false if not possible
+
+    /*** queue management ***/
+    bool push(const char* log, uint32_t ref = LOG_QUEUE_NO_REF); // queue a log, returns false if there is not enough space
+    bool replacePair(const char* log, const char* replacement, uint32_t ref, unsigned long time); // replace a log and the next newer log with one log (that fits into their space)
+    const char* front(); // oldest log
+    const char* back(); // newest log
+    const char* before(const char* log); // next older log (NULL if this is the oldest)
+    const char* after(const char* log); // next newer log (NULL if this is the newest)
+    uint32_t getRef(const char* log); // ref of a log in the queue
+    uint32_t getFrontRef() { return(getRef(front())); } // ref of the oldest log
+    uint32_t getBackRef() { return(getRef(back())); } // ref of the newest log
+    unsigned long getTime(const char* log); // millis() when a log in the queue was pushed
+    unsigned long getFrontAge(); // ms since the oldest log was pushed (0 if the queue is empty)
+    void popFront();
+    void popBack();
+    void clear();
+
+    /*** queue information ***/
+    size_t size() { return(n); }
+    bool empty() { return(n == 0); }
+    size_t getCapacity() { return(capacity); }
+    size_t getUsedBytes() { return(used); } // bytes occupied by records including overhead
+    size_t getFreeBytes(); // largest log (excluding \0) that can be queued right now
+    bool fits(size_t length); // whether a log with this strlen can be queued right now
+};
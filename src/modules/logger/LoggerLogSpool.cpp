@@ -0,0 +1,430 @@
+#include "application.h"
+#include "LoggerLogSpool.h"
+#include "LoggerEncoding.h"
+#include <stddef.h>
+
+/*** flash commands (JEDEC SPI NOR) ***/
+
+#define FLASH_CMD_WRITE_ENABLE    0x06
+#define FLASH_CMD_READ_STATUS     0x05
+#define FLASH_CMD_READ            0x03
+#define FLASH_CMD_PAGE_PROGRAM    0x02
+#define FLASH_CMD_SECTOR_ERASE    0x20
+#define FLASH_CMD_JEDEC_ID        0x9F
+#define FLASH_STATUS_BUSY         0x01
+
+/*** flash access ***/
+
+uint32_t LoggerLogSpool::detectFlash() {
+  spi->begin(cs_pin);
+  spi->setBitOrder(MSBFIRST);
+  spi->setDataMode(SPI_MODE0);
+  spi->setClockSpeed(20, MHZ);
+  pinMode(cs_pin, OUTPUT);
+  digitalWrite(cs_pin, HIGH);
+
+  digitalWrite(cs_pin, LOW);
+  spi->transfer(FLASH_CMD_JEDEC_ID);
+  uint8_t manufacturer = spi->transfer(0);
+  spi->transfer(0); // memory type
+  uint8_t capacity = spi->transfer(0); // log2 of the size in bytes
+  digitalWrite(cs_pin, HIGH);
+
+  // no flash if the bus floats (0xFF) or is pulled low (0x00), only 3 byte addresses (up to 16MB) are supported
+  if (manufacturer == 0x00 || manufacturer == 0xFF || capacity < 16 || capacity > 24) return(0);
+  return(1UL << capacity);
+}
+
+bool LoggerLogSpool::isFlashBusy() {
+  digitalWrite(cs_pin, LOW);
+  spi->transfer(FLASH_CMD_READ_STATUS);
+  uint8_t status = spi->transfer(0);
+  digitalWrite(cs_pin, HIGH);
+  return(status & FLASH_STATUS_BUSY);
+}
+
+bool LoggerLogSpool::waitForFlash() {
+  unsigned long start = millis();
+  while (isFlashBusy()) {
+    if (millis() - start > LOG_SPOOL_TIMEOUT) return(false);
+    delayMicroseconds(100);
+  }
+  return(true);
+}
+
+static void sendFlashCommand(SPIClass* spi, uint8_t command, uint32_t address) {
+  spi->transfer(command);
+  spi->transfer((address >> 16) & 0xFF);
+  spi->transfer((address >> 8) & 0xFF);
+  spi->transfer(address & 0xFF);
+}
+
+void LoggerLogSpool::readFlash(uint32_t address, uint8_t* data, size_t length) {
+  waitForFlash();
+  digitalWrite(cs_pin, LOW);
+  sendFlashCommand(spi, FLASH_CMD_READ, address);
+  for (size_t i = 0; i < length; i++) data[i] = spi->transfer(0);
+  digitalWrite(cs_pin, HIGH);
+}
+
+bool LoggerLogSpool::writeFlash(uint32_t address, const uint8_t* data, size_t length) {
+  // page program cannot cross page boundaries
+  while (length > 0) {
+    size_t chunk = LOG_SPOOL_PAGE_SIZE - address % LOG_SPOOL_PAGE_SIZE;
+    if (chunk > length) chunk = length;
+    if (!waitForFlash()) return(false);
+    digitalWrite(cs_pin, LOW);
+    spi->transfer(FLASH_CMD_WRITE_ENABLE);
+    digitalWrite(cs_pin, HIGH);
+    digitalWrite(cs_pin, LOW);
+    sendFlashCommand(spi, FLASH_CMD_PAGE_PROGRAM, address);
+    for (size_t i = 0; i < chunk; i++) spi->transfer(data[i]);
+    digitalWrite(cs_pin, HIGH);
+    address += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+  return(waitForFlash());
+}
+
+// note: the sector erase takes typically 45ms (up to 400ms), the flash is busy until then
+void LoggerLogSpool::startFlashSectorErase(uint32_t address) {
+  digitalWrite(cs_pin, LOW);
+  spi->transfer(FLASH_CMD_WRITE_ENABLE);
+  digitalWrite(cs_pin, HIGH);
+  digitalWrite(cs_pin, LOW);
+  sendFlashCommand(spi, FLASH_CMD_SECTOR_ERASE, address);
+  digitalWrite(cs_pin, HIGH);
+}
+
+// note: blocks for the duration of the sector erase
+bool LoggerLogSpool::eraseFlashSector(uint32_t address) {
+  if (!waitForFlash()) return(false);
+  startFlashSectorErase(address);
+  return(waitForFlash());
+}
+
+/*** setup ***/
+
+bool LoggerLogSpool::init() {
+  // finish the writes of a previous init
+  if (ready) {
+    waitForFlash();
+    flushDeferred();
+  }
+  ready = false;
+  erased_sector = LOG_SPOOL_NO_SECTOR;
+  erasing = false;
+  uint32_t size = detectFlash();
+  if (size == 0) {
+    Serial.println("ERROR: no SPI flash detected, log spool disabled");
+    return(false);
+  }
+  uint32_t available = size / LOG_SPOOL_SECTOR_SIZE;
+  if (sectors == 0 && first_sector < available) sectors = available - first_sector;
+  if (sectors < 2 || first_sector + sectors > available) {
+    Serial.printlnf("ERROR: SPI flash (%lu bytes) does not have sectors %lu to %lu, log spool disabled",
+      (unsigned long) size, (unsigned long) first_sector, (unsigned long) (first_sector + sectors - 1));
+    return(false);
+  }
+
+  // newest sector = highest generation
+  LoggerLogSpoolSector header;
+  bool found = false;
+  for (uint32_t sector = 0; sector < sectors; sector++) {
+    readFlash(getSectorAddress(sector), (uint8_t*) &header, sizeof(header));
+    if (header.magic == LOG_SPOOL_SECTOR_MAGIC && (!found || header.generation > generation)) {
+      generation = header.generation;
+      newest_sector = sector;
+      found = true;
+    }
+  }
+  ready = true;
+  if (!found) {
+    Serial.printlnf("INFO: initializing log spool with %lu sectors", (unsigned long) sectors);
+    clear();
+    return(true);
+  }
+
+  // oldest sector = end of the run of consecutive generations before the newest
+  // (sectors from before a clear() are not consecutive and thus ignored)
+  oldest_sector = newest_sector;
+  for (uint32_t i = 1; i < sectors; i++) {
+    uint32_t sector = (newest_sector + sectors - i) % sectors;
+    readFlash(getSectorAddress(sector), (uint8_t*) &header, sizeof(header));
+    if (header.magic != LOG_SPOOL_SECTOR_MAGIC || header.generation != generation - i) break;
+    oldest_sector = sector;
+  }
+
+  // recover pending logs, record sequence and write position
+  LoggerLogSpoolRecord record;
+  pending = 0;
+  sequence = 0;
+  uint32_t sector = oldest_sector;
+  while (true) {
+    uint32_t address = getFirstRecord(sector);
+    while (readRecord(address, record)) {
+      if (record.flags & LOG_SPOOL_FLAG_PENDING) pending++;
+      sequence = record.sequence + 1;
+      address += sizeof(record) + record.length;
+    }
+    if (sector == newest_sector) {
+      write_address = address;
+      // anything but erased flash after the last record (torn write) closes the sector
+      uint8_t magic = 0xFF;
+      if (address < getSectorAddress(sector) + LOG_SPOOL_SECTOR_SIZE) readFlash(address, &magic, 1);
+      if (magic != 0xFF) write_address = getSectorAddress(sector) + LOG_SPOOL_SECTOR_SIZE;
+      break;
+    }
+    sector = (sector + 1) % sectors;
+  }
+
+  // all pending logs are only in the spool after a restart
+  backlog = pending;
+  startup_sequence = sequence;
+  drain_address = getFirstRecord(oldest_sector);
+  drain_record = LOG_SPOOL_NO_RECORD;
+  Serial.printlnf("INFO: log spool recovered %lu unpublished logs from %lu sectors",
+    (unsigned long) pending, (unsigned long) ((newest_sector + sectors - oldest_sector) % sectors + 1));
+  prepareNextSector();
+  return(true);
+}
+
+void LoggerLogSpool::clear() {
+  if (!ready) return;
+  // skip a generation so the cleared sectors are not consecutive with the new one
+  generation++;
+  startSector((newest_sector + 1) % sectors);
+  oldest_sector = newest_sector;
+  startup_sequence = sequence;
+  drain_address = write_address;
+  drain_record = LOG_SPOOL_NO_RECORD;
+  pending = 0;
+  backlog = 0;
+  prepareNextSector();
+}
+
+void LoggerLogSpool::update() {
+  if (!ready || isErasing()) return;
+  flushDeferred();
+  if (erased_sector != LOG_SPOOL_NO_SECTOR) return;
+
+  uint32_t sector = (newest_sector + 1) % sectors;
+  if (sector == oldest_sector) {
+    // wrapped around, the oldest sector can only be reused once all its logs are published (checked again once there are fewer pending logs)
+    if (pending >= blocked_pending) return;
+    if (hasPending(sector)) {
+      blocked_pending = pending;
+      return;
+    }
+    blocked_pending = UINT32_MAX;
+    oldest_sector = (oldest_sector + 1) % sectors;
+    if (getSector(drain_address) == sector) drain_address = getFirstRecord(oldest_sector);
+  }
+
+  // start the erase in a pause between logs, checked for completion in the next updates
+  if (millis() - last_write < LOG_SPOOL_ERASE_IDLE || isFlashBusy()) return;
+  startFlashSectorErase(getSectorAddress(sector));
+  erased_sector = sector;
+  erasing = true;
+}
+
+// erase the next sector right away (during setup)
+void LoggerLogSpool::prepareNextSector() {
+  last_write = millis() - LOG_SPOOL_ERASE_IDLE; // no need to wait for a pause
+  update();
+  if (erasing) waitForFlash();
+}
+
+/*** deferred writes ***/
+
+// whether the flash is still erasing the next sector (it takes no other commands until then)
+bool LoggerLogSpool::isErasing() {
+  if (erasing && !isFlashBusy()) erasing = false;
+  return(erasing);
+}
+
+// writes wait in RAM during the erase and are written in order after it (a publish mark always follows its record),
+// they only wait for the erase if there is no room left to defer them
+bool LoggerLogSpool::programFlash(uint32_t address, const uint8_t* data, size_t length) {
+  uint16_t n = length;
+  size_t entry = sizeof(address) + sizeof(n) + length;
+  if (isErasing() && deferred_length + entry <= sizeof(deferred)) {
+    memcpy(deferred + deferred_length, &address, sizeof(address));
+    memcpy(deferred + deferred_length + sizeof(address), &n, sizeof(n));
+    memcpy(deferred + deferred_length + sizeof(address) + sizeof(n), data, length);
+    deferred_length += entry;
+    return(true);
+  }
+  return(flushDeferred() && writeFlash(address, data, length));
+}
+
+bool LoggerLogSpool::flushDeferred() {
+  bool success = true;
+  size_t pos = 0;
+  while (pos < deferred_length) {
+    uint32_t address;
+    uint16_t n;
+    memcpy(&address, deferred + pos, sizeof(address));
+    memcpy(&n, deferred + pos + sizeof(address), sizeof(n));
+    pos += sizeof(address) + sizeof(n);
+    if (!writeFlash(address, deferred + pos, n)) {
+      Serial.printlnf("ERROR: could not write to log spool at address %lu", (unsigned long) address);
+      success = false;
+    }
+    pos += n;
+  }
+  deferred_length = 0;
+  return(success);
+}
+
+/*** sectors ***/
+
+bool LoggerLogSpool::startSector(uint32_t sector) {
+  uint32_t address = getSectorAddress(sector);
+  LoggerLogSpoolSector header = { LOG_SPOOL_SECTOR_MAGIC, generation + 1 };
+  // the header of a sector that is still being erased is deferred until the erase is done
+  bool erased = sector == erased_sector;
+  erased_sector = LOG_SPOOL_NO_SECTOR;
+  blocked_pending = UINT32_MAX;
+  if ((!erased && !eraseFlashSector(address)) || !programFlash(address, (const uint8_t*) &header, sizeof(header))) {
+    Serial.printlnf("ERROR: could not start log spool sector %lu", (unsigned long) sector);
+    return(false);
+  }
+  generation++;
+  newest_sector = sector;
+  write_address = getFirstRecord(sector);
+  return(true);
+}
+
+bool LoggerLogSpool::hasPending(uint32_t sector) {
+  LoggerLogSpoolRecord record;
+  uint32_t address = getFirstRecord(sector);
+  while (readRecord(address, record)) {
+    if (record.flags & LOG_SPOOL_FLAG_PENDING) return(true);
+    address += sizeof(record) + record.length;
+  }
+  return(false);
+}
+
+// only moves on to a sector that update() erased (or is erasing), the spool is full otherwise
+bool LoggerLogSpool::nextSector() {
+  uint32_t sector = (newest_sector + 1) % sectors;
+  if (sector != erased_sector) return(false);
+  return(startSector(sector));
+}
+
+/*** records ***/
+
+// whether there is a complete record at the address
+bool LoggerLogSpool::readRecord(uint32_t address, LoggerLogSpoolRecord& record) {
+  uint32_t end = getSectorAddress(getSector(address)) + LOG_SPOOL_SECTOR_SIZE;
+  if (address + sizeof(record) > end) return(false);
+  readFlash(address, (uint8_t*) &record, sizeof(record));
+  return(record.magic == LOG_SPOOL_RECORD_MAGIC && address + sizeof(record) + record.length <= end);
+}
+
+// pending logs that are not in a RAM queue (any from before the restart)
+bool LoggerLogSpool::isDrainable(LoggerLogSpoolRecord& record) {
+  return((record.flags & LOG_SPOOL_FLAG_PENDING) &&
+    (!(record.flags & LOG_SPOOL_FLAG_QUEUED) || record.sequence < startup_sequence));
+}
+
+uint16_t LoggerLogSpool::getCRC(LoggerLogSpoolRecord& record, const char* log) {
+  uint16_t crc = 0xFFFF;
+  crc = updateCRC16(crc, &record.type, sizeof(record.type));
+  crc = updateCRC16(crc, (const uint8_t*) &record.sequence, sizeof(record.sequence));
+  crc = updateCRC16(crc, (const uint8_t*) &record.length, sizeof(record.length));
+  crc = updateCRC16(crc, (const uint8_t*) log, record.length);
+  return(crc);
+}
+
+/*** spool management ***/
+
+uint32_t LoggerLogSpool::append(uint8_t type, const char* log, bool queued) {
+  if (!ready) return(LOG_SPOOL_NO_RECORD);
+  LoggerLogSpoolRecord record;
+  size_t length = strlen(log);
+  if (sizeof(record) + length > LOG_SPOOL_SECTOR_SIZE - sizeof(LoggerLogSpoolSector)) return(LOG_SPOOL_NO_RECORD);
+
+  // move on to the next sector if the log does not fit into the current one
+  if (write_address + sizeof(record) + length > getSectorAddress(newest_sector) + LOG_SPOOL_SECTOR_SIZE && !nextSector()) {
+    dropped++;
+    return(LOG_SPOOL_NO_RECORD);
+  }
+
+  record.magic = LOG_SPOOL_RECORD_MAGIC;
+  record.flags = queued ? 0xFF : (uint8_t) ~LOG_SPOOL_FLAG_QUEUED;
+  record.type = type;
+  record.reserved = 0xFF;
+  record.sequence = sequence++;
+  record.length = length;
+  record.crc = getCRC(record, log);
+
+  // the write position moves on even if the write fails so a torn record is never overwritten
+  last_write = millis();
+  uint32_t address = write_address;
+  write_address += sizeof(record) + length;
+  if (!programFlash(address, (const uint8_t*) &record, sizeof(record)) || !programFlash(address + sizeof(record), (const uint8_t*) log, length)) {
+    Serial.printlnf("ERROR: could not write log to spool at address %lu", (unsigned long) address);
+    return(LOG_SPOOL_NO_RECORD);
+  }
+  pending++;
+  if (!queued) backlog++;
+  return(address);
+}
+
+void LoggerLogSpool::markPublished(uint32_t address) {
+  if (!ready || address == LOG_SPOOL_NO_RECORD) return;
+  uint8_t flags = (uint8_t) ~LOG_SPOOL_FLAG_PENDING;
+  last_write = millis();
+  programFlash(address + offsetof(LoggerLogSpoolRecord, flags), &flags, sizeof(flags));
+  if (pending > 0) pending--;
+}
+
+bool LoggerLogSpool::nextLog(char* log, size_t size, uint8_t* type) {
+  drain_record = LOG_SPOOL_NO_RECORD;
+  if (!ready || backlog == 0) return(false);
+  // no reads while the flash erases the next sector, the drain continues in a later loop
+  if (isErasing()) return(false);
+  flushDeferred();
+  LoggerLogSpoolRecord record;
+  while (drain_address != write_address) {
+    uint32_t address = drain_address;
+    uint32_t sector = getSector(address);
+    if (!readRecord(address, record)) {
+      // end of the records in this sector
+      drain_address = (sector == newest_sector) ? write_address : getFirstRecord((sector + 1) % sectors);
+      continue;
+    }
+    if (!isDrainable(record)) {
+      drain_address += sizeof(record) + record.length;
+      continue;
+    }
+    // the drain position only moves past a log once it is published (it is skipped from then on)
+    if (record.length < size) {
+      readFlash(address + sizeof(record), (uint8_t*) log, record.length);
+      log[record.length] = 0;
+    }
+    if (record.length >= size || getCRC(record, log) != record.crc) {
+      Serial.printlnf("WARNING: discarding corrupted log in spool at address %lu", (unsigned long) address);
+      markPublished(address);
+      if (backlog > 0) backlog--;
+      drain_address += sizeof(record) + record.length;
+      continue;
+    }
+    *type = record.type;
+    drain_record = address;
+    return(true);
+  }
+  // nothing left to drain
+  backlog = 0;
+  return(false);
+}
+
+void LoggerLogSpool::markNextLogPublished() {
+  if (drain_record == LOG_SPOOL_NO_RECORD) return;
+  markPublished(drain_record);
+  if (backlog > 0) backlog--;
+  drain_record = LOG_SPOOL_NO_RECORD;
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include "application.h"
+
+/**** Log spool ****/
+
+// optional persistent log spool on an external SPI NOR flash (e.g. Winbond W25Q series) that keeps queued logs across restarts
+// logs are appended as records [header][log] to a circular sequence of 4kB sectors (log-structured, never rewritten):
+//  - every sector starts with a header holding a generation number so the oldest and newest sectors are found at startup
+//  - every record carries a CRC16 so logs torn by a reset or power loss during the write are skipped
+//  - a record is marked published by clearing a bit in its header (NOR flash bits can be cleared without an erase)
+//  - sectors are erased round robin only when the spool wraps around onto a sector without pending logs,
+//    which spreads the wear evenly over all sectors
+//  - the sector after the newest one is erased ahead of time from update() once the spool is idle (start the erase,
+//    check back in later loops until it is done) so appending a log does not have to erase a sector
+//    (records and publish marks that come in while the erase is running wait in RAM, the drain skips those loops)
+// logs that are also in a RAM queue are published from there (and marked published in the spool by their address),
+// logs that are only in the spool (from before a restart or while the RAM queue was full) are drained oldest first
+
+#define LOG_SPOOL_SECTOR_SIZE       4096
+#define LOG_SPOOL_PAGE_SIZE         256
+#define LOG_SPOOL_SECTOR_MAGIC      0x4C4F4753 // "LOGS"
+#define LOG_SPOOL_RECORD_MAGIC      0xA5
+#define LOG_SPOOL_NO_RECORD         UINT32_MAX
+#define LOG_SPOOL_NO_SECTOR         UINT32_MAX
+#define LOG_SPOOL_TIMEOUT           500 // ms to wait for a flash program / erase to finish
+#define LOG_SPOOL_ERASE_IDLE        100 // ms without spool writes before the next sector is erased (logs come in bursts)
+#define LOG_SPOOL_DEFER_SIZE        1024 // bytes for writes that come in during the erase (a burst of logs)
+
+// record types
+#define LOG_SPOOL_STATE_LOG         's'
+#define LOG_SPOOL_DATA_LOG          'd'
+
+// record flags (bits start at 1 and are cleared, never set)
+#define LOG_SPOOL_FLAG_PENDING      0x01 // cleared once the log is published
+#define LOG_SPOOL_FLAG_QUEUED       0x02 // cleared at write time if the log is not also in a RAM queue
+
+struct LoggerLogSpoolSector {
+  uint32_t magic;
+  uint32_t generation; // increments with every sector that is (re)started
+};
+
+struct LoggerLogSpoolRecord {
+  uint8_t magic;
+  uint8_t flags;
+  uint8_t type;
+  uint8_t reserved;
+  uint32_t sequence; // increments with every record
+  uint16_t length; // log length (without \0)
+  uint16_t crc; // CRC16 of type, sequence, length and log
+};
+
+class LoggerLogSpool {
+
+  private:
+
+    // flash
+    SPIClass* spi;
+    int cs_pin;
+    uint32_t first_sector;
+    uint32_t sectors; // 0 = all sectors of the flash
+    bool ready = false;
+
+    // log structure
+    uint32_t oldest_sector = 0;
+    uint32_t newest_sector = 0;
+    uint32_t generation = 0; // generation of the newest sector
+    uint32_t write_address = 0; // where the next record goes
+    uint32_t sequence = 0; // sequence number of the next record
+    uint32_t startup_sequence = 0; // first record written since startup
+    uint32_t drain_address = 0; // next record to check for logs that are only in the spool
+    uint32_t drain_record = LOG_SPOOL_NO_RECORD; // record returned by the last nextLog()
+
+    // pre-erase of the sector after the newest one
+    uint32_t erased_sector = LOG_SPOOL_NO_SECTOR; // erased and ready to be started (the erase may still be running)
+    bool erasing = false; // whether the flash may still be busy with that erase
+    uint32_t blocked_pending = UINT32_MAX; // pending count when the oldest sector was last found to still have pending logs
+    unsigned long last_write = 0; // millis() of the last record written or marked published
+
+    // writes that came in during the erase, [address][length][data] each (written in order once the erase is done)
+    uint8_t deferred[LOG_SPOOL_DEFER_SIZE];
+    size_t deferred_length = 0;
+
+    // counts
+    uint32_t pending = 0; // logs not yet published
+    uint32_t backlog = 0; // pending logs that are only in the spool
+    uint32_t dropped = 0; // logs not spooled because the spool was full
+
+    uint32_t getSectorAddress(uint32_t sector) { return((first_sector + sector) * LOG_SPOOL_SECTOR_SIZE); }
+    uint32_t getSector(uint32_t address) { return(address / LOG_SPOOL_SECTOR_SIZE - first_sector); }
+    uint32_t getFirstRecord(uint32_t sector) { return(getSectorAddress(sector) + sizeof(LoggerLogSpoolSector)); }
+    bool readRecord(uint32_t address, LoggerLogSpoolRecord& record);
+    bool isDrainable(LoggerLogSpoolRecord& record);
+    bool hasPending(uint32_t sector);
+    bool startSector(uint32_t sector);
+    bool nextSector();
+    void prepareNextSector();
+    uint16_t getCRC(LoggerLogSpoolRecord& record, const char* log);
+    bool isErasing();
+    bool programFlash(uint32_t address, const uint8_t* data, size_t length); // write now or defer it during the erase
+    bool flushDeferred();
+
+  protected:
+
+    // flash access (JEDEC SPI NOR commands, override for other storage)
+    virtual uint32_t detectFlash(); // returns the flash size in bytes (0 if there is none)
+    virtual bool isFlashBusy();
+    virtual bool waitForFlash();
+    virtual void readFlash(uint32_t address, uint8_t* data, size_t length);
+    virtual bool writeFlash(uint32_t address, const uint8_t* data, size_t length);
+    virtual void startFlashSectorErase(uint32_t address); // returns right away, the flash is busy until the erase is done
+    virtual bool eraseFlashSector(uint32_t address);
+
+  public:
+
+    /*** constructors ***/
+    // spi: SPI bus of the flash (SPI or SPI1), cs_pin: chip select of the flash, first_sector/sectors: part of the flash to use (default all)
+    LoggerLogSpool(SPIClass* spi, int cs_pin, uint32_t first_sector = 0, uint32_t sectors = 0) : spi(spi), cs_pin(cs_pin), first_sector(first_sector), sectors(sectors) {};
+
+    /*** setup ***/
+    bool init(); // detect the flash and recover the spool from it, returns false if there is no flash
+    void clear(); // drop all spooled logs
+    void update(); // erase the next sector ahead of time in small steps (call every loop)
+
+    /*** spool management ***/
+    uint32_t append(uint8_t type, const char* log, bool queued); // write a log, returns its address (LOG_SPOOL_NO_RECORD if the spool is full)
+    void markPublished(uint32_t address); // log at this address was published from a RAM queue
+    bool nextLog(char* log, size_t size, uint8_t* type); // next log that is only in the spool (oldest first), false if there is none
+    void markNextLogPublished(); // log returned by nextLog() was published
+
+    /*** spool information ***/
+    bool isReady() { return(ready); }
+    uint32_t getPending() { return(pending); }
+    uint32_t getBacklog() { return(backlog); }
+    uint32_t getDropped() { return(dropped); }
+    uint32_t getSectors() { return(sectors); }
+};
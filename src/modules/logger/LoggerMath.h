@@ -1,5 +1,8 @@
 #pragma once
 #include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 /**** NUMERIC DATA FUNCTIONS ****/
 
@@ -28,17 +31,58 @@ static double round_to_decimals (double number, int decimals) {
     return(round(number * factor) / factor);
 }
 
+// powers of ten for scaling to decimals (the same doubles pow(10.0, decimals) returns)
+#define POW10_MAX_DECIMALS  18
+static const double pow10_positive[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+  1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+static const double pow10_negative[] = {1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9,
+  1e-10, 1e-11, 1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18};
+#define PRINT_MAX_DIGITS    1e15 // largest scaled number that is printed with integers (beyond, doubles are not exact enough)
+
 // print a number to the specified decimals
+// scales and rounds the number once and prints the integer digits (with the decimal point inserted) instead of
+// formatting the double with snprintf("%.Nf") which is slow without an FPU, gives the same text as
+// snprintf(target, size, "%.Nf", round_to_decimals(number, decimals)) (which it falls back to for nan, inf and huge numbers)
 static void print_to_decimals (char* target, int size, double number, int decimals) {
 
-    // round
-    double rounded_number = round_to_decimals(number, decimals);
+    // round (same as round_to_decimals)
+    double scaled = NAN;
+    if (decimals >= 0 && decimals <= POW10_MAX_DECIMALS) scaled = round(number * pow10_positive[decimals]);
+    else if (decimals < 0 && decimals >= -POW10_MAX_DECIMALS) scaled = round(number * pow10_negative[-decimals]);
+
+    if (!(fabs(scaled) < PRINT_MAX_DIGITS) || (decimals < 0 && !(fabs(scaled) * pow10_positive[-decimals] < PRINT_MAX_DIGITS))) {
+      // print the double
+      double rounded_number = round_to_decimals(number, decimals);
+      if (decimals < 0) decimals = 0;
+      char number_pattern[6];
+      snprintf(number_pattern, sizeof(number_pattern), "%%.%df", decimals);
+      snprintf(target, size, number_pattern, rounded_number);
+      return;
+    }
 
-    // print
-    if (decimals < 0) decimals = 0;
-    char number_pattern[6];
-    snprintf(number_pattern, sizeof(number_pattern), "%%.%df", decimals);
-    snprintf(target, size, number_pattern, rounded_number);
+    // print the digits from the back
+    char text[25];
+    int pos = sizeof(text) - 1;
+    text[pos] = 0;
+    uint64_t digits = (uint64_t) fabs(scaled);
+    if (decimals < 0 && digits > 0) {
+      // rounded to tens, hundreds, etc.
+      for (int i = decimals; i < 0; i++) text[--pos] = '0';
+    }
+    int n = 0;
+    do {
+      text[--pos] = '0' + digits % 10;
+      digits /= 10;
+      if (++n == decimals) text[--pos] = '.';
+    } while (digits > 0 || n <= decimals);
+    if (signbit(scaled)) text[--pos] = '-'; // includes -0 like printf
+
+    // copy (truncated like snprintf)
+    if (size <= 0) return;
+    int length = sizeof(text) - 1 - pos;
+    if (length > size - 1) length = size - 1;
+    memcpy(target, text + pos, length);
+    target[length] = 0;
 }
 
 // print a number to the specific significan digits
@@ -46,6 +90,168 @@ static void print_to_signif (char* target, int size, double number, int signif)
     print_to_decimals(target, size, number, find_signif_decimals(number, signif));
 }
 
+/**** Number parsing ****/
+
+// one pass parser for decimal numbers ([white space][+/-][digits][.digits][e/E[+/-]digits]) that is fed byte by byte
+// (e.g. as serial data comes in) and gives the value, the number of fractional digits and the end of the number at once
+// instead of strtod + strlen + strcspn over a buffer; the value is exactly the one strtod gives (directly for up to 15-16
+// significant digits, i.e. mantissas up to 2^53, and powers of ten up to 10^22 where one multiplication/division of exact doubles is exact, through
+// strtod beyond), hex numbers, inf and nan are not numbers here (serial devices do not send them)
+#define DECIMAL_PARSER_MAX_CHAR   32 // longest number kept for the strtod fallback
+#define DECIMAL_PARSER_EXACT_MANTISSA 9007199254740992ULL // 2^53, largest mantissa that is an exact double
+static const double pow10_exact[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22}; // all exactly representable
+
+struct DecimalParser {
+
+    char sep; // decimal separator
+    uint8_t stage; // see add()
+    bool negative;
+    bool has_digits; // whether there was at least one digit (otherwise not a number)
+    bool trailing_garbage; // whether anything but white space followed the number
+    uint64_t mantissa; // significant digits
+    int8_t digits; // number of significant digits in the mantissa
+    bool truncated; // whether there were more significant digits than the mantissa holds
+    int scale; // power of ten of the mantissa (from dropped integer and kept fractional digits)
+    int fractional; // number of digits after the separator
+    int exponent;
+    bool exponent_negative;
+    uint8_t length; // characters of the number (incl. leading white space)
+    uint8_t exponent_start; // length before the exponent (the end of the number if the exponent has no digits)
+    uint8_t n_char; // characters added
+    char text[DECIMAL_PARSER_MAX_CHAR]; // the number (for the strtod fallback)
+
+    public:
+
+        DecimalParser(char sep = '.') {
+            this->sep = sep;
+            clear();
+        }
+
+        void clear() {
+            stage = 0;
+            negative = false;
+            has_digits = false;
+            trailing_garbage = false;
+            mantissa = 0;
+            digits = 0;
+            truncated = false;
+            scale = 0;
+            fractional = 0;
+            exponent = 0;
+            exponent_negative = false;
+            length = 0;
+            exponent_start = 0;
+            n_char = 0;
+        }
+
+        // stages: 0 = leading white space, 1 = after the sign, 2 = integer digits, 3 = fractional digits,
+        // 4 = after the e, 5 = after the exponent sign, 6 = exponent digits, 7 = after the number
+        // @return whether the character is part of the number
+        bool add(char c) {
+            if (n_char < 255) n_char++;
+            if (n_char <= DECIMAL_PARSER_MAX_CHAR) text[n_char - 1] = c;
+            bool digit = c >= '0' && c <= '9';
+            if (stage == 0 && (c == ' ' || (c >= '\t' && c <= '\r'))) {
+                // leading white space (like isspace())
+                length = n_char;
+                return(true);
+            } else if (stage == 0 && (c == '+' || c == '-')) {
+                negative = c == '-';
+                stage = 1;
+            } else if (stage <= 3 && digit) {
+                if (stage < 2) stage = 2;
+                has_digits = true;
+                addDigit(c - '0');
+                length = n_char;
+            } else if (stage <= 2 && c == sep) {
+                stage = 3;
+                if (has_digits) length = n_char; // "1." is a number, "." is not (yet)
+            } else if ((stage == 2 || stage == 3) && has_digits && (c == 'e' || c == 'E')) {
+                stage = 4;
+                exponent_start = length;
+            } else if (stage == 4 && (c == '+' || c == '-')) {
+                exponent_negative = c == '-';
+                stage = 5;
+            } else if (stage >= 4 && stage <= 6 && digit) {
+                stage = 6;
+                if (exponent < 100000) exponent = 10 * exponent + (c - '0');
+                length = n_char;
+            } else {
+                // end of the number: anything other than white space after it is garbage
+                if (stage == 4 || stage == 5) {
+                    // exponent without digits is not part of the number
+                    trailing_garbage = true;
+                    exponent = 0;
+                    length = exponent_start;
+                }
+                stage = 7;
+                if (!(c == ' ' || (c >= '\t' && c <= '\r'))) trailing_garbage = true;
+                return(false);
+            }
+            return(true);
+        }
+
+        // whether a number was found (if strict, also whether only white space followed it)
+        bool isValid(bool strict = true) {
+            if (!has_digits) return(false);
+            if (strict && (trailing_garbage || stage == 4 || stage == 5)) return(false);
+            return(true);
+        }
+
+        // number of digits after the separator
+        int getDecimals() {
+            return(fractional);
+        }
+
+        // number of characters that are part of the number (incl. leading white space, 0 if not a number)
+        int getLength() {
+            if (!has_digits) return(0);
+            return( (stage == 4 || stage == 5) ? exponent_start : length );
+        }
+
+        double getValue() {
+            if (!has_digits) return(0.0);
+            int power = scale + (exponent_negative ? -exponent : exponent); // exponent is 0 unless it has digits
+            double value;
+            if (mantissa == 0) {
+                value = 0.0;
+            } else if (!truncated && mantissa <= DECIMAL_PARSER_EXACT_MANTISSA && power >= -22 && power <= 22) {
+                // exact: one correctly rounded operation on two exact doubles
+                value = (power < 0) ? (double) mantissa / pow10_exact[-power] : (double) mantissa * pow10_exact[power];
+            } else if (getLength() < DECIMAL_PARSER_MAX_CHAR) {
+                // fallback for long mantissas and large exponents
+                char number[DECIMAL_PARSER_MAX_CHAR];
+                memcpy(number, text, getLength());
+                number[getLength()] = 0;
+                if (sep != '.') {
+                    char* sep_pos = strchr(number, sep);
+                    if (sep_pos != NULL) *sep_pos = '.';
+                }
+                return(strtod(number, NULL));
+            } else {
+                // numbers longer than the text (not exact)
+                value = mantissa * pow(10.0, power);
+            }
+            return( negative ? -value : value );
+        }
+
+    private:
+
+        void addDigit(int d) {
+            if (stage == 3) fractional++;
+            if (digits < 19) {
+                if (mantissa > 0 || d > 0) digits++;
+                mantissa = 10 * mantissa + d;
+                if (stage == 3) scale--;
+            } else {
+                if (d > 0) truncated = true;
+                if (stage == 2) scale++;
+            }
+        }
+
+};
+
 /**** Value statistics ****/
 
 // implemented based on Welford's algorithm
@@ -82,6 +288,20 @@ struct RunningStats {
             M2 += delta * (x - mean);
         }
 
+        // combine with the stats of another set of values (Chan et al.'s parallel algorithm, exact)
+        void merge(RunningStats rs) {
+            if (rs.n == 0) return;
+            if (n == 0) {
+                set(rs);
+                return;
+            }
+            int total = n + rs.n;
+            double delta = rs.mean - mean;
+            mean += delta * rs.n / total;
+            M2 += rs.M2 + delta * delta * ((double) n * rs.n / total);
+            n = total;
+        }
+
         int getN() {
             return n;
         }
@@ -101,3 +321,199 @@ struct RunningStats {
 
 
 };
+
+/**** Value summary ****/
+
+// streaming quantile estimate with constant memory (P-square algorithm of Jain & Chlamtac 1985)
+// keeps 5 markers (min, p/2, p, (1+p)/2, max quantiles) whose heights are adjusted with a piecewise parabolic
+// prediction as values come in, exact for the first 5 values, typically within a few % of the spread afterwards
+struct P2Quantile {
+
+    uint8_t percentile; // which quantile to estimate (in %, 1-99, 0 = not used)
+    int n; // number of values
+    double q[5]; // marker heights (the first n values, sorted, while n < 5)
+    int pos[5]; // marker positions (1-based ranks)
+
+    public:
+
+        P2Quantile() {
+            percentile = 0;
+            clear();
+        }
+
+        void clear() {
+            n = 0;
+        }
+
+        void add(double x) {
+            // first 5 values: keep sorted
+            if (n < 5) {
+                int i = n++;
+                for (; i > 0 && q[i - 1] > x; i--) q[i] = q[i - 1];
+                q[i] = x;
+                if (n == 5) for (i = 0; i < 5; i++) pos[i] = i + 1;
+                return;
+            }
+
+            // find the cell of x and move the markers above it
+            n++;
+            int k;
+            if (x < q[0]) {
+                q[0] = x;
+                k = 0;
+            } else if (x >= q[4]) {
+                q[4] = x;
+                k = 3;
+            } else {
+                for (k = 0; x >= q[k + 1]; k++);
+            }
+            for (int i = k + 1; i < 5; i++) pos[i]++;
+
+            // adjust the inner markers that are off their desired position by more than 1
+            double p = percentile / 100.0;
+            double fractions[] = {p / 2, p, (1 + p) / 2};
+            for (int i = 1; i <= 3; i++) {
+                double d = 1 + (n - 1) * fractions[i - 1] - pos[i];
+                if ((d >= 1 && pos[i + 1] - pos[i] > 1) || (d <= -1 && pos[i - 1] - pos[i] < -1)) {
+                    int s = (d >= 0) ? 1 : -1;
+                    double parabolic = q[i] + (double) s / (pos[i + 1] - pos[i - 1]) *
+                        ((pos[i] - pos[i - 1] + s) * (q[i + 1] - q[i]) / (pos[i + 1] - pos[i]) +
+                         (pos[i + 1] - pos[i] - s) * (q[i] - q[i - 1]) / (pos[i] - pos[i - 1]));
+                    q[i] = (q[i - 1] < parabolic && parabolic < q[i + 1]) ?
+                        parabolic : q[i] + s * (q[i + s] - q[i]) / (pos[i + s] - pos[i]);
+                    pos[i] += s;
+                }
+            }
+        }
+
+        int getN() {
+            return n;
+        }
+
+        double get() {
+            if (n == 0) return NAN;
+            if (n >= 5) return q[2];
+            // exact (interpolated) quantile of the first values
+            double rank = (n - 1) * percentile / 100.0;
+            int i = (int) rank;
+            return ( (i + 1 < n) ? q[i] + (rank - i) * (q[i + 1] - q[i]) : q[i] );
+        }
+
+};
+
+// min, max and streaming quantiles of a set of values (for noisy data where the mean and standard deviation hide spikes and skew)
+#define SUMMARY_MAX_QUANTILES 3
+struct RunningSummary {
+
+    int n;
+    double min;
+    double max;
+    P2Quantile quantiles[SUMMARY_MAX_QUANTILES];
+
+    public:
+
+        // @param percentiles which quantiles to estimate (in %, 1-99, 0 = not used), by default only the median
+        RunningSummary(uint8_t percentile1 = 50, uint8_t percentile2 = 0, uint8_t percentile3 = 0) {
+            setPercentiles(percentile1, percentile2, percentile3);
+        }
+
+        void setPercentiles(uint8_t percentile1, uint8_t percentile2 = 0, uint8_t percentile3 = 0) {
+            uint8_t percentiles[] = {percentile1, percentile2, percentile3};
+            for (int i = 0; i < SUMMARY_MAX_QUANTILES; i++)
+                quantiles[i].percentile = (percentiles[i] < 100) ? percentiles[i] : 0;
+            clear();
+        }
+
+        void clear() {
+            n = 0;
+            min = NAN;
+            max = NAN;
+            for (int i = 0; i < SUMMARY_MAX_QUANTILES; i++) quantiles[i].clear();
+        }
+
+        void add(double x) {
+            if (n == 0 || x < min) min = x;
+            if (n == 0 || x > max) max = x;
+            n++;
+            for (int i = 0; i < SUMMARY_MAX_QUANTILES; i++) {
+                if (quantiles[i].percentile > 0) quantiles[i].add(x);
+            }
+        }
+
+        int getN() {
+            return n;
+        }
+
+        double getMin() {
+            return min;
+        }
+
+        double getMax() {
+            return max;
+        }
+
+};
+
+/**** Outlier rejection ****/
+
+// Hampel filter: rejects a value that is further from the median of the recent values than threshold robust standard
+// deviations (1.4826 x the median absolute deviation), accepts everything until the window is full
+// all values (also rejected ones) enter the window so a real step change is accepted once it fills half the window
+#define HAMPEL_MAX_WINDOW 15
+struct HampelFilter {
+
+    uint8_t window; // number of recent values to compare to
+    uint8_t n; // number of values in the window so far
+    uint8_t pos; // next position in the ring
+    float threshold; // in robust standard deviations
+    double ring[HAMPEL_MAX_WINDOW];
+
+    public:
+
+        HampelFilter(uint8_t window = 7, float threshold = 3.0) {
+            configure(window, threshold);
+        }
+
+        // change window and threshold (starts over)
+        void configure(uint8_t window, float threshold) {
+            this->window = (window < 3) ? 3 : (window > HAMPEL_MAX_WINDOW) ? HAMPEL_MAX_WINDOW : window;
+            this->threshold = threshold;
+            clear();
+        }
+
+        void clear() {
+            n = 0;
+            pos = 0;
+        }
+
+        // @param resolution smallest deviation that counts (e.g. the precision of the data) so quantized values
+        // whose median absolute deviation is 0 do not reject every change
+        bool accept(double x, double resolution = 0.0) {
+            bool accepted = true;
+            if (n == window) {
+                double sorted[HAMPEL_MAX_WINDOW] = {};
+                double median = getMedian(ring, sorted);
+                double deviations[HAMPEL_MAX_WINDOW];
+                for (int i = 0; i < window; i++) deviations[i] = fabs(ring[i] - median);
+                double sigma = 1.4826 * getMedian(deviations, sorted);
+                if (sigma < resolution) sigma = resolution;
+                accepted = !(fabs(x - median) > threshold * sigma);
+            }
+            ring[pos] = x;
+            pos = (pos + 1) % window;
+            if (n < window) n++;
+            return accepted;
+        }
+
+    private:
+
+        double getMedian(const double* values, double* sorted) {
+            for (int i = 0; i < window; i++) {
+                int j = i;
+                for (; j > 0 && sorted[j - 1] > values[i]; j--) sorted[j] = sorted[j - 1];
+                sorted[j] = values[i];
+            }
+            return( (window % 2 == 1) ? sorted[window / 2] : (sorted[window / 2 - 1] + sorted[window / 2]) / 2 );
+        }
+
+};
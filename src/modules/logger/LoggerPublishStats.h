@@ -0,0 +1,98 @@
+#pragma once
+#include <stdint.h>
+#include "LoggerWriter.h"
+
+/**** Publish statistics ****/
+
+// histogram with logarithmic bins (each bin 4x wider than the previous one) plus mean and max
+// bin i holds values < first * 4^i, the last bin holds everything above
+#define HISTOGRAM_BINS    7
+
+struct LoggerHistogram {
+
+    uint32_t first; // upper limit of the first bin
+    uint32_t bins[HISTOGRAM_BINS];
+    uint32_t n;
+    uint32_t max;
+    double sum;
+
+    public:
+
+        LoggerHistogram(uint32_t first) : first(first) {
+          clear();
+        }
+
+        void clear() {
+            for (int i = 0; i < HISTOGRAM_BINS; i++) bins[i] = 0;
+            n = 0;
+            max = 0;
+            sum = 0.0;
+        }
+
+        void add(uint32_t value) {
+            int i = 0;
+            for (uint32_t limit = first; i < HISTOGRAM_BINS - 1 && value >= limit; limit *= 4) i++;
+            bins[i]++;
+            n++;
+            sum += value;
+            if (value > max) max = value;
+        }
+
+        uint32_t getMean() {
+            return(n > 0 ? (uint32_t) (sum / n + 0.5) : 0);
+        }
+
+        // [mean,max,bin 0,...,bin 6], returns false if it did not fit
+        bool assembleJson(LoggerWriter& writer) {
+            writer.appendf("[%lu,%lu", (unsigned long) getMean(), (unsigned long) max);
+            for (int i = 0; i < HISTOGRAM_BINS; i++) writer.appendf(",%lu", (unsigned long) bins[i]);
+            writer.append(']');
+            return(!writer.overflow);
+        }
+
+};
+
+// publishes from one log queue
+//  - latency: ms from the start of a publish to the cloud acknowledgement (or failure), bins <64ms, <256ms, <1s, <4s, <16s, <65s, more
+//  - residence: s from queueing a log to the acknowledgement of its publish, bins <16s, <1m, <4m, <17m, <68m, <4.6h, more
+#define PUBLISH_LATENCY_FIRST_BIN     64 // ms
+#define PUBLISH_RESIDENCE_FIRST_BIN   16 // s
+
+struct LoggerPublishStats {
+
+    uint32_t publishes; // publish attempts
+    uint32_t succeeded;
+    uint32_t failed;
+    uint32_t retries; // attempts to publish log(s) that failed before
+    uint32_t logs; // logs published (batches hold several)
+    LoggerHistogram latency;
+    LoggerHistogram residence;
+
+    public:
+
+        LoggerPublishStats() : latency(PUBLISH_LATENCY_FIRST_BIN), residence(PUBLISH_RESIDENCE_FIRST_BIN) {
+          clear();
+        }
+
+        void clear() {
+            publishes = 0;
+            succeeded = 0;
+            failed = 0;
+            retries = 0;
+            logs = 0;
+            latency.clear();
+            residence.clear();
+        }
+
+        // {"p":publishes,"ok":succeeded,"f":failed,"r":retries,"l":logs,"lat":[latency],"res":[residence]}, returns false if it did not fit
+        bool assembleJson(LoggerWriter& writer) {
+            writer.appendf("{\"p\":%lu,\"ok\":%lu,\"f\":%lu,\"r\":%lu,\"l\":%lu,\"lat\":",
+              (unsigned long) publishes, (unsigned long) succeeded, (unsigned long) failed, (unsigned long) retries, (unsigned long) logs);
+            latency.assembleJson(writer);
+            writer.append(",\"res\":");
+            residence.assembleJson(writer);
+            writer.append('}');
+            return(!writer.overflow);
+        }
+
+};
@@ -0,0 +1,159 @@
+#pragma once
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+#include "LoggerWriter.h"
+
+/**** Compile-time serializers for printf patterns ****/
+
+// a layout wraps one of the PATTERN_* printf formats (see LoggerUtils.h) so that its literal fragments and conversions
+// (%d, %s, %lu) are located at compile time: serializing becomes a copy of each constant fragment followed by the
+// formatted field instead of snprintf parsing the pattern on every call
+// a layout is only used for arguments whose types match its conversions (checked at compile time), like printf
+// any arguments beyond the pattern's conversions are ignored
+
+#define LOGGER_LAYOUT(name, pattern_text) \
+  struct name { static constexpr const char* pattern() { return(pattern_text); } };
+
+/*** pattern analysis (constexpr) ***/
+
+// length of the conversion starting at pos ("%d", "%s" or "%lu")
+static constexpr size_t getPatternConversionLength(const char* pattern, size_t pos) {
+  return(pattern[pos + 1] == 'l' ? 3 : 2);
+}
+
+// type character of the conversion starting at pos ('d', 's' or 'u')
+static constexpr char getPatternConversionType(const char* pattern, size_t pos) {
+  return(pattern[pos + getPatternConversionLength(pattern, pos) - 1]);
+}
+
+// position of conversion i (or the end of the pattern if there are fewer conversions)
+static constexpr size_t getPatternConversion(const char* pattern, size_t i) {
+  size_t pos = 0;
+  for (; pattern[pos] != 0; pos++) {
+    if (pattern[pos] == '%') {
+      if (i == 0) return(pos);
+      i--;
+      pos += getPatternConversionLength(pattern, pos) - 1;
+    }
+  }
+  return(pos);
+}
+
+// start of the literal fragment before conversion i (i.e. after conversion i - 1)
+static constexpr size_t getPatternFragment(const char* pattern, size_t i) {
+  return(i == 0 ? 0 : getPatternConversion(pattern, i - 1) + getPatternConversionLength(pattern, getPatternConversion(pattern, i - 1)));
+}
+
+static constexpr size_t getPatternConversions(const char* pattern) {
+  size_t n = 0;
+  for (size_t pos = 0; pattern[pos] != 0; pos++) {
+    if (pattern[pos] == '%') {
+      n++;
+      pos += getPatternConversionLength(pattern, pos) - 1;
+    }
+  }
+  return(n);
+}
+
+/*** fields ***/
+
+template<typename T> struct LoggerFieldType { static constexpr char type = 0; };
+template<> struct LoggerFieldType<int> { static constexpr char type = 'd'; };
+template<> struct LoggerFieldType<unsigned long> { static constexpr char type = 'u'; };
+template<> struct LoggerFieldType<char*> { static constexpr char type = 's'; };
+template<> struct LoggerFieldType<const char*> { static constexpr char type = 's'; };
+
+// whether arguments of these types can be serialized with the pattern
+template<typename... Args>
+static constexpr bool isPatternCompatible(const char* pattern) {
+  const char types[] = {LoggerFieldType<Args>::type..., 0};
+  size_t n = getPatternConversions(pattern);
+  if (n > sizeof...(Args)) return(false);
+  for (size_t i = 0; i < n; i++) {
+    if (getPatternConversionType(pattern, getPatternConversion(pattern, i)) != types[i]) return(false);
+  }
+  return(true);
+}
+
+static inline void appendField(LoggerWriter& writer, const char* value) {
+  writer.append(value);
+}
+
+static inline void appendField(LoggerWriter& writer, unsigned long value) {
+  char text[12];
+  int pos = sizeof(text);
+  do {
+    text[--pos] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0);
+  writer.append(text + pos, sizeof(text) - pos);
+}
+
+static inline void appendField(LoggerWriter& writer, int value) {
+  if (value < 0) {
+    writer.append('-');
+    appendField(writer, (unsigned long) -(long) value);
+  } else {
+    appendField(writer, (unsigned long) value);
+  }
+}
+
+/*** serialization ***/
+
+// fragment I of the pattern followed by field I, then the rest
+template<typename Layout, size_t I, size_t N>
+struct LoggerSerializer {
+  template<typename Arg, typename... Args>
+  static void write(LoggerWriter& writer, Arg arg, Args... args) {
+    constexpr size_t start = getPatternFragment(Layout::pattern(), I);
+    constexpr size_t end = getPatternConversion(Layout::pattern(), I);
+    writer.append(Layout::pattern() + start, end - start);
+    appendField(writer, arg);
+    LoggerSerializer<Layout, I + 1, N>::write(writer, args...);
+  }
+};
+
+// last fragment of the pattern
+template<typename Layout, size_t N>
+struct LoggerSerializer<Layout, N, N> {
+  template<typename... Args>
+  static void write(LoggerWriter& writer, Args... args) {
+    constexpr size_t start = getPatternFragment(Layout::pattern(), N);
+    constexpr size_t end = getPatternConversion(Layout::pattern(), N);
+    writer.append(Layout::pattern() + start, end - start);
+  }
+};
+
+// serialize with a layout, returns false if the arguments do not fit the layout or the text does not fit the target
+template<typename Layout, typename... Args>
+static bool serializeLayout(char* target, int size, std::true_type compatible, Args... args) {
+  LoggerWriter writer(target, size);
+  LoggerSerializer<Layout, 0, getPatternConversions(Layout::pattern())>::write(writer, args...);
+  return(!writer.overflow);
+}
+
+template<typename Layout, typename... Args>
+static bool serializeLayout(char* target, int size, std::false_type compatible, Args... args) {
+  return(false);
+}
+
+// list of layouts to find a pattern in
+template<typename... Layouts> struct LoggerLayouts;
+
+template<> struct LoggerLayouts<> {
+  template<typename... Args>
+  static bool serialize(char* target, int size, const char* pattern, bool compare_text, Args... args) {
+    return(false);
+  }
+};
+
+template<typename Layout, typename... Layouts> struct LoggerLayouts<Layout, Layouts...> {
+  template<typename... Args>
+  static bool serialize(char* target, int size, const char* pattern, bool compare_text, Args... args) {
+    if (pattern == Layout::pattern() || (compare_text && strcmp(pattern, Layout::pattern()) == 0)) {
+      return(serializeLayout<Layout>(target, size, std::integral_constant<bool, isPatternCompatible<Args...>(Layout::pattern())>(), args...));
+    }
+    return(LoggerLayouts<Layouts...>::serialize(target, size, pattern, compare_text, args...));
+  }
+};
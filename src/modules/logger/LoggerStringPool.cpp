@@ -0,0 +1,28 @@
+#include "application.h"
+#include "LoggerStringPool.h"
+
+char LoggerStringPool::pool[STRING_POOL_SIZE] = ""; // starts with the empty string
+size_t LoggerStringPool::used = 1;
+bool LoggerStringPool::overflow = false;
+
+LoggerString LoggerStringPool::intern(const char* text) {
+  size_t length = strnlen(text, STRING_POOL_MAX_CHAR - 1);
+  if (length == 0) return(0);
+
+  // already in the pool?
+  for (size_t pos = 1; pos < used; pos += strlen(pool + pos) + 1) {
+    if (strncmp(pool + pos, text, length) == 0 && pool[pos + length] == 0) return(pos);
+  }
+
+  // add
+  if (used + length + 1 > sizeof(pool)) {
+    Serial.printlnf("ERROR: string pool is full (%d bytes), '%s' NOT stored - increase STRING_POOL_SIZE", (int) sizeof(pool), text);
+    overflow = true;
+    return(0);
+  }
+  LoggerString handle = used;
+  memcpy(pool + used, text, length);
+  pool[used + length] = 0;
+  used += length + 1;
+  return(handle);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "application.h"
+
+/**** Interned string pool ****/
+
+// keys and units of all data are stored once in a shared pool and referenced by a 2 byte handle (their offset in the pool)
+// instead of a fixed size char array in every LoggerData (identical strings, e.g. the units of several channels, share one entry)
+// strings are never removed: the pool only grows by strings that were never seen before (keys and units at setup, plus the
+// few units a device can switch to), derived texts (e.g. units with the gas of an MFC) are rendered when logged instead (see LoggerData::units_suffix)
+// handle 0 is the empty string, a full pool is an error (components are refused at setup, units changes are ignored afterwards)
+
+#define STRING_POOL_SIZE      256 // bytes for all interned strings (incl. their \0)
+#define STRING_POOL_MAX_CHAR  25  // longest string (incl. \0), longer strings are truncated (as the previous char arrays)
+
+typedef uint16_t LoggerString;
+
+class LoggerStringPool {
+
+  private:
+
+    static char pool[STRING_POOL_SIZE];
+    static size_t used;
+    static bool overflow;
+
+  public:
+
+    // handle of the text (added to the pool if it is not in there yet, the empty string and overflow if the pool is full)
+    static LoggerString intern(const char* text);
+
+    static const char* get(LoggerString handle) {
+      return(pool + handle);
+    }
+
+    static size_t getUsed() {
+      return(used);
+    }
+
+    // whether a string was ever refused because the pool was full
+    static bool hasOverflowed() {
+      return(overflow);
+    }
+
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+
+/**** Timestamps ****/
+
+// text of a time (seconds since 1970) in the log format "%Y-%m-%d %H:%M:%S %Z" (e.g. "2026-01-01 00:00:00 GMT")
+// and the compact epoch form (e.g. "1767225600") without Time.format's heap allocated String (or %llu, which newlib nano lacks)
+// the text of the last time is kept so repeated requests within the same second do not format again
+#define TIMESTAMP_MAX_CHAR        24 // "YYYY-MM-DD HH:MM:SS GMT" + \0
+#define TIMESTAMP_EPOCH_MAX_CHAR  21 // 64-bit seconds + \0
+
+struct LoggerTimestamp {
+
+    time_t date_time = -1; // local time of date_time_text
+    char date_time_text[TIMESTAMP_MAX_CHAR];
+    time_t epoch = -1; // time of epoch_text
+    char epoch_text[TIMESTAMP_EPOCH_MAX_CHAR];
+
+    public:
+
+        // @param offset seconds between local time and UTC (Time.zone + DST)
+        const char* getDateTime(time_t time, long offset = 0) {
+            if (time + offset != date_time) {
+                date_time = time + offset;
+                formatDateTime(date_time_text, date_time);
+            }
+            return(date_time_text);
+        }
+
+        const char* getEpoch(time_t time) {
+            if (time != epoch) {
+                printInteger(epoch_text, time);
+                epoch = time;
+            }
+            return(epoch_text);
+        }
+
+        // 64-bit integer (e.g. epoch ms) as text, target needs TIMESTAMP_EPOCH_MAX_CHAR characters
+        static void printInteger(char* target, int64_t value) {
+            char digits[TIMESTAMP_EPOCH_MAX_CHAR];
+            int n = 0;
+            uint64_t magnitude = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+            do {
+                digits[n++] = '0' + magnitude % 10;
+                magnitude /= 10;
+            } while (magnitude > 0);
+            int pos = 0;
+            if (value < 0) target[pos++] = '-';
+            while (n > 0) target[pos++] = digits[--n];
+            target[pos] = 0;
+        }
+
+    private:
+
+        static void printDigits(char* target, int value, int digits) {
+            for (int i = digits - 1; i >= 0; i--) {
+                target[i] = '0' + value % 10;
+                value /= 10;
+            }
+        }
+
+        // calendar date from days since 1970-01-01 (proleptic Gregorian, H. Hinnant's civil_from_days)
+        static void formatDateTime(char* target, time_t time) {
+            int64_t days = time / 86400;
+            int64_t seconds = time % 86400;
+            if (seconds < 0) {
+                seconds += 86400;
+                days--;
+            }
+            days += 719468;
+            int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+            int64_t day_of_era = days - era * 146097;
+            int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+            int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+            int64_t month_index = (5 * day_of_year + 2) / 153; // March = 0
+            int day = day_of_year - (153 * month_index + 2) / 5 + 1;
+            int month = month_index < 10 ? month_index + 3 : month_index - 9;
+            int year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+            // YYYY-MM-DD HH:MM:SS GMT
+            printDigits(target, year, 4);
+            target[4] = '-';
+            printDigits(target + 5, month, 2);
+            target[7] = '-';
+            printDigits(target + 8, day, 2);
+            target[10] = ' ';
+            printDigits(target + 11, seconds / 3600, 2);
+            target[13] = ':';
+            printDigits(target + 14, (seconds / 60) % 60, 2);
+            target[16] = ':';
+            printDigits(target + 17, seconds % 60, 2);
+            target[19] = ' ';
+            target[20] = 'G';
+            target[21] = 'M';
+            target[22] = 'T';
+            target[23] = 0;
+        }
+
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "LoggerMath.h"
+#include "LoggerSerializer.h"
 
 /**** helper functions for textual translations of state values ****/
 
@@ -37,6 +38,8 @@
 #define PATTERN_IKV_JSON_QUOTED   "{\"i\":%d,\"k\":\"%s\",\"v\":\"%s\"}"
 #define PATTERN_IKV_SIMPLE        "#%d %s: %s"
 
+#define PATTERN_IKU_JSON          "{\"i\":%d,\"k\":\"%s\",\"u\":\"%s\"}"
+
 #define PATTERN_KV_JSON           "{\"k\":\"%s\",\"v\":%s}"
 #define PATTERN_KV_JSON_QUOTED    "{\"k\":\"%s\",\"v\":\"%s\"}"
 #define PATTERN_KV_SIMPLE         "%s: %s"
@@ -45,60 +48,134 @@
 #define PATTERN_VU_SIMPLE         "%s%s"
 #define PATTERN_V_SIMPLE          "%s"
 
+// compile-time layouts of the patterns (see LoggerSerializer.h), the getInfo functions serialize with the
+// matching layout and only fall back to snprintf for other patterns or text that does not fit the target
+LOGGER_LAYOUT(LayoutIKVSUNT_JSON, PATTERN_IKVSUNT_JSON)
+LOGGER_LAYOUT(LayoutIKVSUN_JSON, PATTERN_IKVSUN_JSON)
+LOGGER_LAYOUT(LayoutIKVSUN_SIMPLE, PATTERN_IKVSUN_SIMPLE)
+LOGGER_LAYOUT(LayoutKVSUNT_JSON, PATTERN_KVSUNT_JSON)
+LOGGER_LAYOUT(LayoutKVSUN_JSON, PATTERN_KVSUN_JSON)
+LOGGER_LAYOUT(LayoutKVSUN_SIMPLE, PATTERN_KVSUN_SIMPLE)
+LOGGER_LAYOUT(LayoutIKVUNT_JSON, PATTERN_IKVUNT_JSON)
+LOGGER_LAYOUT(LayoutIKVUN_JSON, PATTERN_IKVUN_JSON)
+LOGGER_LAYOUT(LayoutIKVUN_SIMPLE, PATTERN_IKVUN_SIMPLE)
+LOGGER_LAYOUT(LayoutKVUNT_JSON, PATTERN_KVUNT_JSON)
+LOGGER_LAYOUT(LayoutKVUN_JSON, PATTERN_KVUN_JSON)
+LOGGER_LAYOUT(LayoutKVUN_JSON_QUOTED, PATTERN_KVUN_JSON_QUOTED)
+LOGGER_LAYOUT(LayoutKVUN_SIMPLE, PATTERN_KVUN_SIMPLE)
+LOGGER_LAYOUT(LayoutIKVU_JSON, PATTERN_IKVU_JSON)
+LOGGER_LAYOUT(LayoutIKVU_JSON_QUOTED, PATTERN_IKVU_JSON_QUOTED)
+LOGGER_LAYOUT(LayoutIKVU_SIMPLE, PATTERN_IKVU_SIMPLE)
+LOGGER_LAYOUT(LayoutKVU_JSON, PATTERN_KVU_JSON)
+LOGGER_LAYOUT(LayoutKVU_JSON_QUOTED, PATTERN_KVU_JSON_QUOTED)
+LOGGER_LAYOUT(LayoutKVU_SIMPLE, PATTERN_KVU_SIMPLE)
+LOGGER_LAYOUT(LayoutIKV_JSON, PATTERN_IKV_JSON)
+LOGGER_LAYOUT(LayoutIKV_JSON_QUOTED, PATTERN_IKV_JSON_QUOTED)
+LOGGER_LAYOUT(LayoutIKV_SIMPLE, PATTERN_IKV_SIMPLE)
+LOGGER_LAYOUT(LayoutIKU_JSON, PATTERN_IKU_JSON)
+LOGGER_LAYOUT(LayoutKV_JSON, PATTERN_KV_JSON)
+LOGGER_LAYOUT(LayoutKV_JSON_QUOTED, PATTERN_KV_JSON_QUOTED)
+LOGGER_LAYOUT(LayoutKV_SIMPLE, PATTERN_KV_SIMPLE)
+LOGGER_LAYOUT(LayoutVUN_SIMPLE, PATTERN_VUN_SIMPLE)
+LOGGER_LAYOUT(LayoutVU_SIMPLE, PATTERN_VU_SIMPLE)
+LOGGER_LAYOUT(LayoutV_SIMPLE, PATTERN_V_SIMPLE)
+
+typedef LoggerLayouts<
+  LayoutIKVSUNT_JSON,
+  LayoutIKVSUN_JSON,
+  LayoutIKVSUN_SIMPLE,
+  LayoutKVSUNT_JSON,
+  LayoutKVSUN_JSON,
+  LayoutKVSUN_SIMPLE,
+  LayoutIKVUNT_JSON,
+  LayoutIKVUN_JSON,
+  LayoutIKVUN_SIMPLE,
+  LayoutKVUNT_JSON,
+  LayoutKVUN_JSON,
+  LayoutKVUN_JSON_QUOTED,
+  LayoutKVUN_SIMPLE,
+  LayoutIKVU_JSON,
+  LayoutIKVU_JSON_QUOTED,
+  LayoutIKVU_SIMPLE,
+  LayoutKVU_JSON,
+  LayoutKVU_JSON_QUOTED,
+  LayoutKVU_SIMPLE,
+  LayoutIKV_JSON,
+  LayoutIKV_JSON_QUOTED,
+  LayoutIKV_SIMPLE,
+  LayoutIKU_JSON,
+  LayoutKV_JSON,
+  LayoutKV_JSON_QUOTED,
+  LayoutKV_SIMPLE,
+  LayoutVUN_SIMPLE,
+  LayoutVU_SIMPLE,
+  LayoutV_SIMPLE
+> LoggerPatternLayouts;
+
+// serialize the arguments with the layout of the pattern, returns false if there is none (or the text is too long)
+template<typename... Args>
+static bool serializePattern(char* target, int size, const char* pattern, Args... args) {
+  if (size <= 0) return(false);
+  // the PATTERN_* literals are usually passed as is (pointer match), other pointers are compared by text
+  return(
+    LoggerPatternLayouts::serialize(target, size, pattern, false, args...) ||
+    LoggerPatternLayouts::serialize(target, size, pattern, true, args...));
+}
+
 /**** GENERAL UTILITY FUNCTIONS ****/
 
-static void getInfoIdxKeyValueSigmaUnitsNumberTimeOffset(char* target, int size, int idx, char* key, char* value, char* sigma, char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_IKVSUNT_JSON) {
-  snprintf(target, size, pattern, idx, key, value, sigma, units, n, time_offset);
+static void getInfoIdxKeyValueSigmaUnitsNumberTimeOffset(char* target, int size, int idx, const char* key, char* value, char* sigma, const char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_IKVSUNT_JSON) {
+  if (!serializePattern(target, size, pattern, idx, key, value, sigma, units, n, time_offset)) snprintf(target, size, pattern, idx, key, value, sigma, units, n, time_offset);
 }
 
-static void getInfoKeyValueSigmaUnitsNumberTimeOffset(char* target, int size, char* key, char* value, char* sigma, char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_IKVSUNT_JSON) {
-  snprintf(target, size, pattern, key, value, sigma, units, n, time_offset);
+static void getInfoKeyValueSigmaUnitsNumberTimeOffset(char* target, int size, const char* key, char* value, char* sigma, const char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_KVSUNT_JSON) {
+  if (!serializePattern(target, size, pattern, key, value, sigma, units, n, time_offset)) snprintf(target, size, pattern, key, value, sigma, units, n, time_offset);
 }
 
-static void getInfoIdxKeyValueUnitsNumberTimeOffset(char* target, int size, int idx, char* key, char* value, char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_IKVUNT_JSON) {
-  snprintf(target, size, pattern, idx, key, value, units, n, time_offset);
+static void getInfoIdxKeyValueUnitsNumberTimeOffset(char* target, int size, int idx, const char* key, char* value, const char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_IKVUNT_JSON) {
+  if (!serializePattern(target, size, pattern, idx, key, value, units, n, time_offset)) snprintf(target, size, pattern, idx, key, value, units, n, time_offset);
 }
 
-static void getInfoKeyValueUnitsNumberTimeOffset(char* target, int size, char* key, char* value, char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_KVUNT_JSON) {
-  snprintf(target, size, pattern, key, value, units, n, time_offset);
+static void getInfoKeyValueUnitsNumberTimeOffset(char* target, int size, const char* key, char* value, const char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_KVUNT_JSON) {
+  if (!serializePattern(target, size, pattern, key, value, units, n, time_offset)) snprintf(target, size, pattern, key, value, units, n, time_offset);
 }
 
-static void getInfoKeyValueUnitsNumber(char* target, int size, char* key, char* value, char* units, int n, const char* pattern = PATTERN_KVUN_SIMPLE) {
-  snprintf(target, size, pattern, key, value, units, n);
+static void getInfoKeyValueUnitsNumber(char* target, int size, const char* key, char* value, const char* units, int n, const char* pattern = PATTERN_KVUN_SIMPLE) {
+  if (!serializePattern(target, size, pattern, key, value, units, n)) snprintf(target, size, pattern, key, value, units, n);
 }
 
-static void getInfoValueUnitsNumber(char* target, int size, char* value, char* units, int n, const char* pattern = PATTERN_VUN_SIMPLE) {
-  snprintf(target, size, pattern, value, units, n);
+static void getInfoValueUnitsNumber(char* target, int size, char* value, const char* units, int n, const char* pattern = PATTERN_VUN_SIMPLE) {
+  if (!serializePattern(target, size, pattern, value, units, n)) snprintf(target, size, pattern, value, units, n);
 }
 
-static void getInfoIdxKeyValueUnits(char* target, int size, int idx, char* key, char* value, char* units, const char* pattern = PATTERN_IKVU_SIMPLE) {
-  snprintf(target, size, pattern, idx, key, value, units);
+static void getInfoIdxKeyValueUnits(char* target, int size, int idx, const char* key, char* value, const char* units, const char* pattern = PATTERN_IKVU_SIMPLE) {
+  if (!serializePattern(target, size, pattern, idx, key, value, units)) snprintf(target, size, pattern, idx, key, value, units);
 }
 
-static void getInfoKeyValueUnits(char* target, int size, char* key, char* value, char* units, const char* pattern = PATTERN_KVU_SIMPLE) {
-  snprintf(target, size, pattern, key, value, units);
+static void getInfoKeyValueUnits(char* target, int size, const char* key, char* value, const char* units, const char* pattern = PATTERN_KVU_SIMPLE) {
+  if (!serializePattern(target, size, pattern, key, value, units)) snprintf(target, size, pattern, key, value, units);
 }
 
-static void getInfoIdxKeyValue(char* target, int size, int idx, char* key, char* value, const char* pattern = PATTERN_IKV_SIMPLE) {
-  snprintf(target, size, pattern, idx, key, value);
+static void getInfoIdxKeyValue(char* target, int size, int idx, const char* key, char* value, const char* pattern = PATTERN_IKV_SIMPLE) {
+  if (!serializePattern(target, size, pattern, idx, key, value)) snprintf(target, size, pattern, idx, key, value);
 }
 
-static void getInfoKeyValue(char* target, int size, char* key, char* value, const char* pattern = PATTERN_KV_SIMPLE) {
-  snprintf(target, size, pattern, key, value);
+static void getInfoKeyValue(char* target, int size, const char* key, char* value, const char* pattern = PATTERN_KV_SIMPLE) {
+  if (!serializePattern(target, size, pattern, key, value)) snprintf(target, size, pattern, key, value);
 }
 
-static void getInfoValueUnits(char* target, int size, char* value, char* units, const char* pattern = PATTERN_VU_SIMPLE) {
-  snprintf(target, size, pattern, value, units);
+static void getInfoValueUnits(char* target, int size, char* value, const char* units, const char* pattern = PATTERN_VU_SIMPLE) {
+  if (!serializePattern(target, size, pattern, value, units)) snprintf(target, size, pattern, value, units);
 }
 
 static void getInfoValue(char* target, int size, char* value, const char* pattern = PATTERN_V_SIMPLE) {
-  snprintf(target, size, pattern, value);
+  if (!serializePattern(target, size, pattern, value)) snprintf(target, size, pattern, value);
 }
 
 /**** DATA INFO FUNCTIONS ****/
 // Note: whenever idx is negative, it is excluded from the printing
 
-static void getDataDoubleWithSigmaText(int idx, char* key, double value, double sigma, char* units, int n, unsigned long time_offset, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleWithSigmaText(int idx, const char* key, double value, double sigma, const char* units, int n, unsigned long time_offset, char* target, int size, const char* pattern, int decimals) {
   char value_text[20];
   print_to_decimals(value_text, sizeof(value_text), value, decimals);
   char sigma_text[20];
@@ -109,15 +186,15 @@ static void getDataDoubleWithSigmaText(int idx, char* key, double value, double
 
 }
 
-static void getDataDoubleWithSigmaText(int idx, char* key, double value, double sigma, char* units, int n, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleWithSigmaText(int idx, const char* key, double value, double sigma, const char* units, int n, char* target, int size, const char* pattern, int decimals) {
   getDataDoubleWithSigmaText(idx, key, value, sigma, units, n, -1, target, size, pattern, decimals);
 }
 
-static void getDataDoubleWithSigmaText(char* key, double value, double sigma, char* units, int n, char* target, int size, char* pattern, int decimals) {
+static void getDataDoubleWithSigmaText(const char* key, double value, double sigma, const char* units, int n, char* target, int size, char* pattern, int decimals) {
   getDataDoubleWithSigmaText(-1, key, value, sigma, units, n, -1, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(int idx, char* key, double value, char* units, int n, unsigned long time_offset, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleText(int idx, const char* key, double value, const char* units, int n, unsigned long time_offset, char* target, int size, const char* pattern, int decimals) {
   char value_text[20];
   print_to_decimals(value_text, sizeof(value_text), value, decimals);
   (idx >= 0) ?
@@ -125,38 +202,38 @@ static void getDataDoubleText(int idx, char* key, double value, char* units, int
     getInfoKeyValueUnitsNumberTimeOffset(target, size, key, value_text, units, n, time_offset, pattern);
 }
 
-static void getDataDoubleText(int idx, char* key, double value, char* units, int n, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleText(int idx, const char* key, double value, const char* units, int n, char* target, int size, const char* pattern, int decimals) {
   getDataDoubleText(idx, key, value, units, n, -1, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(int idx, char* key, double value, char* units, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleText(int idx, const char* key, double value, const char* units, char* target, int size, const char* pattern, int decimals) {
   getDataDoubleText(idx, key, value, units, -1, -1, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(int idx, char* key, double value, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleText(int idx, const char* key, double value, char* target, int size, const char* pattern, int decimals) {
   getDataDoubleText(idx, key, value, "", -1, -1, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(char* key, double value, char* units, int n, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleText(const char* key, double value, const char* units, int n, char* target, int size, const char* pattern, int decimals) {
   getDataDoubleText(-1, key, value, units, n, -1, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(char* key, double value, char* units, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleText(const char* key, double value, const char* units, char* target, int size, const char* pattern, int decimals) {
   getDataDoubleText(-1, key, value, units, -1, -1, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(char* key, double value, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleText(const char* key, double value, char* target, int size, const char* pattern, int decimals) {
   getDataDoubleText(-1, key, value, "", -1, -1, target, size, pattern, decimals);
 }
 
-static void getDataNullText(int idx, char* key, char* target, int size, const char* pattern) {
+static void getDataNullText(int idx, const char* key, char* target, int size, const char* pattern) {
   char value_text[] = "null";
   (idx >= 0) ?
     getInfoIdxKeyValue(target, size, idx, key, value_text, pattern) :
     getInfoKeyValue(target, size, key, value_text, pattern);
 }
 
-static void getDataNullText(char* key, char* target, int size, const char* pattern) {
+static void getDataNullText(const char* key, char* target, int size, const char* pattern) {
   getDataNullText(-1, key, target, size, pattern);
 }
 /**** STATE INFO FUNCTIONS ****/
@@ -198,3 +275,26 @@ static void getStateDoubleText(char* key, double value, char* units, char* targe
     getInfoKeyValueUnits(target, size, key, value_text, units, pattern) :
     getInfoValueUnits(target, size, value_text, units, pattern);
 }
+
+/**** helper functions for reading back logged JSON ****/
+// NOTE: only meant for the logger's own flat JSON (no nested objects in the searched range, no escaped quotes)
+
+// start of the value of "key": within [start, end), NULL if there is none
+static const char* findJsonValue(const char* start, const char* end, const char* key) {
+  size_t key_length = strlen(key);
+  for (const char* p = start; p + key_length + 3 <= end; p++) {
+    if (p[0] == '"' && strncmp(p + 1, key, key_length) == 0 && p[key_length + 1] == '"' && p[key_length + 2] == ':')
+      return(p + key_length + 3);
+  }
+  return(NULL);
+}
+
+// copy the string value starting at its opening quote into target, returns false if it is not a string or does not fit
+static bool copyJsonString(const char* value, const char* end, char* target, int size) {
+  if (value == NULL || value >= end || *value != '"') return(false);
+  const char* close = (const char*) memchr(value + 1, '"', end - value - 1);
+  if (close == NULL || close - value - 1 >= size) return(false);
+  memcpy(target, value + 1, close - value - 1);
+  target[close - value - 1] = 0;
+  return(true);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/**** Buffer writer ****/
+
+// appends text to a fixed-size buffer at a cursor so each append only copies the new text (instead of
+// rebuilding the whole buffer with snprintf(buffer, size, "%s,%s", buffer, text) which is quadratic and
+// passes the buffer as both source and target)
+// appends are all or nothing: text that does not fit is not written at all (the buffer always holds
+// complete elements and stays \0 terminated) and sets the overflow flag until the next reset
+struct LoggerWriter {
+
+    char* buffer;
+    size_t size; // including the terminating \0
+    size_t length; // cursor (= strlen(buffer))
+    bool overflow;
+
+    public:
+
+        LoggerWriter(char* buffer, size_t size) : buffer(buffer), size(size) {
+          reset();
+        }
+
+        void reset() {
+            length = 0;
+            buffer[0] = 0;
+            overflow = false;
+        }
+
+        bool empty() { return(length == 0); }
+
+        // go back to an earlier length (e.g. to start over after a common header), clears the overflow flag
+        void truncate(size_t n) {
+            if (n < length) {
+              length = n;
+              buffer[length] = 0;
+            }
+            overflow = false;
+        }
+
+        // characters (excluding \0) that still fit
+        size_t remaining() { return(size - 1 - length); }
+
+        bool fits(size_t n) { return(n <= remaining()); }
+
+        bool append(const char* text, size_t n) {
+            if (!fits(n)) {
+              overflow = true;
+              return(false);
+            }
+            memcpy(buffer + length, text, n);
+            length += n;
+            buffer[length] = 0;
+            return(true);
+        }
+
+        bool append(const char* text) {
+            return(append(text, strlen(text)));
+        }
+
+        bool append(char c) {
+            return(append(&c, 1));
+        }
+
+        // append a list element (with a separator if the buffer is not empty)
+        bool appendElement(const char* text, char separator = ',') {
+            size_t n = strlen(text);
+            if (length > 0 && !fits(n + 1)) {
+              overflow = true;
+              return(false);
+            }
+            if (length > 0) append(separator);
+            return(append(text, n));
+        }
+
+        bool appendf(const char* pattern, ...) {
+            va_list args;
+            va_start(args, pattern);
+            int n = vsnprintf(buffer + length, size - length, pattern, args);
+            va_end(args);
+            if (n < 0 || (size_t) n > remaining()) {
+              buffer[length] = 0; // drop the partial text
+              overflow = true;
+              return(false);
+            }
+            length += n;
+            return(true);
+        }
+
+};
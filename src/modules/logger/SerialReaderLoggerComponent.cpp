@@ -13,25 +13,43 @@ void SerialReaderLoggerComponent::init() {
     while (Serial1.available()) Serial1.read();
 }
 
+/*** loop ***/
+
+uint64_t SerialReaderLoggerComponent::getNextUpdate() {
+    // idle readers keep discarding left over bytes every loop until the line has been quiet for the min request delay
+    uint64_t next_update = DataReaderLoggerComponent::getNextUpdate();
+    if (next_update > 0 && (Serial1.available() || System.millis() < getRequestDelayEnd())) return(0);
+    return(next_update);
+}
+
 /*** read data ***/
 
+uint64_t SerialReaderLoggerComponent::getRequestDelayEnd() {
+    // same as isPastRequestDelay()
+    uint64_t end = data_received_last + min_request_delay + 1;
+    if (sequential && ctrl->sequential_data_idle_start + min_request_delay + 1 > end) end = ctrl->sequential_data_idle_start + min_request_delay + 1;
+    return(end);
+}
+
 bool SerialReaderLoggerComponent::isPastRequestDelay() {
     // check for min request delay
     return(
-        (millis() - data_received_last) > min_request_delay &&
+        (System.millis() - data_received_last) > min_request_delay &&
         // and if sequential reader that overall idle is at least the min request delay
-        (!sequential || (millis() - ctrl->sequential_data_idle_start) > min_request_delay)
+        (!sequential || (System.millis() - ctrl->sequential_data_idle_start) > min_request_delay)
     );
 }
 
 bool SerialReaderLoggerComponent::isTimeForRequest() {
+    // discard what came in while idle first (idle readers are not updated every loop, see getNextUpdate())
+    idleDataRead();
     // check for min request delay
     return(DataReaderLoggerComponent::isTimeForRequest() && isPastRequestDelay());
 }
 
 bool SerialReaderLoggerComponent::isTimedOut() {
     // whether the reader is timed out - by default if it's been longer than data_reading_period
-    return((millis() - data_received_last) > timeout);
+    return((System.millis() - data_received_last) > timeout);
 }
 
 void SerialReaderLoggerComponent::sendSerialDataRequest() {
@@ -54,11 +72,11 @@ void SerialReaderLoggerComponent::idleDataRead() {
           i++;
           (b >= SERIAL_B_C_START && b <= SERIAL_B_C_END) ?
             Serial.printlnf("SERIAL: IDLE byte #%d: %i (dec) = %x (hex) = '%c' (char)", i, (int) b, b, (char) b) :
-            Serial.printlnf("SERIAL: IDLE byte #%d: %i (dec) = %x (hex) = (special char)", i, (int) b, b, (char) b);
+            Serial.printlnf("SERIAL: IDLE byte #%d: %i (dec) = %x (hex) = (special char)", i, (int) b, b);
         }
       }
-      data_received_last = millis();
-      if (sequential) ctrl->sequential_data_idle_start = millis(); // reset idle start counter
+      data_received_last = System.millis();
+      if (sequential) ctrl->sequential_data_idle_start = System.millis(); // reset idle start counter
     }
 }
 
@@ -91,7 +109,7 @@ void SerialReaderLoggerComponent::readData() {
           }
 
       }
-      data_received_last = millis();
+      data_received_last = System.millis();
     }
 }
 
@@ -199,6 +217,7 @@ void SerialReaderLoggerComponent::resetSerialVariableBuffer() {
 void SerialReaderLoggerComponent::resetSerialValueBuffer() {
   for (int i=0; i < sizeof(value_buffer); i++) value_buffer[i] = 0;
   value_charcounter = 0;
+  value_parser.clear();
 }
 
 void SerialReaderLoggerComponent::resetSerialUnitsBuffer() {
@@ -239,6 +258,7 @@ void SerialReaderLoggerComponent::appendToSerialValueBuffer(byte b) {
   if (value_charcounter < sizeof(value_buffer) - 2) {
     value_buffer[value_charcounter] = (char) b;
     value_charcounter++;
+    value_parser.add((char) b);
   } else {
     Serial.println("ERROR: serial value buffer not big enough");
     registerDataReadError();
@@ -251,6 +271,7 @@ void SerialReaderLoggerComponent::setSerialValueBuffer(char* val) {
   strncpy(value_buffer, val, sizeof(value_buffer) - 1);
   value_buffer[sizeof(value_buffer)-1] = 0;
   value_charcounter = strlen(value_buffer);
+  for (int i=0; i < value_charcounter; i++) value_parser.add(value_buffer[i]);
 }
 
 void SerialReaderLoggerComponent::appendToSerialUnitsBuffer(byte b) {
@@ -50,6 +50,7 @@ class SerialReaderLoggerComponent : public DataReaderLoggerComponent
     int variable_charcounter;
     char value_buffer[50];
     int value_charcounter;
+    DecimalParser value_parser; // parses the value buffer as it is filled (see LoggerData::setNewestValue(DecimalParser&))
     char units_buffer[50];
     int units_charcounter;
 
@@ -65,7 +66,11 @@ class SerialReaderLoggerComponent : public DataReaderLoggerComponent
     /*** setup ***/
     virtual void init();
 
+    /*** loop ***/
+    virtual uint64_t getNextUpdate();
+
     /*** read data ***/
+    virtual uint64_t getRequestDelayEnd(); // when the min request delay is over (System.millis())
     virtual bool isPastRequestDelay();
     virtual bool isTimeForRequest();
     virtual bool isTimedOut();
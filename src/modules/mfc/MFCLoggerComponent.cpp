@@ -10,6 +10,13 @@ void MFCLoggerComponent::update() {
     }
 }
 
+uint64_t MFCLoggerComponent::getNextUpdate() {
+    // a pending MFC update only waits for the min request delay
+    uint64_t next_update = SerialReaderLoggerComponent::getNextUpdate();
+    if (update_mfc && next_update > getRequestDelayEnd()) next_update = getRequestDelayEnd();
+    return(next_update);
+}
+
 
 /*** state management ***/
 
@@ -117,7 +124,10 @@ bool MFCLoggerComponent::parseSetpoint(LoggerCommand *command) {
 bool MFCLoggerComponent::changeMFCID (char* mfc_id) {
   bool changed = strcmp(mfc_id, state->mfc_id) != 0;
 
-  if (changed) strncpy(state->mfc_id, mfc_id, sizeof(state->mfc_id) - 1); state->mfc_id[sizeof(state->mfc_id) - 1] = 0;
+  if (changed) {
+    strncpy(state->mfc_id, mfc_id, sizeof(state->mfc_id) - 1);
+    state->mfc_id[sizeof(state->mfc_id) - 1] = 0;
+  }
 
   if (changed) {
     Serial.printlnf("INFO: changing mfc ID to %s", state->mfc_id);
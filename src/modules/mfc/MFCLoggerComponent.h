@@ -98,6 +98,7 @@ class MFCLoggerComponent : public SerialReaderLoggerComponent
 
     /*** loop ***/
     virtual void update();
+    virtual uint64_t getNextUpdate();
 
     /*** state management ***/
     virtual size_t getStateSize();
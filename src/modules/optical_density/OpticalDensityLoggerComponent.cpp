@@ -175,7 +175,8 @@ void OpticalDensityLoggerComponent::changeZero() {
   state->sig_zero_dark.set(sig_zero_dark);
   state->sig_zero.set(sig_zero);
   state->ratio_zero.set(ratio_zero);
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(state->last_zero_datetime, sizeof(state->last_zero_datetime));
+  strncpy(state->last_zero_datetime, ctrl->getDateTime(), sizeof(state->last_zero_datetime) - 1);
+  state->last_zero_datetime[sizeof(state->last_zero_datetime) - 1] = 0;
   saveState();
   ctrl->updateStateVariable();
   ctrl->restartLastDataLog();
@@ -208,32 +209,32 @@ void OpticalDensityLoggerComponent::readData() {
 
     if (state->beam == BEAM_PAUSE) {
       // beam state PAUSED --> no reading, skip straight to complete
-      Serial.printlnf("WARNING at %lu: beam is paused, not reading data, turn to AUTO to resume data reading", millis());
+      Serial.printlnf("WARNING at %lu: beam is paused, not reading data, turn to AUTO to resume data reading", (unsigned long) millis());
       data_read_status = DATA_READ_COMPLETE;
     } else if (beam_read_status == BEAM_READ_IDLE) {
       // idle -> start data
       startData();
-      data_received_last = millis();
+      data_received_last = System.millis();
       // what is the state of the beam?
       if (maxing || state->beam == BEAM_ON) {
         // beam is ON (or maxxing during zero) --> read beam straight away
-        if (debug_component) Serial.printlnf("DEBUG at %lu: beam is permanently ON - starting beam read", millis());
+        if (debug_component) Serial.printlnf("DEBUG at %lu: beam is permanently ON - starting beam read", (unsigned long) millis());
         beam_read_status = BEAM_READ_BEAM;
       } else if (state->beam == BEAM_OFF) {
         // beam is OFF --> read dark
-        if (debug_component) Serial.printlnf("DEBUG at %lu: beam is permanently OFF - starting dark read", millis());
+        if (debug_component) Serial.printlnf("DEBUG at %lu: beam is permanently OFF - starting dark read", (unsigned long) millis());
         beam_read_status = BEAM_READ_DARK;
       } else if (state->beam == BEAM_AUTO && (state->is_zeroed || zeroing)) {
         // beam is on AUTO --> start OD read sequence
         // stop stirrer if it's on
         if (stirrer && stirrer->state->status == STATUS_ON) {
-          if (debug_component) Serial.printlnf("DEBUG at %lu: turning stirrer off", millis());
+          if (debug_component) Serial.printlnf("DEBUG at %lu: turning stirrer off", (unsigned long) millis());
           stirrer->stepper.setSpeed(0); // stepper off
           stirrer->stepper.disableOutputs();
           stirrer_temp_off = true;
         }
         // start dark wait (cooldown)
-        if (debug_component) Serial.printlnf("DEBUG at %lu: beam is on AUTO - starting dark wait (cooldown)", millis());
+        if (debug_component) Serial.printlnf("DEBUG at %lu: beam is on AUTO - starting dark wait (cooldown)", (unsigned long) millis());
         updateBeam(BEAM_OFF);
         beam_read_status = BEAM_READ_WAIT_DARK;
       } else {
@@ -242,45 +243,45 @@ void OpticalDensityLoggerComponent::readData() {
       }
     } else if (beam_read_status == BEAM_READ_WAIT_DARK) {
       // wait for potential beam cooldown to finish
-      if ((millis() - data_received_last) > state->warmup) {
-        if (debug_component) Serial.printlnf("DEBUG at %lu: finished cooldown, starting dark read", millis());
+      if ((System.millis() - data_received_last) > state->warmup) {
+        if (debug_component) Serial.printlnf("DEBUG at %lu: finished cooldown, starting dark read", (unsigned long) millis());
         beam_read_status = BEAM_READ_DARK;
-        data_received_last = millis();
+        data_received_last = System.millis();
       }
     } else if (beam_read_status == BEAM_READ_DARK) {
       // dark read --> read or if down move on
-      if ((millis() - data_received_last) > state->read_length) {
+      if ((System.millis() - data_received_last) > state->read_length) {
         if (state->beam == BEAM_OFF) {
           // beam OFF --> wrap up the read
-          if (debug_component) Serial.printlnf("DEBUG at %lu: finished dark read with beam permanently OFF", millis());
+          if (debug_component) Serial.printlnf("DEBUG at %lu: finished dark read with beam permanently OFF", (unsigned long) millis());
           data_read_status = DATA_READ_COMPLETE;
           beam_read_status = BEAM_READ_IDLE;
         } else if (state->beam == BEAM_AUTO) {
           // beam is on AUTO --> move on to warmp
-          if (debug_component) Serial.printlnf("DEBUG at %lu: finished dark read , turning beam on for warmup", millis());
+          if (debug_component) Serial.printlnf("DEBUG at %lu: finished dark read , turning beam on for warmup", (unsigned long) millis());
           updateBeam(BEAM_ON);
           beam_read_status = BEAM_READ_WAIT_BEAM;
-          data_received_last = millis();
+          data_received_last = System.millis();
         }
       } else {
         collectDarkData();
       }
     } else if (beam_read_status == BEAM_READ_WAIT_BEAM) {
       // wait for beam warmup to finish
-      if ((millis() - data_received_last) > state->warmup) {
-        if (debug_component) Serial.printlnf("DEBUG at %lu: finished warmup, starting signal read", millis());
+      if ((System.millis() - data_received_last) > state->warmup) {
+        if (debug_component) Serial.printlnf("DEBUG at %lu: finished warmup, starting signal read", (unsigned long) millis());
         beam_read_status = BEAM_READ_BEAM;
-        data_received_last = millis();
+        data_received_last = System.millis();
       }
     } else if (beam_read_status == BEAM_READ_BEAM) {
       // read signal
-      if ((millis() - data_received_last) > state->read_length) {
-        if (debug_component) Serial.printlnf("DEBUG at %lu: finished beam read", millis());
+      if ((System.millis() - data_received_last) > state->read_length) {
+        if (debug_component) Serial.printlnf("DEBUG at %lu: finished beam read", (unsigned long) millis());
         if (!maxing && state->beam == BEAM_AUTO) {
           // in AUTO mode -> update beam and stirrer
           updateBeam(BEAM_OFF); 
           if (stirrer && stirrer_temp_off && (!zeroing || zero_read_counter + 1 > zero_read_n)) {
-            if (debug_component) Serial.printlnf("DEBUG at %lu: turning stirrer back on", millis());
+            if (debug_component) Serial.printlnf("DEBUG at %lu: turning stirrer back on", (unsigned long) millis());
             stirrer->stepper.enableOutputs();
             stirrer->stepper.setSpeed(stirrer->calculateSpeed()); // stepper back on
             stirrer_temp_off = false;
@@ -304,7 +305,7 @@ void OpticalDensityLoggerComponent::startData() {
   sig_beam.clear();
   // process zeroing
   if (zeroing) {
-    if (zero_read_counter == 1) Serial.printlnf("INFO: %lu - starting zeroing", millis());
+    if (zero_read_counter == 1) Serial.printlnf("INFO: %lu - starting zeroing", (unsigned long) millis());
     ctrl->lcd->resetBuffer();
     snprintf(ctrl->lcd->buffer, sizeof(ctrl->lcd->buffer), "zero read #%d", zero_read_counter);
     ctrl->lcd->printLineTempFromBuffer(2);
@@ -357,7 +358,7 @@ void OpticalDensityLoggerComponent::finishData() {
       zero_read_counter++;
       if (zero_read_counter > zero_read_n) {
         zeroing = false;
-        Serial.printlnf("INFO: %lu - finished zeroing", millis());
+        Serial.printlnf("INFO: %lu - finished zeroing", (unsigned long) millis());
         if (debug_component) {
           Serial.printlnf(
             "REF BEAM: %4.0f +/- %4.0f (%d)\nREF DARK: %4.0f +/- %4.0f (%d)\nSIG BEAM: %4.0f +/- %4.0f (%d)\nSIG DARK: %4.0f +/- %4.0f (%d)\nRATIO: %4.4f +/- %4.4f (%d)", 
@@ -117,9 +117,9 @@ void ScaleLoggerComponent::calculateRate() {
   } else {
     // set rate units text
     char rate_units[10];
-    strncpy(rate_units, data[0].units, sizeof(rate_units) - 1);
-    strcpy(rate_units + strlen(data[0].units), "/");
-    getStateCalcRateText(state->calc_rate, rate_units + strlen(data[0].units) + 1, sizeof(rate_units), true);
+    strncpy(rate_units, data[0].getUnits(), sizeof(rate_units) - 1);
+    strcpy(rate_units + strlen(data[0].getUnits()), "/");
+    getStateCalcRateText(state->calc_rate, rate_units + strlen(data[0].getUnits()) + 1, sizeof(rate_units), true);
     rate_units[sizeof(rate_units) - 1] = 0; // safety
     data[1].setUnits(rate_units);
     
@@ -133,7 +133,7 @@ void ScaleLoggerComponent::calculateRate() {
     data[1].setNewestValue(rate);
 
     // calculate mean data time
-    unsigned long data_time = (unsigned long) round( 0.5 * (double) prev_data_time1 + 0.5 * (double) prev_data_time2 );
+    uint64_t data_time = (uint64_t) round( 0.5 * (double) prev_data_time1 + 0.5 * (double) prev_data_time2 );
     data[1].setNewestDataTime(data_time);
     data[1].saveNewestValue(false);
 
@@ -152,7 +152,7 @@ void ScaleLoggerComponent::calculateRate() {
 void ScaleLoggerComponent::finishData() {
     // weight
     if (error_counter == 0) {
-        data[0].setNewestValue(value_buffer, true, 2L); // infer decimals and add 2 to improve accuracy of offline calculated rate
+        data[0].setNewestValue(value_parser, true, 2L); // infer decimals and add 2 to improve accuracy of offline calculated rate
         data[0].saveNewestValue(true); // average
     }
 }
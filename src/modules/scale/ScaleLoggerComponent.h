@@ -64,8 +64,8 @@ class ScaleLoggerComponent : public SerialReaderLoggerComponent
     // weight memory for rate calculation
     RunningStats prev_weight1;
     RunningStats prev_weight2;
-    unsigned long prev_data_time1;
-    unsigned long prev_data_time2;
+    uint64_t prev_data_time1;
+    uint64_t prev_data_time2;
 
   public:
 
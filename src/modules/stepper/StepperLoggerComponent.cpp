@@ -8,11 +8,18 @@ void StepperLoggerComponent::debug() {
 
 /*** setup ***/
 
+void StepperLoggerComponent::timeWeightSpeed(bool log_changes) {
+    time_weighted_speed = true;
+    log_speed_changes = log_changes;
+    if (data.size() > 0) data[0].enableTimeWeighting(); // data vector already set up
+}
+
 uint8_t StepperLoggerComponent::setupDataVector(uint8_t start_idx) { 
     // same index to allow for step transition logging
     // idx, key, units, digits
     data.push_back(LoggerData(1, "speed", "rpm", 1));
     data.push_back(LoggerData(1, "speed", "rpm", 1));
+    if (time_weighted_speed) data[0].enableTimeWeighting();
     return(start_idx + 1); 
 }
 
@@ -307,7 +314,7 @@ bool StepperLoggerComponent::changeSpeedRpm(float rpm) {
   state->ms_index = findMicrostepIndexForRpm(rpm);
   state->ms_mode = driver->getMode(state->ms_index); // tracked for convenience
   setSpeedWithSteppingLimit(rpm);
-  bool changed = state->ms_mode != original_ms_mode | fabs(state->rpm - original_rpm) > 0.0001;
+  bool changed = state->ms_mode != original_ms_mode || fabs(state->rpm - original_rpm) > 0.0001;
 
   (changed) ?
     Serial.printf("INFO: changing %s speed to %.3f rpm\n", id, state->rpm) :
@@ -399,6 +406,24 @@ void StepperLoggerComponent::updateStepper() {
     new_rpm = 0.0;
   }
 
+  // time weighted speed: count the previous speed up to now and continue with the new one (no step transition needed)
+  if (time_weighted_speed) {
+    if (!data[0].newest_value_valid || fabs(new_rpm - data[0].newest_value) > 0.0001) {
+      data[0].setNewestDataTime(System.millis());
+      data[0].setNewestValue(new_rpm);
+      data[0].saveNewestValue(false);
+      if (log_speed_changes) {
+        if (debug_mode) {
+          Serial.printf("DEBUG: logging time weighted speed up to the shift to %.4frpm\n", new_rpm);
+        }
+        logData();
+        data[0].clear();
+      }
+      ctrl->updateDataVariable();
+    }
+    return;
+  }
+
   // make change if data (=rpm) not yet set or rpm has changed
   if (!data[0].newest_value_valid || fabs(new_rpm - data[0].getValue()) > 0.0001) {
    
@@ -407,7 +432,7 @@ void StepperLoggerComponent::updateStepper() {
         if (debug_mode) {
             Serial.printf("DEBUG: logging speed shift from %.4f to %.4frpm\n", data[0].getValue(), new_rpm);
         }
-        data[1].setNewestDataTime(millis() - 1); // old value logged 1 ms before new value
+        data[1].setNewestDataTime(System.millis() - 1); // old value logged 1 ms before new value
         data[1].setNewestValue(data[0].getValue());
         data[1].saveNewestValue(false); // no averaging
     } 
@@ -479,7 +504,7 @@ void StepperLoggerComponent::assembleStateVariable() {
 
 void StepperLoggerComponent::logData() {
   // always log data[0] with latest current time
-  data[0].setNewestDataTime(millis());
+  data[0].setNewestDataTime(System.millis());
   data[0].saveNewestValue(false);
   ControllerLoggerComponent::logData();
 }
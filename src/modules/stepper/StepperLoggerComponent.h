@@ -45,6 +45,10 @@ class StepperLoggerComponent : public ControllerLoggerComponent {
     // startup
     bool startup_rpm_logged = false;
 
+    // speed logging (see timeWeightSpeed())
+    bool time_weighted_speed = false;
+    bool log_speed_changes = true;
+
     // debug
     bool debug_mode = false;
 
@@ -64,6 +68,9 @@ class StepperLoggerComponent : public ControllerLoggerComponent {
     void debug();
 
     /*** setup ***/
+    // average the speed over each log period weighted by how long each speed lasted instead of logging every change
+    // (log_changes = true to still log each change right away)
+    void timeWeightSpeed(bool log_changes = false);
     uint8_t setupDataVector(uint8_t start_idx);
     virtual void init();
     virtual void completeStartup();
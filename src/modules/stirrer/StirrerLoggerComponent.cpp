@@ -11,12 +11,26 @@ void StirrerLoggerComponent::update() {
     }
 }
 
+uint64_t StirrerLoggerComponent::getNextUpdate() {
+    // a pending stirrer update only waits for the min request delay
+    uint64_t next_update = SerialReaderLoggerComponent::getNextUpdate();
+    if (update_stirrer && next_update > getRequestDelayEnd()) next_update = getRequestDelayEnd();
+    return(next_update);
+}
+
 /*** setup ***/
 
+void StirrerLoggerComponent::timeWeightSpeed(bool log_changes) {
+    time_weighted_speed = true;
+    log_speed_changes = log_changes;
+    if (data.size() > 0) data[0].enableTimeWeighting(); // data vector already set up
+}
+
 uint8_t StirrerLoggerComponent::setupDataVector(uint8_t start_idx) { 
     // idx, key, units, digits
     data.push_back(LoggerData(1, "speed", "rpm", 1));
     data.push_back(LoggerData(1, "speed", "rpm", 1));
+    if (time_weighted_speed) data[0].enableTimeWeighting();
     return(start_idx + data.size());
 }
 
@@ -197,11 +211,23 @@ void StirrerLoggerComponent::logChange(int status_current, float rpm_current, in
     if (status_current == STIRRER_STATUS_OFF) rpm_current = 0.0;
     if (status_change == STIRRER_STATUS_OFF) rpm_change = 0.0;
 
+    // time weighted speed: count the current speed up to now and continue with the new one (no step transition needed)
+    if (time_weighted_speed) {
+        data[0].setNewestDataTime(System.millis());
+        data[0].setNewestValue(rpm_change);
+        data[0].saveNewestValue(false);
+        if (log_speed_changes) {
+            logData();
+            data[0].clear();
+        }
+        return;
+    }
+
     // recording change
-    data[1].setNewestDataTime(millis() - 1);
+    data[1].setNewestDataTime(System.millis() - 1);
     data[1].setNewestValue(rpm_current);
     data[1].saveNewestValue(false);
-    data[0].setNewestDataTime(millis());
+    data[0].setNewestDataTime(System.millis());
     data[0].setNewestValue(rpm_change);
     data[0].saveNewestValue(false);
     
@@ -215,7 +241,7 @@ void StirrerLoggerComponent::logCurrent(int status_current, float rpm_current) {
     if (status_current == STIRRER_STATUS_OFF) rpm_current = 0.0;
     
     // recording current
-    data[0].setNewestDataTime(millis());
+    data[0].setNewestDataTime(System.millis());
     data[0].setNewestValue(rpm_current);
     data[0].saveNewestValue(false);
 
@@ -228,13 +254,14 @@ void StirrerLoggerComponent::logCurrent(int status_current, float rpm_current) {
 void StirrerLoggerComponent::finishData() {
     // rpm
     if (error_counter == 0) {
-        data[0].setNewestValue(value_buffer);
+        data[0].setNewestValue(value_parser);
         data[0].saveNewestValue(false); // don't average
-        // see if anything changed
-        if (fabs(state->rpm - data[0].getValue()) > rpm_change_threshold) {
+        // see if anything changed (time weighted speed: the value is the average, compare the newest)
+        double rpm = (time_weighted_speed) ? data[0].newest_value : data[0].getValue();
+        if (fabs(state->rpm - rpm) > rpm_change_threshold) {
             if (state->status == STIRRER_STATUS_MANUAL) {
                 // update speed
-                changeSpeed(data[0].getValue(), false);
+                changeSpeed(rpm, false);
             } else {
                 // reset back to what is set (not in manual mode)
                 changeSpeed(state->rpm, true);
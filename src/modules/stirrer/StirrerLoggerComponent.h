@@ -80,6 +80,10 @@ class StirrerLoggerComponent : public SerialReaderLoggerComponent
 
     bool update_stirrer = true; // flag for stirrer update as soon as serial is IDLE
 
+    // speed logging (see timeWeightSpeed())
+    bool time_weighted_speed = false;
+    bool log_speed_changes = true;
+
   public:
 
     // state
@@ -102,8 +106,12 @@ class StirrerLoggerComponent : public SerialReaderLoggerComponent
 
     /*** loop ***/
     virtual void update();
+    virtual uint64_t getNextUpdate();
 
     /*** setup ***/
+    // average the speed over each log period weighted by how long each speed lasted instead of logging every change
+    // (log_changes = true to still log each change right away)
+    void timeWeightSpeed(bool log_changes = false);
     virtual uint8_t setupDataVector(uint8_t start_idx);
     virtual void completeStartup();
 